@@ -1,111 +1,128 @@
 #include "ActionSystem.hpp"
+#include <algorithm>
 #include <print>
-#include <format>
 
 using namespace FindTheBug;
 
-int ActionSystem::calculateCost(
-    ActionType actionType,
-    const std::string& targetId,
-    const GameState& currentState
-) const {
-    switch (actionType) {
-    case ActionType::ReadDocumentation:
-    case ActionType::InsertLog:
-        return 1;
-
-    case ActionType::RunUnitTests:
-        return 2;
-
-    case ActionType::RunIntegrationTests:
-        return 3;
-
-    case ActionType::InvestigateFunction:
-        if (currentState.breakpointedTargets.contains(targetId)) return 1;
-        return 2;
-
-    case ActionType::SetBreakpoint:
-        if (currentState.investigatedTargets.contains(targetId)) return 1;
-        return 2;
+CompiledRules ActionSystem::compileRules(const BugCase& bugCase) {
+    CompiledRules rules;
+
+    auto setCost = [&rules](ActionType actionType, int cost, int discountedCost, CostDiscount when) {
+        size_t a = static_cast<size_t>(actionType);
+        rules.baseCost[a] = cost;
+        rules.discountedCost[a] = discountedCost;
+        rules.discountWhen[a] = when;
+    };
+
+    setCost(ActionType::ReadDocumentation, 1, 1, CostDiscount::None);
+    setCost(ActionType::InsertLog, 1, 1, CostDiscount::None);
+    setCost(ActionType::InvestigateFunction, 2, 1, CostDiscount::WhenBreakpointed);
+    setCost(ActionType::SetBreakpoint, 2, 1, CostDiscount::WhenInvestigated);
+    setCost(ActionType::RunUnitTests, 2, 2, CostDiscount::None);
+    setCost(ActionType::RunIntegrationTests, 3, 3, CostDiscount::None);
+    setCost(ActionType::SubmitSolution, 0, 0, CostDiscount::None);
+    setCost(ActionType::SkipTurn, 0, 0, CostDiscount::None);
+
+    rules.clueType.fill(-1);
+    rules.clueType[static_cast<size_t>(ActionType::ReadDocumentation)] = static_cast<int8_t>(ClueType::Documentation);
+    rules.clueType[static_cast<size_t>(ActionType::InsertLog)] = static_cast<int8_t>(ClueType::Log);
+    rules.clueType[static_cast<size_t>(ActionType::InvestigateFunction)] = static_cast<int8_t>(ClueType::Code);
+    rules.clueType[static_cast<size_t>(ActionType::SetBreakpoint)] = static_cast<int8_t>(ClueType::Breakpoint);
+    rules.clueType[static_cast<size_t>(ActionType::RunUnitTests)] = static_cast<int8_t>(ClueType::UnitTestResult);
+    rules.clueType[static_cast<size_t>(ActionType::RunIntegrationTests)] = static_cast<int8_t>(ClueType::IntegrationTestResult);
+
+    const auto& source = bugCase.rules;
+
+    for (const auto& rule : source.actionCosts) {
+        if (!rule.action || !rule.cost) {
+            std::println(stderr, "[ActionSystem] Regra de custo ignorada no caso {}: faltam action ou cost.", bugCase.id);
+            continue;
+        }
+        if (static_cast<size_t>(*rule.action) >= kActionTypeCount) {
+            std::println(stderr, "[ActionSystem] Regra de custo ignorada no caso {}: acao invalida.", bugCase.id);
+            continue;
+        }
+        int cost = std::max(0, *rule.cost);
+        int discounted = rule.discountedCost < 0 ? cost : std::min(rule.discountedCost, cost);
+        setCost(*rule.action, cost, discounted, rule.discountWhen);
+    }
 
-    case ActionType::SubmitSolution:
-    case ActionType::SkipTurn:
-        return 0;
+    rules.pointsPerDay = std::max(1, source.pointsPerDay);
+    rules.dayLimit = std::max(1, source.dayLimit);
+    rules.clueRevealBonus = std::chrono::seconds(std::max(0, source.clueRevealBonusSeconds));
+    rules.rejectionPenaltyDays = std::max(0, source.rejectionPenaltyDays);
 
-    default:
-        std::println(stderr, "[ActionSystem] Unknown action type for cost calculation.");
-        return 0;
+    rules.clueIndex.reserve(bugCase.availableClues.size());
+    for (uint32_t i = 0; i < bugCase.availableClues.size(); ++i) {
+        const auto& clue = bugCase.availableClues[i];
+        rules.clueIndex.emplace(CompiledRules::clueKey(clue.targetId, clue.type), i);
     }
+
+    return rules;
 }
 
-std::optional<Clue> ActionSystem::findClueInCase(
-    const BugCase& bugCase,
+const Clue* ActionSystem::findClueInCase(
+    const CompiledCase& bugCase,
     const std::string& targetId,
-    ClueType type
+    ActionType actionType
 ) const {
-    for (const auto& clue : bugCase.availableClues) {
-        if (clue.targetId == targetId && clue.type == type) {
-            return clue;
-        }
-    }
-    return std::nullopt;
+    int8_t type = bugCase.rules.clueType[static_cast<size_t>(actionType)];
+    if (type < 0) return nullptr;
+
+    auto it = bugCase.rules.clueIndex.find(CompiledRules::clueKey(targetId, static_cast<ClueType>(type)));
+    if (it == bugCase.rules.clueIndex.end()) return nullptr;
+    return &bugCase.data.availableClues[it->second];
 }
 
-ActionResult ActionSystem::execute(
+std::optional<ActionUpdate> ActionSystem::plan(
+    const std::string& sessionId,
+    const std::string& playerId,
     ActionType actionType,
     const std::string& targetId,
-    const BugCase& bugCase,
-    const GameState& currentState) const {
-
-    ActionResult result{ .success = false, .pointsSpent = 0 };
-
-    int cost = calculateCost(actionType, targetId, currentState);
-
-    if (currentState.remainingPoints < cost) {
-        result.message = std::format("Pontos insuficientes. Necessario: {}, Disponivel: {}", cost, currentState.remainingPoints);
-        return result;
+    const CompiledCase& bugCase) const {
+
+    size_t a = static_cast<size_t>(actionType);
+    if (a >= kActionTypeCount) return std::nullopt;
+    if (actionType != ActionType::SubmitSolution && bugCase.rules.clueType[a] < 0) return std::nullopt;
+
+    const auto& rules = bugCase.rules;
+    const Clue* clue = findClueInCase(bugCase, targetId, actionType);
+
+    // O custo definido na pista substitui o custo base da acao; o desconto continua valendo.
+    int base = (clue && clue->cost > 0) ? clue->cost : rules.baseCost[a];
+    int reduction = rules.baseCost[a] - rules.discountedCost[a];
+
+    ActionUpdate update{
+        .sessionId = sessionId,
+        .playerId = playerId,
+        .actionType = actionType,
+        .targetId = targetId,
+        .requiresTurn = actionType != ActionType::SubmitSolution,
+        .cost = base,
+        .discountedCost = std::max(0, base - reduction),
+        .discountWhen = rules.discountWhen[a],
+        .now = std::chrono::system_clock::now(),
+        .clueRevealBonus = rules.clueRevealBonus,
+        .pointsPerDay = rules.pointsPerDay,
+        .dayLimit = rules.dayLimit
+    };
+
+    if (clue) {
+        update.clue = DiscoveredClue{
+            .id = clue->id,
+            .targetId = clue->targetId,
+            .type = clue->type,
+            .targetType = clue->targetType,
+            .content = clue->content,
+            .discoveredBy = playerId
+        };
     }
 
-    if (actionType == ActionType::SubmitSolution) {
-        result.success = true;
-        result.pointsSpent = 0;
-        result.message = "Solucao enviada para analise.";
-        return result;
-    }
-    
-    if (actionType == ActionType::SubmitSolution) {
-        result.success = true;
-        result.pointsSpent = 0;
-        result.message = "O jogador decidiu passar a vez.";
-        return result;
-    }
-
-    ClueType expectedClueType;
-    switch (actionType) {
-    case ActionType::ReadDocumentation:   expectedClueType = ClueType::Documentation; break;
-    case ActionType::InsertLog:           expectedClueType = ClueType::Log; break;
-    case ActionType::InvestigateFunction: expectedClueType = ClueType::Code; break;
-    case ActionType::SetBreakpoint:       expectedClueType = ClueType::Breakpoint; break;
-    case ActionType::RunUnitTests:        expectedClueType = ClueType::UnitTestResult; break;
-    case ActionType::RunIntegrationTests: expectedClueType = ClueType::IntegrationTestResult; break;
-    default:
-        result.message = "Tipo de acao nao suportado.";
-        return result;
-    }
-
-    auto clue = findClueInCase(bugCase, targetId, expectedClueType);
-
-    if (!clue) {
-        result.success = true;
-        result.pointsSpent = cost;
-        result.message = "A analise nao revelou comportamentos anomalos neste alvo.";
-        return result;
-    }
-
-    result.success = true;
-    result.pointsSpent = cost;
-    result.unlockedClue = clue;
-    result.message = "Analise bem-sucedida! Uma nova pista foi descoberta.";
+    return update;
+}
 
-    return result;
-}
\ No newline at end of file
+std::string ActionSystem::successMessage(const ActionUpdate& update) {
+    if (update.actionType == ActionType::SubmitSolution) return "Solucao enviada para analise.";
+    if (update.clue) return "Analise bem-sucedida! Uma nova pista foi descoberta.";
+    return "A analise nao revelou comportamentos anomalos neste alvo.";
+}
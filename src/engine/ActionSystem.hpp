@@ -1,7 +1,8 @@
 #pragma once
 
-#include <string>
 #include <optional>
+#include <string>
+#include "../storage/ActionUpdate.hpp"
 #include "Types.hpp"
 #include "../shared/DTOs.hpp"
 
@@ -9,24 +10,25 @@ namespace FindTheBug {
 
     class ActionSystem {
     public:
-        int calculateCost(
-            ActionType actionType,
-            const std::string& targetId,
-            const GameState& currentState
-        ) const;
+        static CompiledRules compileRules(const BugCase& bugCase);
 
-        ActionResult execute(
+        // Resolve a acao contra o caso: custos, pista revelada e regras do dia.
+        // nullopt quando o tipo de acao nao e suportado. O estado da sessao nao e consultado.
+        std::optional<ActionUpdate> plan(
+            const std::string& sessionId,
+            const std::string& playerId,
             ActionType actionType,
             const std::string& targetId,
-            const BugCase& bugCase,
-            const GameState& currentState
+            const CompiledCase& bugCase
         ) const;
 
+        static std::string successMessage(const ActionUpdate& update);
+
     private:
-        std::optional<Clue> findClueInCase(
-            const BugCase& bugCase,
+        const Clue* findClueInCase(
+            const CompiledCase& bugCase,
             const std::string& targetId,
-            ClueType type
+            ActionType actionType
         ) const;
     };
-}
\ No newline at end of file
+}
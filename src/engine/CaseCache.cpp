@@ -0,0 +1,55 @@
+#include "CaseCache.hpp"
+#include "ActionSystem.hpp"
+#include "ValidationSystem.hpp"
+
+#include <mutex>
+
+using namespace FindTheBug;
+
+static InvestigationCoverage countCoverageTotals(const BugCase& bugCase) {
+    InvestigationCoverage totals;
+    totals.targets[static_cast<size_t>(TargetType::Module)] = static_cast<int>(bugCase.systemTopology.modules.size());
+    totals.targets[static_cast<size_t>(TargetType::Function)] = static_cast<int>(bugCase.systemTopology.functions.size());
+    totals.targets[static_cast<size_t>(TargetType::Connection)] = static_cast<int>(bugCase.systemTopology.connections.size());
+
+    for (const auto& clue : bugCase.availableClues) {
+        auto type = static_cast<size_t>(clue.type);
+        if (type < kClueTypeCount) totals.clues[type]++;
+    }
+    return totals;
+}
+
+CaseCache::CaseCache(std::shared_ptr<GameStore> storage)
+    : storage(std::move(storage)) {
+}
+
+std::shared_ptr<const CompiledCase> CaseCache::get(const std::string& caseId) {
+    {
+        std::shared_lock lock(mutex);
+        auto it = cases.find(caseId);
+        if (it != cases.end()) return it->second;
+    }
+
+    auto bugCase = storage->getCase(caseId);
+    if (!bugCase) return nullptr;
+
+    auto compiled = std::make_shared<CompiledCase>();
+    compiled->rules = ActionSystem::compileRules(*bugCase);
+    compiled->answerMatchers = ValidationSystem::compileAnswerMatchers(*bugCase);
+    compiled->coverageTotals = countCoverageTotals(*bugCase);
+    compiled->data = std::move(*bugCase);
+
+    std::unique_lock lock(mutex);
+    auto [it, inserted] = cases.emplace(caseId, std::move(compiled));
+    return it->second;
+}
+
+void CaseCache::invalidate(const std::string& caseId) {
+    std::unique_lock lock(mutex);
+    cases.erase(caseId);
+}
+
+void CaseCache::clear() {
+    std::unique_lock lock(mutex);
+    cases.clear();
+}
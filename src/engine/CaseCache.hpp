@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "../storage/GameStore.hpp"
+#include "Types.hpp"
+
+namespace FindTheBug {
+
+    // Casos carregados e compilados uma unica vez, compartilhados entre sessoes.
+    class CaseCache {
+    public:
+        explicit CaseCache(std::shared_ptr<GameStore> storage);
+
+        std::shared_ptr<const CompiledCase> get(const std::string& caseId);
+        void invalidate(const std::string& caseId);
+        void clear();
+
+    private:
+        std::shared_ptr<GameStore> storage;
+
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<const CompiledCase>> cases;
+    };
+}
@@ -0,0 +1,199 @@
+#include "FuzzyMatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace FindTheBug;
+
+namespace {
+
+    // Igualdade de padrao (Peq) por bloco de 64 linhas. Reaproveitada por thread para evitar alocacoes.
+    struct PatternTable {
+        std::vector<uint64_t> peq;
+        size_t blocks{ 0 };
+
+        void build(std::string_view pattern) {
+            blocks = (pattern.size() + 63) / 64;
+            peq.assign(blocks * 256, 0);
+            for (size_t i = 0; i < pattern.size(); ++i) {
+                auto c = static_cast<unsigned char>(pattern[i]);
+                peq[(i / 64) * 256 + c] |= 1ULL << (i % 64);
+            }
+        }
+
+        uint64_t eq(size_t block, unsigned char c) const { return peq[block * 256 + c]; }
+    };
+
+    size_t singleBlockDistance(std::string_view pattern, std::string_view text) {
+        // Tabela zerada uma vez por thread; apenas as entradas do padrao sao limpas ao final.
+        thread_local std::array<uint64_t, 256> peq{};
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            peq[static_cast<unsigned char>(pattern[i])] |= 1ULL << i;
+        }
+
+        const uint64_t last = 1ULL << (pattern.size() - 1);
+        uint64_t pv = ~0ULL;
+        uint64_t mv = 0;
+        size_t score = pattern.size();
+
+        for (char ch : text) {
+            uint64_t eq = peq[static_cast<unsigned char>(ch)];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            if (ph & last) score++;
+            else if (mh & last) score--;
+
+            // Linha 0 da matriz cresce 1 por coluna (distancia global).
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+
+        for (char ch : pattern) peq[static_cast<unsigned char>(ch)] = 0;
+        return score;
+    }
+
+    size_t multiBlockDistance(std::string_view pattern, std::string_view text) {
+        thread_local PatternTable table;
+        table.build(pattern);
+
+        const size_t blocks = table.blocks;
+        const uint64_t last = 1ULL << ((pattern.size() - 1) % 64);
+
+        thread_local std::vector<uint64_t> pvs;
+        thread_local std::vector<uint64_t> mvs;
+        pvs.assign(blocks, ~0ULL);
+        mvs.assign(blocks, 0);
+
+        size_t score = pattern.size();
+
+        for (char ch : text) {
+            auto c = static_cast<unsigned char>(ch);
+            int hin = 1;
+
+            for (size_t b = 0; b < blocks; ++b) {
+                uint64_t pv = pvs[b];
+                uint64_t mv = mvs[b];
+                uint64_t eq = table.eq(b, c);
+
+                uint64_t xv = eq | mv;
+                if (hin < 0) eq |= 1;
+                uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+
+                uint64_t high = (b + 1 == blocks) ? last : (1ULL << 63);
+                int hout = (ph & high) ? 1 : ((mh & high) ? -1 : 0);
+
+                ph <<= 1;
+                mh <<= 1;
+                if (hin < 0) mh |= 1;
+                else if (hin > 0) ph |= 1;
+
+                pvs[b] = mh | ~(xv | ph);
+                mvs[b] = ph & xv;
+                hin = hout;
+            }
+
+            score = static_cast<size_t>(static_cast<long long>(score) + hin);
+        }
+        return score;
+    }
+
+    bool isTokenChar(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+    }
+
+    void tokenize(std::string_view s, std::vector<std::string_view>& out) {
+        size_t i = 0;
+        while (i < s.size()) {
+            while (i < s.size() && !isTokenChar(static_cast<unsigned char>(s[i]))) ++i;
+            size_t start = i;
+            while (i < s.size() && isTokenChar(static_cast<unsigned char>(s[i]))) ++i;
+            if (i > start) out.push_back(s.substr(start, i - start));
+        }
+    }
+
+    // Media ponderada (pelo tamanho) da melhor similaridade de cada token de 'from' contra 'to'.
+    double softCoverage(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) {
+        constexpr double kTokenThreshold = 0.75;
+
+        if (from.empty()) return to.empty() ? 1.0 : 0.0;
+
+        double total = 0.0;
+        double weight = 0.0;
+        for (auto a : from) {
+            double best = 0.0;
+            for (auto b : to) {
+                // A diferenca de tamanho limita a similaridade por cima; evita calcular a distancia.
+                size_t longest = std::max(a.size(), b.size());
+                size_t gap = a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+                double bound = 1.0 - static_cast<double>(gap) / static_cast<double>(longest);
+                if (bound < kTokenThreshold || bound <= best) continue;
+
+                best = std::max(best, FuzzyMatcher::similarity(a, b));
+                if (best == 1.0) break;
+            }
+            double w = static_cast<double>(a.size());
+            total += (best >= kTokenThreshold ? best : 0.0) * w;
+            weight += w;
+        }
+        return weight > 0.0 ? total / weight : 0.0;
+    }
+}
+
+size_t FuzzyMatcher::editDistance(std::string_view a, std::string_view b) {
+    // O texto e a string mais longa: o custo e O(ceil(m/64) * n) com m <= n.
+    std::string_view pattern = a.size() <= b.size() ? a : b;
+    std::string_view text = a.size() <= b.size() ? b : a;
+
+    if (pattern.empty()) return text.size();
+    if (pattern.size() <= 64) return singleBlockDistance(pattern, text);
+    return multiBlockDistance(pattern, text);
+}
+
+double FuzzyMatcher::similarity(std::string_view a, std::string_view b) {
+    size_t longest = std::max(a.size(), b.size());
+    if (longest == 0) return 1.0;
+    return 1.0 - static_cast<double>(editDistance(a, b)) / static_cast<double>(longest);
+}
+
+MatchScore FuzzyMatcher::score(std::string_view submitted, std::string_view expected) {
+    MatchScore result;
+
+    if (submitted.empty() || expected.empty()) {
+        result.confidence = (submitted.empty() && expected.empty()) ? 1.0 : 0.0;
+        return result;
+    }
+
+    if (submitted == expected) {
+        result = { 1.0, 1.0, true, 1.0 };
+        return result;
+    }
+
+    result.contained = submitted.find(expected) != std::string_view::npos ||
+        expected.find(submitted) != std::string_view::npos;
+    result.editSimilarity = similarity(submitted, expected);
+
+    thread_local std::vector<std::string_view> submittedTokens;
+    thread_local std::vector<std::string_view> expectedTokens;
+    submittedTokens.clear();
+    expectedTokens.clear();
+    tokenize(submitted, submittedTokens);
+    tokenize(expected, expectedTokens);
+
+    // Cobertura do gabarito pesa mais: respostas costumam trazer explicacoes extras.
+    double recall = softCoverage(expectedTokens, submittedTokens);
+    double precision = softCoverage(submittedTokens, expectedTokens);
+    result.tokenSimilarity = 0.8 * recall + 0.2 * precision;
+
+    double containment = result.contained ? std::max(0.9, result.editSimilarity) : 0.0;
+    result.confidence = std::max({ result.editSimilarity, result.tokenSimilarity, containment });
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace FindTheBug {
+
+    struct MatchScore {
+        double editSimilarity{ 0.0 };
+        double tokenSimilarity{ 0.0 };
+        bool contained{ false };
+        double confidence{ 0.0 };
+    };
+
+    class FuzzyMatcher {
+    public:
+        // Distancia de Levenshtein pelo algoritmo bit-paralelo de Myers/Hyyro (blocos de 64 linhas).
+        static size_t editDistance(std::string_view a, std::string_view b);
+
+        // 1 - distancia / maior comprimento; 1.0 para duas strings vazias.
+        static double similarity(std::string_view a, std::string_view b);
+
+        // Compara resposta e gabarito ja normalizados (TextNormalizer).
+        static MatchScore score(std::string_view submitted, std::string_view expected);
+    };
+}
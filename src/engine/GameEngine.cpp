@@ -1,37 +1,131 @@
 #include "GameEngine.hpp"
 #include "ActionSystem.hpp"
+#include "CaseCache.hpp"
 #include "ValidationSystem.hpp"
+#include "SharedNote.hpp"
 
 #include <memory>
+#include <mutex>
 #include <algorithm>
 #include <chrono>
+#include <optional>
 #include <print>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace FindTheBug {
 
     class GameEngine::Impl {
     public:
-        std::shared_ptr<MongoStore> storage;
+        std::shared_ptr<GameStore> storage;
+        CaseCache caseCache;
         ActionSystem actionSystem;
         ValidationSystem validationSystem;
+
+        // sessionId -> caseId. O caso de uma sessao nao muda durante a partida; nao guarda estado de jogo.
+        std::shared_mutex sessionCasesMutex;
+        std::unordered_map<std::string, std::string> sessionCases;
+
+        explicit Impl(std::shared_ptr<GameStore> store)
+            : storage(store), caseCache(std::move(store)) {
+        }
         void advanceTurn(GameState& state) {
             if (state.turnOrder.empty()) return;
             state.currentTurnIndex = (state.currentTurnIndex + 1) % state.turnOrder.size();
             state.turnStartTime = std::chrono::system_clock::now();
         }
+
+        std::optional<std::string> caseIdFor(const std::string& sessionId) {
+            {
+                std::shared_lock lock(sessionCasesMutex);
+                auto it = sessionCases.find(sessionId);
+                if (it != sessionCases.end()) return it->second;
+            }
+
+            // Sessao criada antes de um reinicio: uma leitura e o caso fica conhecido.
+            auto stateOpt = storage->getGameState(sessionId);
+            if (!stateOpt) return std::nullopt;
+            rememberCase(sessionId, stateOpt->currentCaseId);
+            return stateOpt->currentCaseId;
+        }
+
+        void rememberCase(const std::string& sessionId, const std::string& caseId) {
+            std::unique_lock lock(sessionCasesMutex);
+            sessionCases[sessionId] = caseId;
+        }
+
+        void forgetCase(const std::string& sessionId) {
+            std::unique_lock lock(sessionCasesMutex);
+            sessionCases.erase(sessionId);
+        }
+
+        // Le, altera e grava com compare-and-set na revisao; se outra escrita entrou no meio, rele e refaz.
+        // mutate(state) retorna false quando nao ha nada a gravar. nullopt: sessao ausente ou conflito persistente.
+        static constexpr int kMaxUpdateAttempts = 4;
+
+        template <typename Mutate>
+        std::optional<GameState> updateSession(const std::string& sessionId, Mutate&& mutate) {
+            for (int attempt = 0; attempt < kMaxUpdateAttempts; ++attempt) {
+                auto state = storage->getGameState(sessionId);
+                if (!state) return std::nullopt;
+
+                int64_t expected = state->revision;
+                if (!mutate(*state)) return state;
+                if (auto written = storage->updateSession(*state, expected)) return written;
+            }
+            std::print("[ENGINE] Conflito persistente ao gravar a sessao {}.\n", sessionId);
+            return std::nullopt;
+        }
+
+        static CommandResult succeeded(const ActionUpdate& update) {
+            return {
+                .success = true,
+                .message = ActionSystem::successMessage(update),
+                .revealedClue = update.clue ? std::optional<Clue>(Clue{
+                    .id = update.clue->id,
+                    .targetId = update.clue->targetId,
+                    .targetType = update.clue->targetType,
+                    .type = update.clue->type,
+                    .content = update.clue->content
+                }) : std::nullopt,
+                .revealBonusSeconds = update.clue ? static_cast<int>(update.clueRevealBonus.count()) : 0
+            };
+        }
     };
 
-    GameEngine::GameEngine(std::shared_ptr<MongoStore> storage)
-        : pImpl(std::make_unique<Impl>()) {
-        pImpl->storage = std::move(storage);
+    GameEngine::GameEngine(std::shared_ptr<GameStore> storage)
+        : pImpl(std::make_unique<Impl>(std::move(storage))) {
     }
 
     GameEngine::~GameEngine() = default;
 
-    std::shared_ptr<MongoStore> GameEngine::getStorage() const {
+    std::shared_ptr<GameStore> GameEngine::getStorage() const {
         return pImpl->storage;
     }
 
+    std::shared_ptr<const CompiledCase> GameEngine::getCase(const std::string& caseId) {
+        return pImpl->caseCache.get(caseId);
+    }
+
+    void GameEngine::invalidateCase(const std::string& caseId) {
+        if (caseId.empty()) pImpl->caseCache.clear();
+        else pImpl->caseCache.invalidate(caseId);
+    }
+
+    std::unordered_map<std::string, std::string> GameEngine::sessionCases() {
+        std::shared_lock lock(pImpl->sessionCasesMutex);
+        return pImpl->sessionCases;
+    }
+
+    void GameEngine::adoptSessionCases(const std::unordered_map<std::string, std::string>& cases) {
+        std::unique_lock lock(pImpl->sessionCasesMutex);
+        for (const auto& [sessionId, caseId] : cases) pImpl->sessionCases.try_emplace(sessionId, caseId);
+    }
+
+    void GameEngine::forgetSession(const std::string& sessionId) {
+        pImpl->forgetCase(sessionId);
+    }
+
     bool GameEngine::initializeGameFromLobby(
         const std::string& sessionId,
         const std::string& caseId,
@@ -39,7 +133,7 @@ namespace FindTheBug {
         const std::string& hostPlayerId,
         const std::string& masterPlayerId
     ) {
-        auto bugCase = pImpl->storage->getCase(caseId);
+        auto bugCase = pImpl->caseCache.get(caseId);
         if (!bugCase) {
             std::print("[ENGINE] Erro: CaseID {} nao encontrado.\n", caseId);
             return false;
@@ -60,14 +154,17 @@ namespace FindTheBug {
         initialState.sessionId = sessionId;
         initialState.currentCaseId = caseId;
         initialState.currentDay = 1;
-        initialState.remainingPoints = 12;
+        initialState.remainingPoints = bugCase->rules.pointsPerDay;
         initialState.isCompleted = false;
         initialState.isSuddenDeath = false;
         initialState.playerIds = allParticipants;
         initialState.hostPlayerId = hostPlayerId;
         initialState.masterPlayerId = masterPlayerId;
 
-        return pImpl->storage->saveGameState(initialState);
+        if (!pImpl->storage->saveGameState(initialState)) return false;
+
+        pImpl->rememberCase(sessionId, caseId);
+        return true;
     }
 
     ProcessResult GameEngine::processAction(
@@ -76,243 +173,245 @@ namespace FindTheBug {
         const std::string& targetId,
         const std::string& sessionId) {
 
-        auto stateOpt = pImpl->storage->getGameState(sessionId);
-        if (!stateOpt) {
+        auto caseId = pImpl->caseIdFor(sessionId);
+        if (!caseId) {
             return { .success = false, .newState = {}, .message = "Erro: Sessao nao encontrada." };
         }
-        auto& state = *stateOpt;
-
-        bool isPlayerInGame = std::find(state.playerIds.begin(), state.playerIds.end(), playerId) != state.playerIds.end();
-        if (!isPlayerInGame && playerId != state.hostPlayerId) {
-            return { .success = false, .newState = state, .message = "Erro: Jogador nao faz parte da sessao." };
-        }
 
-        if (playerId == state.masterPlayerId) {
-            return { .success = false, .newState = state, .message = "O Mestre nao pode realizar acoes de investigacao." };
-        }
-
-        auto bugCaseOpt = pImpl->storage->getCase(state.currentCaseId);
-        if (!bugCaseOpt) {
-            return { .success = false, .newState = state, .message = "Erro: Caso corrompido ou inexistente." };
+        auto bugCase = pImpl->caseCache.get(*caseId);
+        if (!bugCase) {
+            return { .success = false, .newState = {}, .message = "Erro: Caso corrompido ou inexistente." };
         }
-        const auto& bugCase = *bugCaseOpt;
 
-        if (state.isSuddenDeath && actionType != ActionType::SubmitSolution) {
-            return { .success = false, .newState = state,
-                     .message = "MODO MORTE SUBITA: Apenas submissao de solucao permitida!" };
+        auto update = pImpl->actionSystem.plan(sessionId, playerId, actionType, targetId, *bugCase);
+        if (!update) {
+            return { .success = false, .newState = {}, .message = "Tipo de acao nao suportado." };
         }
 
-        if (actionType != ActionType::SubmitSolution) {
-            if (!state.turnOrder.empty()) {
-                std::string currentPlayer = state.turnOrder[state.currentTurnIndex];
-                if (playerId != currentPlayer) {
-                    return { .success = false, .newState = state, .message = "Nao e seu turno. Vez de: " + currentPlayer };
-                }
-            }
+        // Pre-condicoes verificadas e mudancas aplicadas pelo armazenamento numa unica operacao.
+        if (auto newState = pImpl->storage->applyAction(*update)) {
+            auto result = Impl::succeeded(*update);
+            return {
+                .success = true,
+                .newState = std::move(*newState),
+                .message = std::move(result.message),
+                .revealedClue = std::move(result.revealedClue),
+                .revealBonusSeconds = result.revealBonusSeconds
+            };
         }
 
-        auto actionResult = pImpl->actionSystem.execute(
-            actionType,
-            targetId,
-            bugCase,
-            state
-        );
-
-        if (!actionResult.success) {
-            return { .success = false, .newState = state, .message = actionResult.message };
+        // Recusada (ou falha de escrita): so agora le o estado para explicar o motivo.
+        auto stateOpt = pImpl->storage->getGameState(sessionId);
+        if (!stateOpt) {
+            pImpl->forgetCase(sessionId);
+            return { .success = false, .newState = {}, .message = "Erro: Sessao nao encontrada." };
         }
 
-        state.remainingPoints -= actionResult.pointsSpent;
+        auto reason = update->rejectReason(*stateOpt);
+        return {
+            .success = false,
+            .newState = std::move(*stateOpt),
+            .message = reason.value_or("Erro critico ao salvar estado no banco.")
+        };
+    }
 
-        if (actionResult.unlockedClue) {
-            bool alreadyExists = false;
-            for (const auto& existing : state.discoveredClues) {
-                if (existing.id == actionResult.unlockedClue->id) {
-                    alreadyExists = true;
-                    break;
+    BatchResult GameEngine::processActions(
+        const std::string& sessionId,
+        std::span<const Command> commands) {
+
+        BatchResult batch;
+        batch.results.reserve(commands.size());
+
+        // Os resultados sao refeitos a cada tentativa: com outro estado lido, outros comandos podem ser recusados.
+        std::shared_ptr<const CompiledCase> bugCase;
+        auto written = pImpl->updateSession(sessionId, [&](GameState& state) {
+            if (!bugCase) bugCase = pImpl->caseCache.get(state.currentCaseId);
+            auto now = std::chrono::system_clock::now();
+            bool changed = false;
+
+            batch.results.clear();
+            for (const auto& cmd : commands) {
+                if (cmd.kind == CommandKind::SaveNote) {
+                    NoteUpdate note{ sessionId, cmd.playerId, cmd.clueId, cmd.content, now };
+                    if (auto reason = note.rejectReason(state)) {
+                        batch.results.push_back({ .success = false, .message = std::move(*reason) });
+                        continue;
+                    }
+                    note.applyTo(state);
+                    changed = true;
+                    batch.results.push_back({ .success = true, .message = "Nota salva." });
+                    continue;
                 }
-            }
 
-            if (!alreadyExists) {
-                DiscoveredClue dc;
-                dc.id = actionResult.unlockedClue->id;
-                dc.targetId = actionResult.unlockedClue->targetId;
-                dc.type = actionResult.unlockedClue->type;
-                dc.targetType = actionResult.unlockedClue->targetType;
-                dc.content = actionResult.unlockedClue->content;
-                dc.discoveredBy = playerId;
-                state.discoveredClues.push_back(dc);
+                if (!bugCase) {
+                    batch.results.push_back({ .success = false, .message = "Erro: Caso corrompido ou inexistente." });
+                    continue;
+                }
+                auto update = pImpl->actionSystem.plan(sessionId, cmd.playerId, cmd.actionType, cmd.targetId, *bugCase);
+                if (!update) {
+                    batch.results.push_back({ .success = false, .message = "Tipo de acao nao suportado." });
+                    continue;
+                }
+                if (auto reason = update->rejectReason(state)) {
+                    batch.results.push_back({ .success = false, .message = std::move(*reason) });
+                    continue;
+                }
+                update->applyTo(state);
+                changed = true;
+                batch.results.push_back(Impl::succeeded(*update));
             }
-        }
+            return changed;
+        });
 
-        if (actionType == ActionType::InvestigateFunction) {
-            state.investigatedTargets.insert(targetId);
-        }
-        else if (actionType == ActionType::SetBreakpoint) {
-            state.breakpointedTargets.insert(targetId);
+        if (!written) {
+            batch.results.clear();
+            batch.message = "Erro: Sessao nao encontrada ou alterada por outra escrita.";
+            return batch;
         }
 
-        state.lastActivity = std::chrono::system_clock::now();
-
-        state.actionHistory.push_back({
-            .playerId = playerId,
-            .actionType = actionType,
-            .targetId = targetId,
-            .timestamp = std::chrono::system_clock::now()
-            });
-
-        if (actionResult.pointsSpent > 0 && !state.turnOrder.empty()) {
-            state.currentTurnIndex = (state.currentTurnIndex + 1) % state.turnOrder.size();
-            state.turnStartTime = std::chrono::system_clock::now();
-
-            if (actionResult.unlockedClue) {
-                state.turnStartTime += std::chrono::seconds(30);
-            }
-        }
+        batch.success = true;
+        batch.newState = std::move(*written);
+        return batch;
+    }
 
-        if (state.remainingPoints <= 0) {
-            if (state.currentDay >= 5) {
-                state.isSuddenDeath = true;
-                state.remainingPoints = 0;
-            }
-            else {
-                state.currentDay++;
-                state.remainingPoints = 12;
-            }
+    CommandResult GameEngine::savePlayerNote(
+        const std::string& sessionId,
+        const std::string& playerId,
+        const std::string& clueId,
+        const std::string& content
+    ) {
+        NoteUpdate note{ sessionId, playerId, clueId, content, std::chrono::system_clock::now() };
+        if (pImpl->storage->setPlayerNote(note)) {
+            return { .success = true, .message = "Nota salva." };
         }
 
-        if (pImpl->storage->saveGameState(state)) {
-            return {
-                .success = true,
-                .newState = state,
-                .message = actionResult.message,
-                .revealedClue = actionResult.unlockedClue
-            };
-        }
-        else {
-            return { .success = false, .newState = state, .message = "Erro critico ao salvar estado no banco." };
+        // Recusada ou falha de escrita: le o estado so para explicar o motivo.
+        auto stateOpt = pImpl->storage->getGameState(sessionId);
+        if (!stateOpt) {
+            return { .success = false, .message = "Erro: Sessao nao encontrada." };
         }
+        return {
+            .success = false,
+            .message = note.rejectReason(*stateOpt).value_or("Erro critico ao salvar nota no banco.")
+        };
     }
 
-    bool GameEngine::savePlayerNote(
+    CommandResult GameEngine::editSharedNote(
         const std::string& sessionId,
         const std::string& playerId,
         const std::string& clueId,
-        const std::string& content
+        std::vector<NoteOp>& ops
     ) {
-        auto stateOpt = pImpl->storage->getGameState(sessionId);
-        if (!stateOpt) return false;
-        auto state = *stateOpt;
-
-        bool found = false;
-        for (auto& dc : state.discoveredClues) {
-            if (dc.id == clueId) {
-                if (content.empty()) {
-                    if (dc.discoveredBy == playerId) {
-                        return false;
-                    }
-                    else {
-                        dc.playerNotes.erase(playerId);
-                    }
-                }
-                else {
-                    dc.playerNotes[playerId] = content;
-                }
-                found = true;
-                break;
-            }
+        if (!isValidPlayerName(playerId)) {
+            return { .success = false, .message = "Nome de jogador invalido." };
+        }
+        if (ops.empty() || ops.size() > SharedNote::kMaxOpsPerEdit) {
+            return { .success = false, .message = "Quantidade de operacoes invalida." };
+        }
+        for (auto& op : ops) {
+            if (auto error = SharedNote::validate(op)) return { .success = false, .message = *error };
+            op.replica = playerId;
         }
 
-        if (!found) return false;
-
-        state.lastActivity = std::chrono::system_clock::now();
+        if (pImpl->storage->appendSharedNoteOps(sessionId, clueId, ops)) {
+            return { .success = true, .message = "Nota compartilhada atualizada." };
+        }
 
-        return pImpl->storage->saveGameState(state);
+        auto stateOpt = pImpl->storage->getGameState(sessionId);
+        if (!stateOpt) {
+            return { .success = false, .message = "Erro: Sessao nao encontrada." };
+        }
+        bool clueFound = std::any_of(stateOpt->discoveredClues.begin(), stateOpt->discoveredClues.end(),
+            [&](const DiscoveredClue& dc) { return dc.id == clueId; });
+        return { .success = false, .message = clueFound ? "Nota compartilhada cheia." : "Pista nao encontrada." };
     }
 
-    ValidationResult GameEngine::submitToMaster(
+    SubmissionResult GameEngine::submitToMaster(
         const std::string& sessionId,
         const std::vector<std::string>& answers) {
 
-        auto stateOpt = pImpl->storage->getGameState(sessionId);
-        if (!stateOpt) return { .isCorrect = false, .score = 0, .generalMessage = "Sesso invlida" };
-
-        stateOpt->lastActivity = std::chrono::system_clock::now();
-        pImpl->storage->saveGameState(*stateOpt);
+        auto stateOpt = pImpl->updateSession(sessionId, [](GameState& state) {
+            state.lastActivity = std::chrono::system_clock::now();
+            return true;
+        });
+        if (!stateOpt) return { .success = false, .message = "Sessao de jogo nao encontrada." };
 
-        auto bugCaseOpt = pImpl->storage->getCase(stateOpt->currentCaseId);
-        if (!bugCaseOpt) return { .isCorrect = false, .score = 0, .generalMessage = "Caso invlido" };
+        auto bugCase = pImpl->caseCache.get(stateOpt->currentCaseId);
+        if (!bugCase) return { .success = false, .newState = std::move(*stateOpt), .message = "Caso nao encontrado no banco." };
 
-        return pImpl->validationSystem.prepareForMaster(answers, *bugCaseOpt);
+        auto review = pImpl->validationSystem.prepareForMaster(answers, *bugCase);
+        return { .success = true, .newState = std::move(*stateOpt), .review = std::move(review) };
     }
 
-    GameResult GameEngine::finalizeSession(const std::string& sessionId, bool approvedByMaster) {
-        auto stateOpt = pImpl->storage->getGameState(sessionId);
-        if (!stateOpt) return GameResult::Running;
+    FinalizeResult GameEngine::finalizeSession(const std::string& sessionId, bool approvedByMaster) {
+        GameResult outcome = GameResult::Running;
 
-        auto state = *stateOpt;
+        auto written = pImpl->updateSession(sessionId, [&](GameState& state) {
+            auto bugCase = pImpl->caseCache.get(state.currentCaseId);
+            static const CompiledRules kDefaultRules;
+            const CompiledRules& rules = bugCase ? bugCase->rules : kDefaultRules;
 
-        if (approvedByMaster) {
-            state.isCompleted = true;
-            pImpl->storage->saveGameState(state);
-            return GameResult::Victory;
-        }
+            if (approvedByMaster) {
+                state.isCompleted = true;
+                outcome = GameResult::Victory;
+                return true;
+            }
 
-        if (state.isSuddenDeath) {
-            state.isCompleted = true;
-            pImpl->storage->saveGameState(state);
-            return GameResult::Defeat;
-        }
+            if (state.isSuddenDeath) {
+                state.isCompleted = true;
+                outcome = GameResult::Defeat;
+                return true;
+            }
 
-        state.currentDay += 2;
+            outcome = GameResult::Running;
+            state.currentDay += rules.rejectionPenaltyDays;
 
-        if (state.currentDay > 5) {
-            state.currentDay = 5;
-            state.isSuddenDeath = true;
-            state.remainingPoints = 0;
-            return GameResult::Running;
-        }
+            // A morte subita precisa ser gravada: a proxima recusa encerra a partida.
+            if (state.currentDay > rules.dayLimit) {
+                state.currentDay = rules.dayLimit;
+                state.isSuddenDeath = true;
+                state.remainingPoints = 0;
+                return true;
+            }
 
-        state.remainingPoints = 12;
+            state.remainingPoints = rules.pointsPerDay;
+            return true;
+        });
+        if (!written) return {};
 
-        pImpl->storage->saveGameState(state);
-        return GameResult::Running;
+        if (outcome != GameResult::Running) pImpl->forgetCase(sessionId);
+        return { .outcome = outcome, .newState = std::move(written) };
     }
 
 
     GameResult GameEngine::removePlayer(const std::string& sessionId, const std::string& playerId) {
-        auto stateOpt = pImpl->storage->getGameState(sessionId);
-        if (!stateOpt) return GameResult::Running;
-        auto state = *stateOpt;
-
-        auto it = std::remove(state.playerIds.begin(), state.playerIds.end(), playerId);
-        state.playerIds.erase(it, state.playerIds.end());
+        auto written = pImpl->updateSession(sessionId, [&](GameState& state) {
+            auto it = std::remove(state.playerIds.begin(), state.playerIds.end(), playerId);
+            state.playerIds.erase(it, state.playerIds.end());
 
-        auto itTurn = std::find(state.turnOrder.begin(), state.turnOrder.end(), playerId);
-        if (itTurn != state.turnOrder.end()) {
-            int indexRemoved = std::distance(state.turnOrder.begin(), itTurn);
-            state.turnOrder.erase(itTurn);
+            auto itTurn = std::find(state.turnOrder.begin(), state.turnOrder.end(), playerId);
+            if (itTurn != state.turnOrder.end()) {
+                int indexRemoved = std::distance(state.turnOrder.begin(), itTurn);
+                state.turnOrder.erase(itTurn);
 
-            if (state.currentTurnIndex >= state.turnOrder.size()) {
-                state.currentTurnIndex = 0;
-            }
-            else if (indexRemoved < state.currentTurnIndex) {
-                state.currentTurnIndex--;
-            }
+                if (state.currentTurnIndex >= state.turnOrder.size()) {
+                    state.currentTurnIndex = 0;
+                }
+                else if (indexRemoved < state.currentTurnIndex) {
+                    state.currentTurnIndex--;
+                }
 
-            if (indexRemoved == state.currentTurnIndex) {
-                state.turnStartTime = std::chrono::system_clock::now();
+                if (indexRemoved == state.currentTurnIndex) {
+                    state.turnStartTime = std::chrono::system_clock::now();
+                }
             }
-        }
 
-    
-        if (state.turnOrder.size() < 2) {
-            state.isCompleted = true;
-            pImpl->storage->saveGameState(state);
-            return GameResult::Defeat;
-        }
+            if (state.turnOrder.size() < 2) state.isCompleted = true;
+            return true;
+        });
+        if (!written || !written->isCompleted) return GameResult::Running;
 
-        pImpl->storage->saveGameState(state);
-        return GameResult::Running;
+        pImpl->forgetCase(sessionId);
+        return GameResult::Defeat;
     }
-}
\ No newline at end of file
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include "../storage/MongoStore.hpp"
+#include "../storage/GameStore.hpp"
 #include "Types.hpp"
 #include "../shared/DTOs.hpp"
 
@@ -11,7 +13,7 @@ namespace FindTheBug {
 
     class GameEngine {
     public:
-        explicit GameEngine(std::shared_ptr<MongoStore> storage);
+        explicit GameEngine(std::shared_ptr<GameStore> storage);
         ~GameEngine();
 
         bool initializeGameFromLobby(
@@ -29,22 +31,51 @@ namespace FindTheBug {
             const std::string& sessionId
         );
 
-        ValidationResult submitToMaster(
+        // Aplica varios comandos em sequencia: uma leitura, os comandos em memoria e uma gravacao com
+        // compare-and-set na revisao. Se outra escrita entrou no meio, o lote inteiro e refeito.
+        BatchResult processActions(
+            const std::string& sessionId,
+            std::span<const Command> commands
+        );
+
+        SubmissionResult submitToMaster(
             const std::string& sessionId,
             const std::vector<std::string>& answers
         );
 
-        GameResult finalizeSession(const std::string& sessionId, bool approvedByMaster);
+        FinalizeResult finalizeSession(const std::string& sessionId, bool approvedByMaster);
         GameResult removePlayer(const std::string& sessionId, const std::string& playerId);
 
-        bool savePlayerNote(
+        // Grava apenas a nota indicada; o custo nao depende do tamanho da sessao.
+        CommandResult savePlayerNote(
             const std::string& sessionId,
             const std::string& playerId,
             const std::string& clueId,
             const std::string& content
         );
 
-        std::shared_ptr<MongoStore> getStorage() const;
+        // Acrescenta operacoes RGA a nota compartilhada da pista. Carimba o autor (replica) em cada operacao;
+        // em caso de sucesso, ops contem exatamente o que foi gravado, pronto para repassar aos outros clientes.
+        CommandResult editSharedNote(
+            const std::string& sessionId,
+            const std::string& playerId,
+            const std::string& clueId,
+            std::vector<NoteOp>& ops
+        );
+
+        std::shared_ptr<GameStore> getStorage() const;
+
+        // Caso compilado do cache (carrega do armazenamento na primeira chamada).
+        std::shared_ptr<const CompiledCase> getCase(const std::string& caseId);
+        // caseId vazio descarta todos os casos compilados.
+        void invalidateCase(const std::string& caseId);
+
+        // sessionId -> caseId conhecidos; o processo que assume a vez evita uma leitura por sessao.
+        std::unordered_map<std::string, std::string> sessionCases();
+        void adoptSessionCases(const std::unordered_map<std::string, std::string>& cases);
+
+        // Sessao encerrada ou removida do armazenamento por fora do engine.
+        void forgetSession(const std::string& sessionId);
 
     private:
         class Impl;
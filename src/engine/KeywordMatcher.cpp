@@ -0,0 +1,84 @@
+#include "KeywordMatcher.hpp"
+
+#include <queue>
+
+using namespace FindTheBug;
+
+void KeywordMatcher::addPattern(std::string_view pattern, uint32_t conceptId) {
+    if (pattern.empty() || conceptId >= kMaxConcepts) return;
+    patterns.emplace_back(std::string(pattern), conceptId);
+}
+
+void KeywordMatcher::build() {
+    byteClass.fill(0);
+    classCount = 1;
+    for (const auto& [pattern, id] : patterns) {
+        for (unsigned char c : pattern) {
+            if (byteClass[c] == 0) byteClass[c] = static_cast<uint8_t>(classCount++);
+        }
+    }
+
+    // Trie: estado 0 e a raiz; -1 marca transicao ausente ate o fechamento do DFA.
+    transitions.assign(classCount, -1);
+    outputs.assign(1, 0);
+    allConcepts = 0;
+
+    for (const auto& [pattern, id] : patterns) {
+        int32_t state = 0;
+        for (unsigned char c : pattern) {
+            size_t slot = static_cast<size_t>(state) * classCount + byteClass[c];
+            if (transitions[slot] < 0) {
+                transitions[slot] = static_cast<int32_t>(outputs.size());
+                transitions.resize(transitions.size() + classCount, -1);
+                outputs.push_back(0);
+            }
+            state = transitions[static_cast<size_t>(state) * classCount + byteClass[c]];
+        }
+        outputs[state] |= 1ULL << id;
+        allConcepts |= 1ULL << id;
+    }
+
+    // BFS: links de falha viram transicoes diretas e as saidas herdam as do sufixo.
+    std::vector<int32_t> fail(outputs.size(), 0);
+    std::queue<int32_t> pending;
+
+    for (size_t cls = 0; cls < classCount; ++cls) {
+        int32_t& next = transitions[cls];
+        if (next < 0) next = 0;
+        else pending.push(next);
+    }
+
+    while (!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+        outputs[state] |= outputs[fail[state]];
+
+        for (size_t cls = 0; cls < classCount; ++cls) {
+            size_t slot = static_cast<size_t>(state) * classCount + cls;
+            int32_t fallback = transitions[static_cast<size_t>(fail[state]) * classCount + cls];
+            if (transitions[slot] < 0) {
+                transitions[slot] = fallback;
+            }
+            else {
+                fail[transitions[slot]] = fallback;
+                pending.push(transitions[slot]);
+            }
+        }
+    }
+
+    patterns.clear();
+    patterns.shrink_to_fit();
+}
+
+uint64_t KeywordMatcher::scan(std::string_view text) const {
+    if (allConcepts == 0) return 0;
+
+    uint64_t found = 0;
+    size_t state = 0;
+    for (unsigned char c : text) {
+        state = static_cast<size_t>(transitions[state * classCount + byteClass[c]]);
+        found |= outputs[state];
+        if (found == allConcepts) break;
+    }
+    return found;
+}
\ No newline at end of file
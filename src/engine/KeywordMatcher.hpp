@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FindTheBug {
+
+    // Automato de Aho-Corasick sobre bytes: encontra todos os padroes em uma unica passada pelo texto.
+    // Cada padrao pertence a um conceito; sinonimos compartilham o mesmo id. Ate 64 conceitos.
+    class KeywordMatcher {
+    public:
+        static constexpr size_t kMaxConcepts = 64;
+
+        // Padroes vazios ou com conceptId >= kMaxConcepts sao ignorados.
+        void addPattern(std::string_view pattern, uint32_t conceptId);
+
+        // Constroi o DFA completo. Deve ser chamado apos o ultimo addPattern e antes de scan.
+        void build();
+
+        // Mascara de bits com os conceitos encontrados no texto.
+        uint64_t scan(std::string_view text) const;
+
+        uint64_t conceptMask() const { return allConcepts; }
+        bool empty() const { return allConcepts == 0; }
+
+    private:
+        std::vector<std::pair<std::string, uint32_t>> patterns;
+
+        // Bytes que nao aparecem em nenhum padrao caem na classe 0.
+        std::array<uint8_t, 256> byteClass{};
+        size_t classCount{ 1 };
+
+        std::vector<int32_t> transitions;
+        std::vector<uint64_t> outputs;
+        uint64_t allConcepts{ 0 };
+    };
+}
\ No newline at end of file
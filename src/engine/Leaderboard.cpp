@@ -0,0 +1,74 @@
+#include "Leaderboard.hpp"
+
+#include <algorithm>
+
+using namespace FindTheBug;
+
+Leaderboard::Leaderboard() : tree(kScoreRange + 1, 0) {
+}
+
+int Leaderboard::scoreFor(const GameState& state, GameResult outcome) {
+    int daysLeft = 63 - std::clamp(state.currentDay, 0, 63);
+
+    switch (outcome) {
+    case GameResult::Victory:
+        return 2 * kTierSize + daysLeft * 256 + std::clamp(state.remainingPoints, 0, 255);
+    case GameResult::Defeat:
+        return std::min(static_cast<int>(state.discoveredClues.size()), 255) * 64 + daysLeft;
+    default:
+        return kTierSize + std::min(static_cast<int>(state.discoveredClues.size()), 255) * 64 + daysLeft;
+    }
+}
+
+void Leaderboard::add(int score, int delta) {
+    for (int i = score + 1; i <= kScoreRange; i += i & -i) tree[i] += delta;
+}
+
+int Leaderboard::countAbove(int score) const {
+    // Total menos os que tem score <= score.
+    int atOrBelow = 0;
+    for (int i = score + 1; i > 0; i -= i & -i) atOrBelow += tree[i];
+    return static_cast<int>(scores.size()) - atOrBelow;
+}
+
+bool Leaderboard::update(const std::string& sessionId, int score) {
+    score = std::clamp(score, 0, kScoreRange - 1);
+
+    auto [it, inserted] = scores.try_emplace(sessionId, score);
+    if (!inserted) {
+        if (it->second == score) return false;
+        ordered.erase({ it->second, sessionId });
+        add(it->second, -1);
+        it->second = score;
+    }
+
+    ordered.insert({ score, sessionId });
+    add(score, +1);
+    return true;
+}
+
+int Leaderboard::scoreOf(const std::string& sessionId) const {
+    auto it = scores.find(sessionId);
+    return it == scores.end() ? 0 : it->second;
+}
+
+int Leaderboard::rankOf(const std::string& sessionId) const {
+    auto it = scores.find(sessionId);
+    if (it == scores.end()) return 0;
+    return countAbove(it->second) + 1;
+}
+
+std::vector<Standing> Leaderboard::top(size_t limit) const {
+    std::vector<Standing> out;
+    out.reserve(std::min(limit, ordered.size()));
+
+    int rank = 0;
+    int previousScore = -1;
+    for (const auto& entry : ordered) {
+        if (out.size() == limit) break;
+        if (entry.score != previousScore) rank = static_cast<int>(out.size()) + 1;
+        previousScore = entry.score;
+        out.push_back({ entry.sessionId, entry.score, rank });
+    }
+    return out;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../shared/DTOs.hpp"
+
+namespace FindTheBug {
+
+    struct Standing {
+        std::string sessionId;
+        int score{ 0 };
+        int rank{ 0 };
+    };
+
+    // Ranking incremental de um torneio. Ordem em std::set para listar o topo e contagem por score em
+    // uma Fenwick tree para o rank: inserir, atualizar e consultar a posicao de um time custam O(log n).
+    // Empates dividem a posicao (1, 2, 2, 4).
+    class Leaderboard {
+    public:
+        static constexpr int kTierSize = 1 << 14;
+        static constexpr int kScoreRange = 3 * kTierSize;
+
+        Leaderboard();
+
+        // Vitoria acima de partida em andamento acima de derrota. Vitorias: menos dias e mais pontos;
+        // demais: mais pistas e menos dias.
+        static int scoreFor(const GameState& state, GameResult outcome);
+
+        // Insere ou atualiza. false se o time ja estava com esse score.
+        bool update(const std::string& sessionId, int score);
+        bool contains(const std::string& sessionId) const { return scores.contains(sessionId); }
+
+        int scoreOf(const std::string& sessionId) const;
+        int rankOf(const std::string& sessionId) const;  // 0 se o time nao esta no ranking
+        std::vector<Standing> top(size_t limit) const;
+        size_t size() const { return scores.size(); }
+
+    private:
+        struct Entry {
+            int score;
+            std::string sessionId;
+
+            bool operator<(const Entry& other) const {
+                if (score != other.score) return score > other.score;
+                return sessionId < other.sessionId;
+            }
+        };
+
+        void add(int score, int delta);
+        int countAbove(int score) const;
+
+        std::set<Entry> ordered;
+        std::unordered_map<std::string, int> scores;
+        std::vector<int32_t> tree;  // Fenwick indexada por score + 1
+    };
+}
@@ -0,0 +1,214 @@
+#include "SharedNote.hpp"
+
+#include <limits>
+
+using namespace FindTheBug;
+
+SharedNote::SharedNote() {
+    replicas.emplace_back();
+    replicaIndex.emplace(std::string(), 0);
+    elements.push_back({});
+}
+
+uint32_t SharedNote::internReplica(std::string_view name) {
+    if (auto found = findReplica(name)) return *found;
+    uint32_t index = static_cast<uint32_t>(replicas.size());
+    replicas.emplace_back(name);
+    replicaIndex.emplace(replicas.back(), index);
+    return index;
+}
+
+std::optional<uint32_t> SharedNote::findReplica(std::string_view name) const {
+    auto it = replicaIndex.find(std::string(name));
+    if (it == replicaIndex.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<uint32_t> SharedNote::find(int64_t counter, std::string_view replica) const {
+    if (counter == 0) return 0;
+    auto r = findReplica(replica);
+    if (!r) return std::nullopt;
+    auto it = byId.find({ counter, *r });
+    if (it == byId.end()) return std::nullopt;
+    return it->second;
+}
+
+bool SharedNote::greater(const Id& a, const Id& b) const {
+    if (a.counter != b.counter) return a.counter > b.counter;
+    return replicas[a.replica] > replicas[b.replica];
+}
+
+bool SharedNote::apply(const NoteOp& op) {
+    return op.isRemove() ? remove(op) : insert(op);
+}
+
+bool SharedNote::insert(const NoteOp& op) {
+    auto refIndex = find(op.refCounter, op.refReplica);
+    if (!refIndex) return false;
+
+    uint32_t replica = internReplica(op.replica);
+    uint32_t ref = *refIndex;
+    int64_t counter = op.counter;
+    const auto& text = op.text;
+
+    for (size_t i = 0; i < text.size();) {
+        size_t len = 1;
+        while (i + len < text.size() && len < 4 && (static_cast<unsigned char>(text[i + len]) & 0xC0) == 0x80) ++len;
+
+        Id id{ counter++, replica };
+        auto existing = byId.find(id);
+        if (existing != byId.end()) {
+            ref = existing->second;
+            i += len;
+            continue;
+        }
+
+        // Pula irmaos maiores (e os descendentes deles, que tem ids ainda maiores).
+        uint32_t pos = ref;
+        while (elements[pos].next != kEnd && greater(elements[elements[pos].next].id, id)) {
+            pos = elements[pos].next;
+        }
+
+        uint32_t index = static_cast<uint32_t>(elements.size());
+        elements.push_back({
+            .id = id,
+            .ref = elements[ref].id,
+            .next = elements[pos].next,
+            .textOffset = static_cast<uint32_t>(chars.size()),
+            .textLength = static_cast<uint8_t>(len)
+        });
+        elements[pos].next = index;
+        byId.emplace(id, index);
+        chars.append(text, i, len);
+
+        ref = index;
+        i += len;
+    }
+    return true;
+}
+
+bool SharedNote::remove(const NoteOp& op) {
+    auto r = findReplica(op.refReplica);
+    if (!r) return false;
+
+    for (int32_t k = 0; k < op.removeCount; ++k) {
+        if (!byId.contains({ op.refCounter + k, *r })) return false;
+    }
+    for (int32_t k = 0; k < op.removeCount; ++k) {
+        elements[byId.at({ op.refCounter + k, *r })].removed = true;
+    }
+    return true;
+}
+
+SharedNote SharedNote::replay(std::span<const NoteOp> ops) {
+    SharedNote note;
+    for (const auto& op : ops) {
+        if (!note.apply(op)) {
+            note.pending.push_back(op);
+            continue;
+        }
+
+        bool progress = !note.pending.empty();
+        while (progress) {
+            progress = false;
+            for (size_t i = 0; i < note.pending.size();) {
+                if (note.apply(note.pending[i])) {
+                    note.pending.erase(note.pending.begin() + i);
+                    progress = true;
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+    }
+    return note;
+}
+
+std::string SharedNote::text() const {
+    std::string out;
+    out.reserve(chars.size());
+    for (uint32_t i = elements[0].next; i != kEnd; i = elements[i].next) {
+        const auto& e = elements[i];
+        if (!e.removed) out.append(chars, e.textOffset, e.textLength);
+    }
+    return out;
+}
+
+size_t SharedNote::length() const {
+    size_t count = 0;
+    for (uint32_t i = elements[0].next; i != kEnd; i = elements[i].next) {
+        if (!elements[i].removed) ++count;
+    }
+    return count;
+}
+
+std::vector<NoteOp> SharedNote::compact() const {
+    std::vector<NoteOp> out;
+
+    // Insercoes na ordem do texto: a referencia de um elemento sempre aparece antes dele.
+    size_t run = SIZE_MAX;
+    uint32_t prev = 0;
+    for (uint32_t i = elements[0].next; i != kEnd; i = elements[i].next) {
+        const auto& e = elements[i];
+        const auto& p = elements[prev];
+        bool extends = run != SIZE_MAX
+            && e.id.replica == p.id.replica
+            && e.id.counter == p.id.counter + 1
+            && e.ref == p.id
+            && out[run].text.size() + e.textLength <= kMaxRunBytes;
+
+        if (!extends) {
+            out.push_back({
+                .replica = replicas[e.id.replica],
+                .counter = e.id.counter,
+                .refCounter = e.ref.counter,
+                .refReplica = replicas[e.ref.replica]
+            });
+            run = out.size() - 1;
+        }
+        out[run].text.append(chars, e.textOffset, e.textLength);
+        prev = i;
+    }
+
+    // Lapides, agrupadas por ids consecutivos do mesmo autor.
+    size_t inserts = out.size();
+    for (uint32_t i = elements[0].next; i != kEnd; i = elements[i].next) {
+        const auto& e = elements[i];
+        if (!e.removed) continue;
+
+        if (out.size() > inserts) {
+            auto& last = out.back();
+            if (last.refReplica == replicas[e.id.replica]
+                && last.refCounter + last.removeCount == e.id.counter
+                && last.removeCount < static_cast<int32_t>(kMaxRunBytes)) {
+                last.removeCount++;
+                continue;
+            }
+        }
+        out.push_back({ .refCounter = e.id.counter, .refReplica = replicas[e.id.replica], .removeCount = 1 });
+    }
+
+    out.insert(out.end(), pending.begin(), pending.end());
+    return out;
+}
+
+std::optional<std::string> SharedNote::validate(const NoteOp& op) {
+    constexpr int64_t kMaxCounter = std::numeric_limits<int64_t>::max() / 2;
+
+    if (op.removeCount < 0) return "Operacao de nota invalida.";
+
+    if (op.isRemove()) {
+        if (!op.text.empty() || op.refCounter < 1 || op.refCounter > kMaxCounter) return "Remocao invalida.";
+        if (op.removeCount > static_cast<int32_t>(kMaxRunBytes)) return "Remocao longa demais.";
+        return std::nullopt;
+    }
+
+    if (op.text.empty()) return "Insercao vazia.";
+    if (op.text.size() > kMaxRunBytes) return "Insercao longa demais.";
+    if (op.counter < 1 || op.counter > kMaxCounter || op.refCounter < 0) return "Id de insercao invalido.";
+    // Garante a convergencia do RGA: o id novo e maior que o id em que foi inserido.
+    if (op.counter <= op.refCounter) return "Id de insercao deve ser maior que o da referencia.";
+    if (op.refCounter == 0 && !op.refReplica.empty()) return "Referencia invalida.";
+    return std::nullopt;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../shared/DTOs.hpp"
+
+namespace FindTheBug {
+
+    // Nota compartilhada como sequencia RGA (Replicated Growable Array).
+    // Cada code point tem um id (counter, replica) e fica a direita do id em que foi inserido; irmaos
+    // ficam em ordem decrescente de id. Com counter > refCounter em toda insercao, qualquer ordem de
+    // aplicacao que respeite as dependencias converge para o mesmo texto. Remocoes viram lapides.
+    class SharedNote {
+    public:
+        static constexpr size_t kMaxRunBytes = 256;
+        static constexpr size_t kMaxOpsPerEdit = 32;
+
+        SharedNote();
+
+        // Aplica a operacao. Idempotente. false quando depende de um id ainda nao visto.
+        bool apply(const NoteOp& op);
+
+        // Aplica um log em ordem de chegada; operacoes que chegaram antes da dependencia esperam por ela.
+        static SharedNote replay(std::span<const NoteOp> ops);
+
+        std::string text() const;
+        size_t length() const;                   // code points visiveis
+        size_t pendingCount() const { return pending.size(); }
+
+        // Log equivalente e menor: insercoes consecutivas do mesmo autor viram uma so, idem remocoes.
+        std::vector<NoteOp> compact() const;
+
+        // Erro de formato de uma operacao recebida do cliente (nao consulta o estado).
+        static std::optional<std::string> validate(const NoteOp& op);
+
+    private:
+        static constexpr uint32_t kEnd = UINT32_MAX;
+
+        struct Id {
+            int64_t counter{ 0 };
+            uint32_t replica{ 0 };
+            bool operator==(const Id&) const = default;
+        };
+
+        struct IdHash {
+            size_t operator()(const Id& id) const {
+                return std::hash<int64_t>{}(id.counter) ^ (static_cast<size_t>(id.replica) * 0x9e3779b97f4a7c15ull);
+            }
+        };
+
+        struct Element {
+            Id id;
+            Id ref;
+            uint32_t next{ kEnd };
+            uint32_t textOffset{ 0 };
+            uint8_t textLength{ 0 };
+            bool removed{ false };
+        };
+
+        uint32_t internReplica(std::string_view name);
+        std::optional<uint32_t> findReplica(std::string_view name) const;
+        std::optional<uint32_t> find(int64_t counter, std::string_view replica) const;
+        bool greater(const Id& a, const Id& b) const;
+        bool insert(const NoteOp& op);
+        bool remove(const NoteOp& op);
+
+        std::vector<std::string> replicas;       // indice 0: replica vazio (cabeca)
+        std::unordered_map<std::string, uint32_t> replicaIndex;
+        std::vector<Element> elements;           // elements[0] e a cabeca; a ordem do texto segue 'next'
+        std::unordered_map<Id, uint32_t, IdHash> byId;
+        std::string chars;
+        std::vector<NoteOp> pending;
+    };
+}
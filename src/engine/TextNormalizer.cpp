@@ -0,0 +1,177 @@
+#include "TextNormalizer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+using namespace FindTheBug;
+
+namespace {
+
+    constexpr uint64_t kOnes = 0x0101010101010101ULL;
+    constexpr uint64_t kHigh = 0x8080808080808080ULL;
+
+    // 0 marca separador; demais entradas sao o byte de saida.
+    constexpr std::array<char, 128> kAsciiFold = [] {
+        std::array<char, 128> table{};
+        for (int c = 'a'; c <= 'z'; ++c) table[c] = static_cast<char>(c);
+        for (int c = 'A'; c <= 'Z'; ++c) table[c] = static_cast<char>(c + 32);
+        for (int c = '0'; c <= '9'; ++c) table[c] = static_cast<char>(c);
+        table['_'] = '_';
+        return table;
+    }();
+
+    // U+00C0-U+017F dobrados para ASCII minusculo. " " marca simbolo (x, divisao) tratado como separador.
+    constexpr std::array<std::string_view, 192> kLatinFold = {
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",  // U+00C0
+        "d", "n", "o", "o", "o", "o", "o", " ", "o", "u", "u", "u", "u", "y", "th", "ss",  // U+00D0
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",  // U+00E0
+        "d", "n", "o", "o", "o", "o", "o", " ", "o", "u", "u", "u", "u", "y", "th", "y",  // U+00F0
+        "a", "a", "a", "a", "a", "a", "c", "c", "c", "c", "c", "c", "c", "c", "d", "d",  // U+0100
+        "d", "d", "e", "e", "e", "e", "e", "e", "e", "e", "e", "e", "g", "g", "g", "g",  // U+0110
+        "g", "g", "g", "g", "h", "h", "h", "h", "i", "i", "i", "i", "i", "i", "i", "i",  // U+0120
+        "i", "i", "ij", "ij", "j", "j", "k", "k", "k", "l", "l", "l", "l", "l", "l", "l",  // U+0130
+        "l", "l", "l", "n", "n", "n", "n", "n", "n", "n", "n", "n", "o", "o", "o", "o",  // U+0140
+        "o", "o", "oe", "oe", "r", "r", "r", "r", "r", "r", "s", "s", "s", "s", "s", "s",  // U+0150
+        "s", "s", "t", "t", "t", "t", "t", "t", "u", "u", "u", "u", "u", "u", "u", "u",  // U+0160
+        "u", "u", "u", "u", "w", "w", "y", "y", "y", "z", "z", "z", "z", "z", "z", "s",  // U+0170
+    };
+
+    // Bits altos marcam os bytes (ASCII) dentro de [lo, hi].
+    constexpr uint64_t inRange(uint64_t x, unsigned char lo, unsigned char hi) {
+        uint64_t ge = x + (0x80 - lo) * kOnes;
+        uint64_t gt = x + (0x7f - hi) * kOnes;
+        return ge & ~gt & kHigh;
+    }
+
+    constexpr uint64_t equalTo(uint64_t x, unsigned char c) {
+        uint64_t y = x ^ (c * kOnes);
+        return ~(y + 0x7f * kOnes) & kHigh;
+    }
+
+    bool isContinuation(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+    class Writer {
+    public:
+        explicit Writer(std::string& out) : out(out) {}
+
+        void separator() { pendingSpace = true; }
+
+        void put(char c) {
+            flush();
+            out.push_back(c);
+        }
+
+        void put(std::string_view s) {
+            if (s == " ") {
+                separator();
+                return;
+            }
+            flush();
+            out.append(s);
+        }
+
+        void putWord8(uint64_t word) {
+            flush();
+            char bytes[8];
+            std::memcpy(bytes, &word, 8);
+            out.append(bytes, 8);
+        }
+
+        void ascii(unsigned char c) {
+            char folded = kAsciiFold[c];
+            if (folded) put(folded);
+            else separator();
+        }
+
+        void latin(uint32_t codepoint) {
+            if (codepoint >= 0xC0 && codepoint <= 0x17F) put(kLatinFold[codepoint - 0xC0]);
+            else separator();
+        }
+
+    private:
+        void flush() {
+            if (pendingSpace && !out.empty()) out.push_back(' ');
+            pendingSpace = false;
+        }
+
+        std::string& out;
+        bool pendingSpace{ false };
+    };
+}
+
+void TextNormalizer::normalize(std::string_view in, std::string& out) {
+    out.clear();
+    out.reserve(in.size() + 8);
+
+    Writer writer(out);
+    const auto* s = reinterpret_cast<const unsigned char*>(in.data());
+    const size_t n = in.size();
+    size_t i = 0;
+
+    while (i < n) {
+        // Caminho rapido: 8 bytes ASCII. Palavras inteiras (letras, digitos, '_') sao copiadas de uma vez.
+        if (i + 8 <= n) {
+            uint64_t x;
+            std::memcpy(&x, s + i, 8);
+            if ((x & kHigh) == 0) {
+                x |= inRange(x, 'A', 'Z') >> 2;
+                uint64_t word = inRange(x, 'a', 'z') | inRange(x, '0', '9') | equalTo(x, '_');
+                if (word == kHigh) {
+                    writer.putWord8(x);
+                }
+                else {
+                    for (size_t k = 0; k < 8; ++k) writer.ascii(s[i + k]);
+                }
+                i += 8;
+                continue;
+            }
+        }
+
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            writer.ascii(c);
+            ++i;
+            continue;
+        }
+
+        // Sequencias de dois bytes: U+0080-U+07FF.
+        if (c >= 0xC2 && c <= 0xDF && i + 1 < n && isContinuation(s[i + 1])) {
+            uint32_t cp = ((c & 0x1Fu) << 6) | (s[i + 1] & 0x3Fu);
+            if (cp >= 0x300 && cp <= 0x36F) {
+                // Diacriticos combinantes (texto em NFD): descartados.
+            }
+            else if (cp < 0x180) {
+                writer.latin(cp);
+            }
+            else {
+                writer.put(std::string_view(in.data() + i, 2));
+            }
+            i += 2;
+            continue;
+        }
+
+        // Tres e quatro bytes: pontuacao geral (U+2000-U+206F: aspas curvas, travessoes) separa; o resto e copiado.
+        size_t length = (c >= 0xE0 && c <= 0xEF) ? 3 : (c >= 0xF0 && c <= 0xF4) ? 4 : 0;
+        if (length > 0 && i + length <= n) {
+            bool valid = true;
+            for (size_t k = 1; k < length; ++k) valid = valid && isContinuation(s[i + k]);
+            if (valid) {
+                if (c == 0xE2 && (s[i + 1] == 0x80 || s[i + 1] == 0x81)) writer.separator();
+                else writer.put(std::string_view(in.data() + i, length));
+                i += length;
+                continue;
+            }
+        }
+
+        // Byte solto: Latin-1.
+        writer.latin(c);
+        ++i;
+    }
+}
+
+std::string TextNormalizer::normalize(std::string_view in) {
+    std::string out;
+    normalize(in, out);
+    return out;
+}
\ No newline at end of file
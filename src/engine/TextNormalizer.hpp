@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace FindTheBug {
+
+    // Normalizacao usada por todo o casamento de respostas:
+    // minusculas, sem acentos (U+00C0-U+017F), pontuacao vira espaco, espacos colapsados e aparados.
+    // Bytes que nao formam UTF-8 valido sao lidos como Latin-1.
+    class TextNormalizer {
+    public:
+        static void normalize(std::string_view in, std::string& out);
+        static std::string normalize(std::string_view in);
+    };
+}
\ No newline at end of file
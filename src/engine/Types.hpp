@@ -1,16 +1,48 @@
 #pragma once
 
 #include "../shared/DTOs.hpp"
+#include "KeywordMatcher.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace FindTheBug {
 
-	struct ActionResult {
-		bool success{ false };
-		int pointsSpent{ 0 };
-		std::optional<Clue> unlockedClue;
-		std::string message;
+	inline constexpr size_t kActionTypeCount = static_cast<size_t>(ActionType::SkipTurn) + 1;
+
+	// CaseRules achatadas em tabelas indexadas por ActionType. Montadas uma vez quando o caso e carregado.
+	struct CompiledRules {
+		std::array<int, kActionTypeCount> baseCost{};
+		std::array<int, kActionTypeCount> discountedCost{};
+		std::array<CostDiscount, kActionTypeCount> discountWhen{};
+		std::array<int8_t, kActionTypeCount> clueType{};
+
+		int pointsPerDay{ 12 };
+		int dayLimit{ 5 };
+		std::chrono::seconds clueRevealBonus{ 30 };
+		int rejectionPenaltyDays{ 2 };
+
+		// (targetId, ClueType) -> indice em BugCase::availableClues
+		std::unordered_map<std::string, uint32_t> clueIndex;
+
+		static std::string clueKey(const std::string& targetId, ClueType type) {
+			std::string key;
+			key.reserve(targetId.size() + 2);
+			key += targetId;
+			key += '\x1f';
+			key += static_cast<char>('0' + static_cast<int>(type));
+			return key;
+		}
+	};
+
+	struct CompiledCase {
+		BugCase data;
+		CompiledRules rules;
+		std::vector<KeywordMatcher> answerMatchers; // um por resposta, conceitos de data.answerConcepts
+		InvestigationCoverage coverageTotals;       // nos da topologia e pistas disponiveis
 	};
 
 	struct ProcessResult {
@@ -18,13 +50,64 @@ namespace FindTheBug {
 		GameState newState;
 		std::string message;
 		std::optional<Clue> revealedClue;
+		int revealBonusSeconds{ 0 };
+	};
+
+	enum class CommandKind {
+		GameAction,
+		SaveNote
+	};
+
+	struct Command {
+		CommandKind kind{ CommandKind::GameAction };
+		std::string playerId;
+		ActionType actionType{ ActionType::SkipTurn };
+		std::string targetId;
+		std::string clueId;
+		std::string content;
+	};
+
+	struct CommandResult {
+		bool success{ false };
+		std::string message;
+		std::optional<Clue> revealedClue;
+		int revealBonusSeconds{ 0 };
+	};
+
+	struct BatchResult {
+		bool success{ false };
+		GameState newState;
+		std::vector<CommandResult> results;
+		std::string message;
+	};
+
+	// Fim de partida ou penalidade gravados; newState e a pos-imagem, ausente se a sessao nao existe ou a
+	// gravacao nao passou.
+	struct FinalizeResult {
+		GameResult outcome{ GameResult::Running };
+		std::optional<GameState> newState;
+	};
+
+	struct ConceptCoverage {
+		std::vector<std::string> covered;
+		std::vector<std::string> missing;
 	};
 
 	struct ValidationResult {
 		bool isCorrect{ false };
 		int score{ 0 };
 		std::vector<std::string> feedbackPerQuestion;
+		std::vector<double> confidencePerQuestion;
+		std::vector<ConceptCoverage> conceptsPerQuestion;
 		std::string generalMessage;
 	};
 
+	// Solucao encaminhada ao Mestre: a analise e o estado gravado ao registrar a atividade.
+	struct SubmissionResult {
+		bool success{ false };
+		GameState newState;
+		ValidationResult review;
+		std::string message;
+	};
+
 }
\ No newline at end of file
@@ -1,57 +1,125 @@
 #include "ValidationSystem.hpp"
 #include <format>
-#include <cctype>
 #include <algorithm>
 #include <string>
 
 using namespace FindTheBug;
 
-static std::string normalizeString(const std::string& s) {
-    std::string result;
-    result.reserve(s.size());
-    for (unsigned char c : s) {
-        result += static_cast<char>(std::tolower(c));
+static constexpr double kLikelyCorrect = 0.8;
+static constexpr double kUncertain = 0.5;
+
+static const char* suggestionLabel(double confidence) {
+    if (confidence >= kLikelyCorrect) return "Parece Correto";
+    if (confidence >= kUncertain) return "Incerto";
+    return "Parece Incorreto";
+}
+
+static std::string joinLabels(const std::vector<std::string>& labels) {
+    std::string out;
+    for (const auto& label : labels) {
+        if (!out.empty()) out += ", ";
+        out += label;
     }
-    return result;
+    return out;
+}
+
+std::vector<KeywordMatcher> ValidationSystem::compileAnswerMatchers(const BugCase& bugCase) {
+    std::vector<KeywordMatcher> matchers(bugCase.answerConcepts.size());
+    std::string folded;
+
+    for (size_t i = 0; i < bugCase.answerConcepts.size(); ++i) {
+        const auto& concepts = bugCase.answerConcepts[i];
+        size_t count = std::min(concepts.size(), KeywordMatcher::kMaxConcepts);
+
+        for (size_t c = 0; c < count; ++c) {
+            for (const auto& term : concepts[c].terms) {
+                TextNormalizer::normalize(term, folded);
+                matchers[i].addPattern(folded, static_cast<uint32_t>(c));
+            }
+        }
+        matchers[i].build();
+    }
+
+    return matchers;
 }
 
-bool ValidationSystem::suggestMatch(const std::string& submitted, const std::string& expected) const {
-    std::string s1 = normalizeString(submitted);
-    std::string s2 = normalizeString(expected);
+MatchScore ValidationSystem::suggestMatch(const std::string& submitted, const std::string& expected) const {
+    thread_local std::string s1;
+    thread_local std::string s2;
+    TextNormalizer::normalize(submitted, s1);
+    TextNormalizer::normalize(expected, s2);
 
-    return s1.find(s2) != std::string::npos || s2.find(s1) != std::string::npos;
+    return FuzzyMatcher::score(s1, s2);
+}
+
+ConceptCoverage ValidationSystem::coverConcepts(const std::string& submitted, const CompiledCase& compiledCase, size_t index) const {
+    ConceptCoverage coverage;
+    if (index >= compiledCase.answerMatchers.size()) return coverage;
+
+    const auto& matcher = compiledCase.answerMatchers[index];
+    if (matcher.empty()) return coverage;
+
+    thread_local std::string folded;
+    TextNormalizer::normalize(submitted, folded);
+    uint64_t found = matcher.scan(folded);
+
+    const auto& concepts = compiledCase.data.answerConcepts[index];
+    size_t count = std::min(concepts.size(), KeywordMatcher::kMaxConcepts);
+    for (size_t c = 0; c < count; ++c) {
+        const auto& ac = concepts[c];
+        const std::string& label = (ac.label.empty() && !ac.terms.empty()) ? ac.terms.front() : ac.label;
+        if (found & (1ULL << c)) coverage.covered.push_back(label);
+        else coverage.missing.push_back(label);
+    }
+    return coverage;
 }
 
 ValidationResult ValidationSystem::prepareForMaster(
     const std::vector<std::string>& playerAnswers,
-    const BugCase& bugCase) const {
+    const CompiledCase& compiledCase) const {
 
     ValidationResult result;
     result.isCorrect = false;
     result.score = 0;
     result.generalMessage = "Aguardando validacao do Mestre";
 
-    const auto& expected = bugCase.correctAnswers;
-    const auto& questions = bugCase.solutionQuestions;
+    const auto& expected = compiledCase.data.correctAnswers;
+    const auto& questions = compiledCase.data.solutionQuestions;
 
     size_t count = std::max(questions.size(), playerAnswers.size());
 
     for (size_t i = 0; i < count; ++i) {
+        bool answered = i < playerAnswers.size();
         std::string question = (i < questions.size()) ? questions[i] : "Pergunta Extra";
-        std::string submitted = (i < playerAnswers.size()) ? playerAnswers[i] : "[SEM RESPOSTA]";
+        std::string submitted = answered ? playerAnswers[i] : "[SEM RESPOSTA]";
         std::string gabarito = (i < expected.size()) ? expected[i] : "[GABARITO INDEFINIDO]";
 
-        bool autoMatch = suggestMatch(submitted, gabarito);
+        double confidence = (answered && i < expected.size()) ? suggestMatch(submitted, gabarito).confidence : 0.0;
+        ConceptCoverage coverage = answered ? coverConcepts(submitted, compiledCase, i) : ConceptCoverage{};
+
+        // Conceitos definidos pelo autor do caso contam tanto quanto a semelhanca textual.
+        size_t conceptTotal = coverage.covered.size() + coverage.missing.size();
+        if (conceptTotal > 0) {
+            confidence = std::max(confidence, static_cast<double>(coverage.covered.size()) / static_cast<double>(conceptTotal));
+        }
 
         std::string feedback = std::format(
-            "Pergunta: {}\nResposta Equipe: {}\nGabarito: {}\nSugestao do Sistema: {}",
+            "Pergunta: {}\nResposta Equipe: {}\nGabarito: {}\nSugestao do Sistema: {} ({:.0f}%)",
             question,
             submitted,
             gabarito,
-            (autoMatch ? "Parece Correto" : "Parece Incorreto")
+            suggestionLabel(confidence),
+            confidence * 100.0
         );
 
-        result.feedbackPerQuestion.push_back(feedback);
+        if (conceptTotal > 0) {
+            feedback += std::format("\nConceitos: {}/{}", coverage.covered.size(), conceptTotal);
+            if (!coverage.missing.empty()) feedback += std::format(" (faltando: {})", joinLabels(coverage.missing));
+        }
+
+        result.feedbackPerQuestion.push_back(std::move(feedback));
+        result.confidencePerQuestion.push_back(confidence);
+        result.conceptsPerQuestion.push_back(std::move(coverage));
     }
 
     return result;
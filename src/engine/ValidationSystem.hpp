@@ -3,18 +3,24 @@
 #include <vector>
 #include <string>
 #include "Types.hpp"
+#include "FuzzyMatcher.hpp"
+#include "TextNormalizer.hpp"
 #include "../shared/DTOs.hpp"
 
 namespace FindTheBug {
 
     class ValidationSystem {
     public:
+        // Um automato por resposta com todos os termos dos seus conceitos. Montado uma vez por caso.
+        static std::vector<KeywordMatcher> compileAnswerMatchers(const BugCase& bugCase);
+
         ValidationResult prepareForMaster(
             const std::vector<std::string>& playerAnswers,
-            const BugCase& bugCase
+            const CompiledCase& compiledCase
         ) const;
 
     private:
-        bool suggestMatch(const std::string& submitted, const std::string& expected) const;
+        MatchScore suggestMatch(const std::string& submitted, const std::string& expected) const;
+        ConceptCoverage coverConcepts(const std::string& submitted, const CompiledCase& compiledCase, size_t index) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "TaskArena.hpp"
+#include <algorithm>
+
+namespace FindTheBug {
+
+	static thread_local TaskArena* currentArena = nullptr;
+
+	void* TaskArena::OverflowCounter::do_allocate(size_t size, size_t alignment) {
+		bytes += size;
+		return std::pmr::new_delete_resource()->allocate(size, alignment);
+	}
+
+	void TaskArena::OverflowCounter::do_deallocate(void* p, size_t size, size_t alignment) {
+		std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+	}
+
+	TaskArena::TaskArena(size_t initialCapacity, size_t maxCapacity)
+		: capacity(initialCapacity), maxCapacity(std::max(initialCapacity, maxCapacity)) {
+		rebuild();
+	}
+
+	void TaskArena::rebuild() {
+		monotonic.reset();
+		buffer = std::make_unique<std::byte[]>(capacity);
+		monotonic.emplace(buffer.get(), capacity, &overflow);
+	}
+
+	void TaskArena::reset() {
+		monotonic->release();
+
+		if (overflow.bytes > 0 && capacity < maxCapacity) {
+			capacity = std::min(maxCapacity, std::max(capacity * 2, capacity + overflow.bytes));
+			rebuild();
+		}
+		overflow.bytes = 0;
+	}
+
+	std::pmr::memory_resource* TaskArena::current() {
+		return currentArena ? currentArena->resource() : std::pmr::get_default_resource();
+	}
+
+	void TaskArena::bind(TaskArena* arena) {
+		currentArena = arena;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace FindTheBug {
+
+	// Arena monotonic de um worker da TaskQueue, liberada de uma vez ao fim de cada tarefa.
+	// Dados alocados nela nao podem sobreviver a tarefa (nem ser capturados por outra tarefa).
+	class TaskArena {
+	public:
+		explicit TaskArena(size_t initialCapacity, size_t maxCapacity);
+
+		TaskArena(const TaskArena&) = delete;
+		TaskArena& operator=(const TaskArena&) = delete;
+
+		std::pmr::memory_resource* resource() { return &*monotonic; }
+		void reset();
+
+		// Arena do worker atual; fora de um worker retorna o alocador padrao.
+		static std::pmr::memory_resource* current();
+		static void bind(TaskArena* arena);
+
+	private:
+		// Conta o que transbordou do buffer inicial, para dimensionar o proximo.
+		class OverflowCounter : public std::pmr::memory_resource {
+		public:
+			size_t bytes{ 0 };
+
+		private:
+			void* do_allocate(size_t size, size_t alignment) override;
+			void do_deallocate(void* p, size_t size, size_t alignment) override;
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+		};
+
+		void rebuild();
+
+		size_t capacity;
+		size_t maxCapacity;
+		std::unique_ptr<std::byte[]> buffer;
+		OverflowCounter overflow;
+		std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+	};
+}
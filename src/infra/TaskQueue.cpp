@@ -1,10 +1,14 @@
 #include "TaskQueue.hpp"
+#include "TaskArena.hpp"
 #include <print>
 
 namespace FindTheBug {
+
+	static constexpr size_t kArenaInitialBytes = 64 * 1024;
+	static constexpr size_t kArenaMaxBytes = 1024 * 1024;
 	
-	TaskQueue::TaskQueue(size_t numWorkers)
-		: stop(false) {
+	TaskQueue::TaskQueue(size_t numWorkers, size_t capacity)
+		: capacity_(capacity), stop(false) {
 		
 		size_t threadsToCreate = numWorkers > 0 ? numWorkers : 1;
 
@@ -15,13 +19,17 @@ namespace FindTheBug {
 	}
 
 	TaskQueue::~TaskQueue() {
+		shutdown();
+	}
+
+	void TaskQueue::shutdown() {
 		{
 			std::unique_lock<std::mutex> lock(queueMutex);
 			stop = true;
 		}
 		cv.notify_all();
 		for (auto& worker : workers) {
-			if (worker.joinable()) {
+			if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
 				worker.join();
 			}
 		}
@@ -35,17 +43,42 @@ namespace FindTheBug {
 		cv.notify_one();
 	}
 
+	bool TaskQueue::tryEnqueue(std::function<void()> task, size_t headroom) {
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			if (capacity_ != 0 && tasks.size() >= capacity_ + headroom) return false;
+			tasks.push(std::move(task));
+		}
+		cv.notify_one();
+		return true;
+	}
+
+	size_t TaskQueue::depth() {
+		std::unique_lock<std::mutex> lock(queueMutex);
+		return tasks.size();
+	}
+
+	bool TaskQueue::waitIdle(std::chrono::milliseconds timeout) {
+		std::unique_lock<std::mutex> lock(queueMutex);
+		return idleCv.wait_for(lock, timeout, [this]() { return tasks.empty() && running == 0; });
+	}
+
 	void TaskQueue::workerLoop() {
+		TaskArena arena(kArenaInitialBytes, kArenaMaxBytes);
+		TaskArena::bind(&arena);
+
 		while (true) {
 			std::function<void()> task;
 			{
 				std::unique_lock<std::mutex> lock(queueMutex);
 				cv.wait(lock, [this]() { return stop || !tasks.empty(); });
 				if (stop && tasks.empty()) {
+					TaskArena::bind(nullptr);
 					return;
 				}
 				task = std::move(tasks.front());
 				tasks.pop();
+				++running;
 			}
 			try {
 				task();
@@ -56,6 +89,14 @@ namespace FindTheBug {
 			catch (...) {
 				std::print("[TaskQueue] Unknown exception in task");
 			}
+			task = nullptr;
+			arena.reset();
+
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				--running;
+				if (running == 0 && tasks.empty()) idleCv.notify_all();
+			}
 		}
 	}
 }
\ No newline at end of file
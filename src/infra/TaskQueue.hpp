@@ -6,17 +6,31 @@
 #include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <vector>
 
 namespace FindTheBug {
 	
 	class TaskQueue {
 	public:
-		explicit TaskQueue(size_t numWorkers = std::thread::hardware_concurrency());
+		// capacity: limite de tarefas pendentes para tryEnqueue (0 = sem limite).
+		explicit TaskQueue(size_t numWorkers = std::thread::hardware_concurrency(), size_t capacity = 0);
 		~TaskQueue();
 
 		TaskQueue(const TaskQueue&) = delete;
+		// Trabalho interno (prazos, encerramentos): sempre aceito, mesmo acima da capacidade.
 		void enqueue(std::function<void()> task);
+		// Trabalho vindo de clientes: false com a fila cheia, e a tarefa nao e executada. headroom amplia o
+		// limite para quem nao deve disputar a capacidade com o resto (veredito do Mestre).
+		bool tryEnqueue(std::function<void()> task, size_t headroom = 0);
+
+		size_t depth();
+		// Espera a fila esvaziar e as tarefas em execucao terminarem; false se o prazo venceu antes.
+		bool waitIdle(std::chrono::milliseconds timeout);
+		// Executa o que ja esta na fila (inclusive o que essas tarefas enfileirarem) e junta os workers.
+		// Depois daqui nada mais roda; o destrutor chama se ninguem chamou antes.
+		void shutdown();
+		size_t capacity() const { return capacity_; }
 
 	private:
 		std::vector<std::thread> workers;
@@ -24,7 +38,10 @@ namespace FindTheBug {
 
 		std::mutex queueMutex;
 		std::condition_variable cv;
+		std::condition_variable idleCv;
+		size_t running{ 0 };
 
+		const size_t capacity_;
 		bool stop;
 		void workerLoop();
 	};
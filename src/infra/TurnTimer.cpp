@@ -0,0 +1,116 @@
+#include "TurnTimer.hpp"
+#include <print>
+
+namespace FindTheBug {
+
+	TurnTimer::TurnTimer(Callback onExpire)
+		: onExpire(std::move(onExpire)) {
+		worker = std::thread(&TurnTimer::run, this);
+	}
+
+	TurnTimer::~TurnTimer() {
+		stop();
+	}
+
+	void TurnTimer::stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cv.notify_all();
+		if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+			worker.join();
+		}
+	}
+
+	void TurnTimer::schedule(const std::string& sessionId, Clock::time_point deadline) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pushLocked(sessionId, deadline);
+		}
+		cv.notify_one();
+	}
+
+	void TurnTimer::expedite(const std::string& sessionId, Clock::time_point deadline) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = live.find(sessionId);
+			if (it == live.end() || it->second.deadline <= deadline) return;
+			pushLocked(sessionId, deadline);
+		}
+		cv.notify_one();
+	}
+
+	void TurnTimer::cancel(const std::string& sessionId) {
+		std::lock_guard<std::mutex> lock(mutex);
+		live.erase(sessionId);
+	}
+
+	size_t TurnTimer::pending() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return live.size();
+	}
+
+	void TurnTimer::pushLocked(const std::string& sessionId, Clock::time_point deadline) {
+		uint64_t generation = nextGeneration++;
+		live[sessionId] = { generation, deadline };
+		heap.push({ deadline, generation, sessionId });
+
+		if (heap.size() > 2 * live.size() + 64) {
+			compactLocked();
+		}
+	}
+
+	void TurnTimer::compactLocked() {
+		std::vector<Entry> entries;
+		entries.reserve(live.size());
+		for (const auto& [sessionId, l] : live) {
+			entries.push_back({ l.deadline, l.generation, sessionId });
+		}
+		heap = std::priority_queue<Entry, std::vector<Entry>, Later>(Later{}, std::move(entries));
+	}
+
+	void TurnTimer::run() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (!stopping) {
+			if (heap.empty()) {
+				cv.wait(lock, [this]() { return stopping || !heap.empty(); });
+				continue;
+			}
+
+			auto deadline = heap.top().deadline;
+			if (Clock::now() < deadline) {
+				cv.wait_until(lock, deadline);
+				continue;
+			}
+
+			std::vector<std::string> expired;
+			auto now = Clock::now();
+			while (!heap.empty() && heap.top().deadline <= now) {
+				Entry entry = heap.top();
+				heap.pop();
+
+				auto it = live.find(entry.sessionId);
+				if (it == live.end() || it->second.generation != entry.generation) continue;
+
+				live.erase(it);
+				expired.push_back(std::move(entry.sessionId));
+			}
+
+			lock.unlock();
+			for (const auto& sessionId : expired) {
+				try {
+					onExpire(sessionId);
+				}
+				catch (const std::exception& e) {
+					std::print("[TurnTimer] Exception in callback: {}\n", e.what());
+				}
+				catch (...) {
+					std::print("[TurnTimer] Unknown exception in callback\n");
+				}
+			}
+			lock.lock();
+		}
+	}
+}
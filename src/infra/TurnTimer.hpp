@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace FindTheBug {
+
+	// Min-heap de prazos de turno por sessao. Cada sessao tem no maximo um prazo vivo;
+	// reagendar invalida o anterior (remocao preguicosa pelo numero de geracao).
+	class TurnTimer {
+	public:
+		using Clock = std::chrono::system_clock;
+		using Callback = std::function<void(const std::string& sessionId)>;
+
+		explicit TurnTimer(Callback onExpire);
+		~TurnTimer();
+
+		TurnTimer(const TurnTimer&) = delete;
+		TurnTimer& operator=(const TurnTimer&) = delete;
+
+		void schedule(const std::string& sessionId, Clock::time_point deadline);
+		// Antecipa o prazo apenas se a sessao ja estiver agendada para depois de 'deadline'.
+		void expedite(const std::string& sessionId, Clock::time_point deadline);
+		void cancel(const std::string& sessionId);
+
+		size_t pending() const;
+
+		// Para e junta a thread: nenhum callback roda depois daqui. schedule/cancel continuam validos, sem efeito.
+		void stop();
+
+	private:
+		struct Entry {
+			Clock::time_point deadline;
+			uint64_t generation;
+			std::string sessionId;
+		};
+
+		struct Later {
+			bool operator()(const Entry& a, const Entry& b) const { return a.deadline > b.deadline; }
+		};
+
+		struct Live {
+			uint64_t generation;
+			Clock::time_point deadline;
+		};
+
+		void pushLocked(const std::string& sessionId, Clock::time_point deadline);
+		void compactLocked();
+		void run();
+
+		Callback onExpire;
+
+		mutable std::mutex mutex;
+		std::condition_variable cv;
+		std::priority_queue<Entry, std::vector<Entry>, Later> heap;
+		std::unordered_map<std::string, Live> live;
+		uint64_t nextGeneration{ 1 };
+		bool stopping{ false };
+
+		std::thread worker;
+	};
+
+}
@@ -0,0 +1,87 @@
+#include "Commands.hpp"
+#include "../engine/SharedNote.hpp"
+#include "../shared/DTOFields.hpp"
+
+using namespace FindTheBug;
+using namespace FindTheBug::Protocol;
+
+template <typename V>
+CommandType Protocol::commandTypeOf(const Json::BasicObject<V>& frame) {
+    // Nomes de tipo sao ASCII sem escape: compara direto no frame.
+    const V* type = frame.find("type");
+    std::string_view name;
+    if (!type || !type->toStringView(name)) return CommandType::Unknown;
+    return commandTypeOf(name);
+}
+
+template <typename V>
+DecodeStatus Protocol::decode(const Json::BasicObject<V>& frame, EditSharedNoteCommand& out) {
+    for (auto key : EditSharedNoteCommand::kRequired) {
+        if (!frame.has(key)) return DecodeStatus::Ignored;
+    }
+    if (!Json::readFields(frame, out)) return DecodeStatus::Ignored;
+
+    bool valid = true;
+    bool isList = frame.find("ops")->forEachElement([&](const V& item) {
+        NoteOp op;
+        if (!valid || !Json::read(item, op) || out.ops.size() == SharedNote::kMaxOpsPerEdit) {
+            valid = false;
+            return;
+        }
+        out.ops.push_back(std::move(op));
+    });
+    if (!isList) return DecodeStatus::Ignored;
+    return valid ? DecodeStatus::Ok : DecodeStatus::Invalid;
+}
+
+template <typename V>
+DecodeStatus Protocol::decode(const Json::BasicObject<V>& frame, GameBatchCommand& out) {
+    for (auto key : GameBatchCommand::kRequired) {
+        if (!frame.has(key)) return DecodeStatus::Ignored;
+    }
+    if (!Json::readFields(frame, out)) return DecodeStatus::Ignored;
+
+    // Resultados voltam indice a indice: um elemento malformado invalida o lote em vez de sumir dele.
+    auto readCommand = [](const V& item, Command& cmd) {
+        Json::BasicObject<V> c(item);
+        const V* kind = c.find("kind");
+        const V* playerId = c.find("playerId");
+        std::string kindName;
+        if (!kind || !playerId || !kind->toString(kindName) || !playerId->toString(cmd.playerId)) return false;
+
+        if (kindName == "GAME_ACTION") {
+            const V* actionType = c.find("actionType");
+            const V* targetId = c.find("targetId");
+            cmd.kind = CommandKind::GameAction;
+            return actionType && targetId && Json::read(*actionType, cmd.actionType) && targetId->toString(cmd.targetId);
+        }
+        if (kindName == "SAVE_NOTE") {
+            const V* clueId = c.find("clueId");
+            const V* content = c.find("content");
+            cmd.kind = CommandKind::SaveNote;
+            return clueId && content && clueId->toString(cmd.clueId) && content->toString(cmd.content);
+        }
+        return false;
+    };
+
+    bool valid = true;
+    bool isList = frame.find("commands")->forEachElement([&](const V& item) {
+        Command cmd;
+        if (!valid || out.commands.size() == GameBatchCommand::kMaxCommands || !readCommand(item, cmd)) {
+            valid = false;
+            return;
+        }
+        out.commands.push_back(std::move(cmd));
+    });
+    if (!isList) return DecodeStatus::Ignored;
+
+    if (!valid || out.commands.empty()) return DecodeStatus::Invalid;
+    return DecodeStatus::Ok;
+}
+
+template CommandType Protocol::commandTypeOf(const Json::Object&);
+template CommandType Protocol::commandTypeOf(const MsgPack::Object&);
+template DecodeStatus Protocol::decode<Json::Value>(const Json::Object&, EditSharedNoteCommand&);
+template DecodeStatus Protocol::decode<MsgPack::Value>(const MsgPack::Object&, EditSharedNoteCommand&);
+template DecodeStatus Protocol::decode<Json::Value>(const Json::Object&, GameBatchCommand&);
+template DecodeStatus Protocol::decode<MsgPack::Value>(const MsgPack::Object&, GameBatchCommand&);
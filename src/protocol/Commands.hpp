@@ -0,0 +1,323 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../engine/Types.hpp"
+#include "../shared/DTOs.hpp"
+#include "../shared/JsonScanner.hpp"
+#include "../shared/MsgPack.hpp"
+
+// Comandos recebidos pelo WebSocket. Cada tipo le so os campos que usa, direto do frame (Json::Object para
+// frames de texto, MsgPack::Object para binarios), e vira uma struct tipada que e movida para a tarefa.
+namespace FindTheBug::Protocol {
+
+    enum class CommandType : uint8_t {
+        CreateLobby,
+        JoinAsPlayer,
+        JoinAsMaster,
+        GetLobbyInfo,
+        StartGame,
+        CreateTournament,
+        SpectateTournament,
+        SubmitSolution,
+        ValidateSolution,
+        GameAction,
+        SaveNote,
+        EditSharedNote,
+        GameBatch,
+        Resync,
+        LeaveLobby,
+        Hello,
+        Pong,
+        Unknown
+    };
+
+    // Indexado por CommandType.
+    inline constexpr std::array<std::string_view, static_cast<size_t>(CommandType::Unknown)> kCommandNames = {
+        "CREATE_LOBBY", "JOIN_AS_PLAYER", "JOIN_AS_MASTER", "GET_LOBBY_INFO", "START_GAME",
+        "CREATE_TOURNAMENT", "SPECTATE_TOURNAMENT", "SUBMIT_SOLUTION", "VALIDATE_SOLUTION",
+        "GAME_ACTION", "SAVE_NOTE", "EDIT_SHARED_NOTE", "GAME_BATCH", "RESYNC", "LEAVE_LOBBY", "HELLO",
+        "PONG"
+    };
+
+    namespace detail {
+        inline constexpr size_t kTypeTableSize = 32;
+
+        constexpr uint32_t hashType(std::string_view name, uint32_t seed) {
+            uint32_t h = 2166136261u ^ seed;
+            for (char c : name) {
+                h ^= static_cast<uint8_t>(c);
+                h *= 16777619u;
+            }
+            // Mistura final (fmix32): sem ela os bits baixos do FNV nao dependem da semente.
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35u;
+            h ^= h >> 16;
+            return h;
+        }
+
+        // Primeira semente em que os nomes caem em posicoes distintas da tabela: hash perfeito,
+        // uma comparacao de string por mensagem.
+        constexpr uint32_t findTypeSeed() {
+            for (uint32_t seed = 0; seed < 1u << 16; ++seed) {
+                std::array<bool, kTypeTableSize> used{};
+                bool collision = false;
+                for (auto name : kCommandNames) {
+                    auto slot = hashType(name, seed) % kTypeTableSize;
+                    if (used[slot]) {
+                        collision = true;
+                        break;
+                    }
+                    used[slot] = true;
+                }
+                if (!collision) return seed;
+            }
+            throw "Protocol: sem semente livre de colisao";
+        }
+
+        inline constexpr uint32_t kTypeSeed = findTypeSeed();
+
+        constexpr std::array<CommandType, kTypeTableSize> buildTypeTable() {
+            std::array<CommandType, kTypeTableSize> table{};
+            table.fill(CommandType::Unknown);
+            for (size_t i = 0; i < kCommandNames.size(); ++i) {
+                table[hashType(kCommandNames[i], kTypeSeed) % kTypeTableSize] = static_cast<CommandType>(i);
+            }
+            return table;
+        }
+
+        inline constexpr auto kTypeTable = buildTypeTable();
+    }
+
+    constexpr CommandType commandTypeOf(std::string_view name) {
+        CommandType type = detail::kTypeTable[detail::hashType(name, detail::kTypeSeed) % detail::kTypeTableSize];
+        if (type == CommandType::Unknown || kCommandNames[static_cast<size_t>(type)] != name) return CommandType::Unknown;
+        return type;
+    }
+
+    static_assert(commandTypeOf("GAME_ACTION") == CommandType::GameAction);
+    static_assert(commandTypeOf("LEAVE_LOBBY") == CommandType::LeaveLobby);
+    static_assert(commandTypeOf("PONG") == CommandType::Pong);
+    static_assert(commandTypeOf("GAME_ACTIONS") == CommandType::Unknown);
+
+    // kRequired: campos que precisam estar no frame; sem eles a mensagem e ignorada.
+
+    // Formato das mensagens enviadas a esta conexao: "json" (padrao) ou "msgpack".
+    struct HelloCommand {
+        static constexpr std::array<std::string_view, 1> kRequired{ "encoding" };
+        std::string encoding;
+    };
+
+    struct CreateLobbyCommand {
+        static constexpr std::array<std::string_view, 1> kRequired{ "playerName" };
+        std::string playerName;
+    };
+
+    struct JoinAsPlayerCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "playerName" };
+        std::string sessionId;
+        std::string playerName;
+    };
+
+    struct JoinAsMasterCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "masterName" };
+        std::string sessionId;
+        std::string masterName;
+    };
+
+    // GET_LOBBY_INFO e RESYNC.
+    struct SessionCommand {
+        static constexpr std::array<std::string_view, 1> kRequired{ "sessionId" };
+        std::string sessionId;
+    };
+
+    struct StartGameCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "playerName" };
+        std::string sessionId;
+        std::string playerName;
+        std::string caseId{ "case_robotics_001" };
+        std::string tournamentId;
+    };
+
+    struct CreateTournamentCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "name", "caseId" };
+        std::string name;
+        std::string caseId;
+    };
+
+    struct SpectateTournamentCommand {
+        static constexpr std::array<std::string_view, 1> kRequired{ "tournamentId" };
+        std::string tournamentId;
+    };
+
+    struct SubmitSolutionCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "answers" };
+        std::string sessionId;
+        std::vector<std::string> answers;
+    };
+
+    struct ValidateSolutionCommand {
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "approved" };
+        std::string sessionId;
+        bool approved{ false };
+    };
+
+    struct GameActionCommand {
+        static constexpr std::array<std::string_view, 4> kRequired{ "sessionId", "playerId", "actionType", "targetId" };
+        std::string sessionId;
+        std::string playerId;
+        ActionType actionType{ ActionType::SkipTurn };
+        std::string targetId;
+    };
+
+    struct SaveNoteCommand {
+        static constexpr std::array<std::string_view, 4> kRequired{ "sessionId", "playerId", "clueId", "content" };
+        std::string sessionId;
+        std::string playerId;
+        std::string clueId;
+        std::string content;
+    };
+
+    struct EditSharedNoteCommand {
+        static constexpr std::array<std::string_view, 4> kRequired{ "sessionId", "playerId", "clueId", "ops" };
+        std::string sessionId;
+        std::string playerId;
+        std::string clueId;
+        std::vector<NoteOp> ops;
+    };
+
+    struct GameBatchCommand {
+        static constexpr size_t kMaxCommands = 64;
+        static constexpr std::array<std::string_view, 2> kRequired{ "sessionId", "commands" };
+        std::string sessionId;
+        std::vector<Command> commands;
+    };
+
+    enum class DecodeStatus {
+        Ok,
+        Ignored,  // falta campo obrigatorio ou um campo tem tipo errado: a mensagem e descartada
+        Invalid   // campos presentes mas inaceitaveis: o cliente recebe ERROR
+    };
+}
+
+namespace FindTheBug::Reflect {
+    template <> struct Descriptor<Protocol::HelloCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("encoding", &Protocol::HelloCommand::encoding));
+    };
+
+    template <> struct Descriptor<Protocol::CreateLobbyCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("playerName", &Protocol::CreateLobbyCommand::playerName));
+    };
+
+    template <> struct Descriptor<Protocol::JoinAsPlayerCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::JoinAsPlayerCommand::sessionId),
+            field("playerName", &Protocol::JoinAsPlayerCommand::playerName));
+    };
+
+    template <> struct Descriptor<Protocol::JoinAsMasterCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::JoinAsMasterCommand::sessionId),
+            field("masterName", &Protocol::JoinAsMasterCommand::masterName));
+    };
+
+    template <> struct Descriptor<Protocol::SessionCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::SessionCommand::sessionId));
+    };
+
+    template <> struct Descriptor<Protocol::StartGameCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::StartGameCommand::sessionId),
+            field("playerName", &Protocol::StartGameCommand::playerName),
+            field("caseId", &Protocol::StartGameCommand::caseId),
+            field("tournamentId", &Protocol::StartGameCommand::tournamentId));
+    };
+
+    template <> struct Descriptor<Protocol::CreateTournamentCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("name", &Protocol::CreateTournamentCommand::name),
+            field("caseId", &Protocol::CreateTournamentCommand::caseId));
+    };
+
+    template <> struct Descriptor<Protocol::SpectateTournamentCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("tournamentId", &Protocol::SpectateTournamentCommand::tournamentId));
+    };
+
+    template <> struct Descriptor<Protocol::SubmitSolutionCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::SubmitSolutionCommand::sessionId),
+            field("answers", &Protocol::SubmitSolutionCommand::answers));
+    };
+
+    template <> struct Descriptor<Protocol::ValidateSolutionCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::ValidateSolutionCommand::sessionId),
+            field("approved", &Protocol::ValidateSolutionCommand::approved));
+    };
+
+    template <> struct Descriptor<Protocol::GameActionCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::GameActionCommand::sessionId),
+            field("playerId", &Protocol::GameActionCommand::playerId),
+            field("actionType", &Protocol::GameActionCommand::actionType),
+            field("targetId", &Protocol::GameActionCommand::targetId));
+    };
+
+    template <> struct Descriptor<Protocol::SaveNoteCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::SaveNoteCommand::sessionId),
+            field("playerId", &Protocol::SaveNoteCommand::playerId),
+            field("clueId", &Protocol::SaveNoteCommand::clueId),
+            field("content", &Protocol::SaveNoteCommand::content));
+    };
+
+    // ops e commands ficam fora: sao validados elemento a elemento em decode().
+    template <> struct Descriptor<Protocol::EditSharedNoteCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::EditSharedNoteCommand::sessionId),
+            field("playerId", &Protocol::EditSharedNoteCommand::playerId),
+            field("clueId", &Protocol::EditSharedNoteCommand::clueId));
+    };
+
+    template <> struct Descriptor<Protocol::GameBatchCommand> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &Protocol::GameBatchCommand::sessionId));
+    };
+}
+
+namespace FindTheBug::Protocol {
+
+    // As funcoes abaixo valem para os dois formatos de frame (V = Json::Value ou MsgPack::Value);
+    // as nao inline sao instanciadas em Commands.cpp.
+
+    // Nome do tipo do frame; Unknown se ausente ou desconhecido.
+    template <typename V>
+    CommandType commandTypeOf(const Json::BasicObject<V>& frame);
+
+    template <typename V, typename T>
+    DecodeStatus decode(const Json::BasicObject<V>& frame, T& out) {
+        for (auto key : T::kRequired) {
+            if (!frame.has(key)) return DecodeStatus::Ignored;
+        }
+        return Json::readFields(frame, out) ? DecodeStatus::Ok : DecodeStatus::Ignored;
+    }
+
+    // Invalid se alguma operacao nao for objeto ou se passar de SharedNote::kMaxOpsPerEdit.
+    template <typename V>
+    DecodeStatus decode(const Json::BasicObject<V>& frame, EditSharedNoteCommand& out);
+
+    // Invalid se algum comando for malformado (kind desconhecido, campo ausente ou com tipo errado), se a lista
+    // estiver vazia ou passar de kMaxCommands: os resultados do lote correspondem um a um aos comandos enviados.
+    template <typename V>
+    DecodeStatus decode(const Json::BasicObject<V>& frame, GameBatchCommand& out);
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "../engine/SharedNote.hpp"
+#include "../engine/Types.hpp"
+#include "../shared/DTOFields.hpp"
+#include "../shared/DTOs.hpp"
+
+// Mensagens de saida do WebSocket montadas sobre um escritor incremental (Json::Writer ou MsgPack::Writer,
+// com a mesma interface). Ficam fora do servidor para que o simulador meca exatamente o que vai para a rede.
+namespace FindTheBug::Protocol {
+
+    // Logs de nota compartilhada maiores que isto vao compactados no snapshot.
+    inline constexpr size_t kSharedNoteCompactionThreshold = 64;
+
+    template <typename Writer>
+    void writeError(Writer& w, std::string_view message) {
+        w.beginObject()
+            .field("type", "ERROR")
+            .field("message", message)
+            .endObject();
+    }
+
+    // Comando recusado pelo controle de admissao; reason "rate" (frames demais) ou "busy" (servidor saturado).
+    // O cliente deve reenviar depois de retryAfterMs.
+    template <typename Writer>
+    void writeOverloaded(Writer& w, std::string_view reason, int64_t retryAfterMs) {
+        w.beginObject()
+            .field("type", "OVERLOADED")
+            .field("reason", reason)
+            .field("retryAfterMs", retryAfterMs)
+            .endObject();
+    }
+
+    // Heartbeat do servidor; o cliente responde cada um com {"type":"PONG"}, na ordem em que chegaram: o PONG tambem
+    // confirma a entrega do que saiu antes (controle de fluxo da Outbox). t: epoch em ms.
+    template <typename Writer>
+    void writePing(Writer& w, int64_t t) {
+        w.beginObject()
+            .field("type", "PING")
+            .field("t", t)
+            .endObject();
+    }
+
+    // Jogador ficou online ou offline (socket fechado ou sem resposta ao heartbeat). lastSeenMs: epoch em ms.
+    template <typename Writer>
+    void writePresence(Writer& w, std::string_view sessionId, std::string_view playerName, bool online, int64_t lastSeenMs) {
+        w.beginObject()
+            .field("type", "PRESENCE")
+            .field("sessionId", sessionId)
+            .field("playerName", playerName)
+            .field("online", online)
+            .field("lastSeen", lastSeenMs)
+            .endObject();
+    }
+
+    // Servidor em drain: o cliente reconecta depois de retryAfterMs (ja sorteado por conexao, para os clientes
+    // nao voltarem juntos) e, se falhar, recua exponencialmente com jitter ate maxBackoffMs.
+    template <typename Writer>
+    void writeReconnect(Writer& w, int64_t retryAfterMs, int64_t maxBackoffMs) {
+        w.beginObject()
+            .field("type", "RECONNECT")
+            .field("retryAfterMs", retryAfterMs)
+            .field("maxBackoffMs", maxBackoffMs)
+            .endObject();
+    }
+
+    // Roster sem o Mestre, que aparece so na tela dele.
+    template <typename Writer>
+    void writeLobbyUpdate(Writer& w, const LobbyInfo& lobby) {
+        w.beginObject()
+            .field("type", "LOBBY_UPDATE")
+            .field("sessionId", lobby.sessionId)
+            .field("canStart", lobby.canStartGame());
+
+        w.key("players").beginArray();
+        for (const auto& p : lobby.players) {
+            if (p.role == PlayerRole::Master) continue;
+            w.beginObject()
+                .field("name", p.name)
+                .field("role", p.role)
+                .endObject();
+        }
+        w.endArray().endObject();
+    }
+
+    // Cobertura como pares [descobertos, total].
+    template <typename Writer>
+    void writeCoverage(Writer& w, const InvestigationCoverage& found, const InvestigationCoverage& totals) {
+        auto pair = [&w](int f, int t) { w.beginArray().integer(f).integer(t).endArray(); };
+        auto target = [&](const char* key, TargetType type) {
+            w.key(key);
+            pair(found.targets[static_cast<size_t>(type)], totals.targets[static_cast<size_t>(type)]);
+        };
+
+        w.beginObject();
+        target("modules", TargetType::Module);
+        target("functions", TargetType::Function);
+        target("connections", TargetType::Connection);
+        w.key("clueTypes").beginArray();
+        for (size_t t = 0; t < kClueTypeCount; ++t) pair(found.clues[t], totals.clues[t]);
+        w.endArray().endObject();
+    }
+
+    template <typename Writer>
+    void writeTurn(Writer& w, const GameState& state) {
+        w.field("currentTurnIndex", state.currentTurnIndex);
+        if (!state.turnOrder.empty()) w.field("currentTurnPlayer", state.turnOrder[state.currentTurnIndex]);
+    }
+
+    // Estado completo. Base do cliente: patches com seq maior se aplicam sobre ele.
+    template <typename Writer>
+    void writeGameSnapshot(Writer& w, const GameState& state, uint64_t seq, const InvestigationCoverage& totals) {
+        w.beginObject()
+            .field("type", "GAME_STATE_UPDATE")
+            .field("sessionId", state.sessionId)
+            .field("seq", seq)
+            .field("revision", state.revision)
+            .field("currentDay", state.currentDay)
+            .field("remainingPoints", state.remainingPoints)
+            .field("isSuddenDeath", state.isSuddenDeath);
+        writeTurn(w, state);
+
+        bool longLogs = std::any_of(state.discoveredClues.begin(), state.discoveredClues.end(),
+            [](const DiscoveredClue& dc) { return dc.sharedNoteOps.size() > kSharedNoteCompactionThreshold; });
+        if (longLogs) {
+            // Quem entra agora recebe o log compactado: mesmo texto, bem menos operacoes.
+            auto clues = state.discoveredClues;
+            for (auto& dc : clues) {
+                if (dc.sharedNoteOps.size() > kSharedNoteCompactionThreshold) {
+                    dc.sharedNoteOps = SharedNote::replay(dc.sharedNoteOps).compact();
+                }
+            }
+            w.field("discoveredClues", clues);
+        }
+        else {
+            w.field("discoveredClues", state.discoveredClues);
+        }
+
+        w.key("coverage");
+        writeCoverage(w, state.coverage, totals);
+        w.endObject();
+    }
+
+    template <typename Writer>
+    void writeClueRevealed(Writer& w, const Clue& clue, int durationSeconds, std::string_view investigator) {
+        w.beginObject()
+            .field("type", "CLUE_REVEALED")
+            .field("clueId", clue.id)
+            .field("content", clue.content)
+            .field("duration", durationSeconds)
+            .field("investigator", investigator)
+            .endObject();
+    }
+
+    // Respostas do time ao lado do gabarito, com a sugestao automatica em porcentagem;
+    // a decisao continua com o Mestre.
+    template <typename Writer>
+    void writeSolutionForReview(Writer& w, std::string_view sessionId, const std::vector<std::string>& answers,
+        const BugCase& bugCase, const ValidationResult& review) {
+        w.beginObject()
+            .field("type", "SOLUTION_FOR_REVIEW")
+            .field("sessionId", sessionId)
+            .field("teamAnswers", answers)
+            .field("questions", bugCase.solutionQuestions)
+            .field("correctAnswers", bugCase.correctAnswers);
+
+        w.key("confidence").beginArray();
+        for (double c : review.confidencePerQuestion) w.integer(static_cast<long long>(c * 100.0 + 0.5));
+        w.endArray();
+
+        w.key("concepts").beginArray();
+        for (size_t i = 0; i < review.conceptsPerQuestion.size(); ++i) {
+            w.beginObject()
+                .field("question", i)
+                .field("covered", review.conceptsPerQuestion[i].covered)
+                .field("missing", review.conceptsPerQuestion[i].missing)
+                .endObject();
+        }
+        w.endArray().endObject();
+    }
+}
@@ -0,0 +1,148 @@
+#include "AdmissionControl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <functional>
+
+using namespace FindTheBug;
+
+namespace {
+
+    constexpr std::array<const char*, kMessageClassCount> kClassNames = { "lobby", "query", "game", "control" };
+}
+
+std::chrono::milliseconds AdmissionControl::TokenBucket::take(const Limits& limits, std::chrono::steady_clock::time_point now) {
+    if (refilled == std::chrono::steady_clock::time_point{}) {
+        tokens = limits.burst;
+    }
+    else {
+        double elapsed = std::chrono::duration<double>(now - refilled).count();
+        tokens = std::min(limits.burst, tokens + elapsed * limits.rate);
+    }
+    refilled = now;
+
+    if (tokens >= 1.0) {
+        tokens -= 1.0;
+        return std::chrono::milliseconds{ 0 };
+    }
+    auto wait = std::chrono::duration<double, std::milli>((1.0 - tokens) / limits.rate);
+    return std::chrono::milliseconds{ static_cast<int64_t>(std::ceil(wait.count())) };
+}
+
+AdmissionControl::ConnectionShard& AdmissionControl::shardFor(crow::websocket::connection* conn) {
+    return connections[(reinterpret_cast<uintptr_t>(conn) >> 4) % kShards];
+}
+
+AdmissionControl::SessionShard& AdmissionControl::shardFor(const std::string& sessionId) {
+    return sessions[std::hash<std::string>{}(sessionId) % kShards];
+}
+
+FrameAdmission AdmissionControl::admitFrame(crow::websocket::connection* conn, const std::string& sessionId) {
+    auto now = std::chrono::steady_clock::now();
+    auto& connShard = shardFor(conn);
+
+    std::chrono::milliseconds wait{ 0 };
+    {
+        std::lock_guard lock(connShard.mutex);
+        auto& bucket = connShard.buckets[conn];
+        wait = bucket.take(kConnectionLimits, now);
+        if (wait.count() > 0) {
+            connectionRateLimited.fetch_add(1, std::memory_order_relaxed);
+            bool notify = !bucket.refusing;
+            bucket.refusing = true;
+            return { false, notify, wait };
+        }
+        if (sessionId.empty()) {
+            bucket.refusing = false;
+            return {};
+        }
+    }
+
+    {
+        auto& sessionShard = shardFor(sessionId);
+        std::lock_guard lock(sessionShard.mutex);
+        wait = sessionShard.buckets[sessionId].take(kSessionLimits, now);
+    }
+
+    // O aviso e por conexao: cada cliente da sessao saturada ouve uma vez, nao a cada frame.
+    std::lock_guard lock(connShard.mutex);
+    auto it = connShard.buckets.find(conn);
+    bool wasRefusing = it != connShard.buckets.end() && it->second.refusing;
+    if (it != connShard.buckets.end()) it->second.refusing = wait.count() > 0;
+    if (wait.count() == 0) return {};
+
+    sessionRateLimited.fetch_add(1, std::memory_order_relaxed);
+    return { false, !wasRefusing, wait };
+}
+
+bool AdmissionControl::acquire(MessageClass cls) {
+    auto i = static_cast<size_t>(cls);
+    size_t limit = kInFlightLimits[i];
+    if (inFlight[i].fetch_add(1, std::memory_order_acq_rel) >= limit) {
+        inFlight[i].fetch_sub(1, std::memory_order_acq_rel);
+        shed[i].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AdmissionControl::release(MessageClass cls) {
+    inFlight[static_cast<size_t>(cls)].fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void AdmissionControl::admitted(MessageClass cls) {
+    accepted[static_cast<size_t>(cls)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AdmissionControl::rejectQueued(MessageClass cls) {
+    release(cls);
+    shed[static_cast<size_t>(cls)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AdmissionControl::forgetConnection(crow::websocket::connection* conn) {
+    auto& shard = shardFor(conn);
+    std::lock_guard lock(shard.mutex);
+    shard.buckets.erase(conn);
+}
+
+void AdmissionControl::forgetSession(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    shard.buckets.erase(sessionId);
+}
+
+void AdmissionControl::evictIdle(std::chrono::steady_clock::duration maxIdle) {
+    auto cutoff = std::chrono::steady_clock::now() - maxIdle;
+    for (auto& shard : sessions) {
+        std::lock_guard lock(shard.mutex);
+        std::erase_if(shard.buckets, [&](const auto& entry) { return entry.second.refilled < cutoff; });
+    }
+}
+
+void AdmissionControl::writeMetrics(std::string& out, size_t queueDepth, size_t queueCapacity) {
+    auto load = [](const auto& counter) { return counter.load(std::memory_order_relaxed); };
+
+    out += "# HELP findthebug_ws_frames_rate_limited_total Frames recusados pelo token bucket.\n";
+    out += "# TYPE findthebug_ws_frames_rate_limited_total counter\n";
+    out += std::format("findthebug_ws_frames_rate_limited_total{{scope=\"connection\"}} {}\n", load(connectionRateLimited));
+    out += std::format("findthebug_ws_frames_rate_limited_total{{scope=\"session\"}} {}\n", load(sessionRateLimited));
+
+    out += "# HELP findthebug_ws_commands_total Comandos por classe e desfecho da admissao.\n";
+    out += "# TYPE findthebug_ws_commands_total counter\n";
+    for (size_t i = 0; i < kMessageClassCount; ++i) {
+        out += std::format("findthebug_ws_commands_total{{class=\"{}\",outcome=\"accepted\"}} {}\n", kClassNames[i], load(accepted[i]));
+        out += std::format("findthebug_ws_commands_total{{class=\"{}\",outcome=\"shed\"}} {}\n", kClassNames[i], load(shed[i]));
+    }
+
+    out += "# HELP findthebug_ws_commands_in_flight Tarefas na fila ou em execucao por classe.\n";
+    out += "# TYPE findthebug_ws_commands_in_flight gauge\n";
+    for (size_t i = 0; i < kMessageClassCount; ++i) {
+        out += std::format("findthebug_ws_commands_in_flight{{class=\"{}\"}} {}\n", kClassNames[i], load(inFlight[i]));
+    }
+
+    out += "# TYPE findthebug_task_queue_depth gauge\n";
+    out += std::format("findthebug_task_queue_depth {}\n", queueDepth);
+    out += "# TYPE findthebug_task_queue_capacity gauge\n";
+    out += std::format("findthebug_task_queue_capacity {}\n", queueCapacity);
+}
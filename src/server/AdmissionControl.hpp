@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "crow.h"
+
+namespace FindTheBug {
+
+    // Classes de comando com limite proprio de tarefas simultaneas (na fila ou em execucao).
+    // Control (veredito do Mestre) tem limite baixo e folga reservada na TaskQueue: uma rajada de jogo nao o tira
+    // da fila, mas ele tambem nao cresce sem limite.
+    enum class MessageClass : uint8_t { Lobby, Query, Game, Control };
+    inline constexpr size_t kMessageClassCount = 4;
+
+    struct FrameAdmission {
+        bool accepted{ true };
+        // So a primeira recusa de uma rajada avisa o cliente; as demais sao descartadas em silencio.
+        bool notify{ false };
+        std::chrono::milliseconds retryAfter{ 0 };
+    };
+
+    // Controle de admissao do WebSocket: token bucket por conexao e por sessao antes de decodificar o frame,
+    // e limite de tarefas em voo por classe antes de ocupar a TaskQueue. Os contadores saem em GET /metrics.
+    class AdmissionControl {
+    public:
+        struct Limits {
+            double rate;   // fichas por segundo
+            double burst;  // capacidade do balde
+        };
+        static constexpr Limits kConnectionLimits{ 20.0, 40.0 };
+        // A sessao inteira (ate 8 jogadores e o Mestre) divide este balde.
+        static constexpr Limits kSessionLimits{ 60.0, 120.0 };
+        // Indexado por MessageClass.
+        static constexpr std::array<size_t, kMessageClassCount> kInFlightLimits{ 64, 128, 512, 32 };
+        // Vagas da TaskQueue alem da capacidade, por classe.
+        static constexpr std::array<size_t, kMessageClassCount> kQueueHeadroom{ 0, 0, 0, 32 };
+        static constexpr std::chrono::milliseconds kBusyRetryAfter{ 500 };
+
+        // Reserva uma vaga da classe durante a vida do objeto (dentro da tarefa, para liberar mesmo com excecao).
+        class Slot {
+        public:
+            Slot(AdmissionControl& admission, MessageClass cls) : admission(admission), cls(cls) {}
+            ~Slot() { admission.release(cls); }
+            Slot(const Slot&) = delete;
+            Slot& operator=(const Slot&) = delete;
+
+        private:
+            AdmissionControl& admission;
+            MessageClass cls;
+        };
+
+        // sessionId vazio: conexao ainda sem sessao, so o balde da conexao conta.
+        FrameAdmission admitFrame(crow::websocket::connection* conn, const std::string& sessionId);
+
+        // false: classe saturada (ja contado como descarte). A vaga so conta como aceita em admitted().
+        bool acquire(MessageClass cls);
+        void release(MessageClass cls);
+        // Tarefa entrou na TaskQueue.
+        void admitted(MessageClass cls);
+        // Vaga obtida, mas a TaskQueue recusou a tarefa.
+        void rejectQueued(MessageClass cls);
+
+        void forgetConnection(crow::websocket::connection* conn);
+        void forgetSession(const std::string& sessionId);
+        // Sessoes sem trafego ha mais de maxIdle (lobbies abandonados nao passam por forgetSession).
+        void evictIdle(std::chrono::steady_clock::duration maxIdle);
+
+        // Formato de texto do Prometheus.
+        void writeMetrics(std::string& out, size_t queueDepth, size_t queueCapacity);
+
+    private:
+        struct TokenBucket {
+            double tokens{ 0 };
+            std::chrono::steady_clock::time_point refilled;
+            bool refusing{ false };
+
+            // Tempo ate a proxima ficha; zero se consumiu uma agora.
+            std::chrono::milliseconds take(const Limits& limits, std::chrono::steady_clock::time_point now);
+        };
+
+        static constexpr size_t kShards = 32;
+
+        struct ConnectionShard {
+            std::mutex mutex;
+            std::unordered_map<crow::websocket::connection*, TokenBucket> buckets;
+        };
+
+        struct SessionShard {
+            std::mutex mutex;
+            std::unordered_map<std::string, TokenBucket> buckets;
+        };
+
+        ConnectionShard& shardFor(crow::websocket::connection* conn);
+        SessionShard& shardFor(const std::string& sessionId);
+
+        std::array<ConnectionShard, kShards> connections;
+        std::array<SessionShard, kShards> sessions;
+
+        std::array<std::atomic<size_t>, kMessageClassCount> inFlight{};
+        std::array<std::atomic<uint64_t>, kMessageClassCount> accepted{};
+        std::array<std::atomic<uint64_t>, kMessageClassCount> shed{};
+        std::atomic<uint64_t> connectionRateLimited{ 0 };
+        std::atomic<uint64_t> sessionRateLimited{ 0 };
+    };
+}
@@ -0,0 +1,192 @@
+#include "CaseResponses.hpp"
+#include "../shared/DTOFields.hpp"
+#include "../shared/JsonWriter.hpp"
+
+#include <cctype>
+#include <format>
+#include <mutex>
+
+#if defined(FINDTHEBUG_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+using namespace FindTheBug;
+
+namespace {
+
+    // Abaixo disso o gzip nao paga os proprios cabecalhos.
+    constexpr size_t kMinGzipBytes = 512;
+
+    // FNV-1a de 64 bits sobre o corpo: mesmo conteudo, mesmo ETag, inclusive depois de reconstruir.
+    std::string contentTag(std::string_view body, std::string_view suffix = {}) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : body) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return std::format("\"{:x}-{:016x}{}\"", body.size(), h, suffix);
+    }
+
+    std::string gzip(std::string_view body) {
+#if defined(FINDTHEBUG_WITH_ZLIB)
+        z_stream zs{};
+        // 15 + 16: janela maxima com cabecalho gzip, o que Content-Encoding: gzip espera.
+        if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return {};
+
+        std::string out(deflateBound(&zs, static_cast<uLong>(body.size())), '\0');
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+        zs.avail_in = static_cast<uInt>(body.size());
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+        int rc = deflate(&zs, Z_FINISH);
+        out.resize(zs.total_out);
+        deflateEnd(&zs);
+        return rc == Z_STREAM_END ? out : std::string{};
+#else
+        (void)body;
+        return {};
+#endif
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    // Chama fn para cada item de uma lista de cabecalho separada por virgulas; para quando fn retorna true.
+    template <typename Fn>
+    bool anyListItem(std::string_view header, Fn&& fn) {
+        while (!header.empty()) {
+            size_t comma = header.find(',');
+            if (fn(trim(header.substr(0, comma)))) return true;
+            if (comma == std::string_view::npos) break;
+            header.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+}
+
+CaseResponses::CaseResponses(std::shared_ptr<MongoStore> storage, std::shared_ptr<GameEngine> engine)
+    : storage(std::move(storage)), engine(std::move(engine)) {
+}
+
+std::shared_ptr<const CachedResponse> CaseResponses::build(std::string body) {
+    auto response = std::make_shared<CachedResponse>();
+    response->etag = contentTag(body);
+    if (body.size() >= kMinGzipBytes) {
+        auto compressed = gzip(body);
+        // So guarda se economiza de verdade; senao o cliente recebe o corpo direto.
+        if (!compressed.empty() && compressed.size() < body.size() * 9 / 10) {
+            response->gzipEtag = contentTag(body, "-gz");
+            response->gzipBody = std::move(compressed);
+        }
+    }
+    response->body = std::move(body);
+    response->builtAt = std::chrono::steady_clock::now();
+    return response;
+}
+
+bool CaseResponses::fresh(const CachedResponse& response) const {
+    return watching.load(std::memory_order_relaxed)
+        || std::chrono::steady_clock::now() - response.builtAt < kFallbackTtl;
+}
+
+std::shared_ptr<const CachedResponse> CaseResponses::list() {
+    uint64_t seen = 0;
+    {
+        std::shared_lock lock(mutex);
+        if (cases && fresh(*cases)) return cases;
+        seen = generation;
+    }
+
+    auto summaries = storage->listAvailableCases();
+    std::string body;
+    body.reserve(64 + summaries.size() * 128);
+    Json::Writer(body).beginObject().field("cases", summaries).endObject();
+    auto response = build(std::move(body));
+
+    // Lista vazia pode ser falha de leitura (listAvailableCases engole o erro): serve, mas nao guarda.
+    // Uma invalidacao durante a montagem tambem impede guardar o que foi lido antes dela.
+    std::unique_lock lock(mutex);
+    if (!summaries.empty() && generation == seen) cases = response;
+    return response;
+}
+
+std::shared_ptr<const CachedResponse> CaseResponses::detail(const std::string& caseId) {
+    uint64_t seen = 0;
+    bool expired = false;
+    {
+        std::shared_lock lock(mutex);
+        auto it = details.find(caseId);
+        if (it != details.end()) {
+            if (fresh(*it->second)) return it->second;
+            expired = true;
+        }
+        seen = generation;
+    }
+
+    // Sem change stream, expirar tambem recarrega o caso compilado: e a unica forma de ver edicoes.
+    if (expired) engine->invalidateCase(caseId);
+
+    auto compiledCase = engine->getCase(caseId);
+    if (!compiledCase) return nullptr;
+
+    // Apenas a parte publica do caso: pistas, gabarito e regras ficam no servidor.
+    const auto& c = compiledCase->data;
+    std::string body;
+    body.reserve(256 + c.description.size());
+    Json::Writer(body).beginObject()
+        .field("id", c.id)
+        .field("title", c.title)
+        .field("description", c.description)
+        .field("systemTopology", c.systemTopology)
+        .endObject();
+    auto response = build(std::move(body));
+
+    std::unique_lock lock(mutex);
+    if (generation == seen) details.insert_or_assign(caseId, response);
+    return response;
+}
+
+void CaseResponses::invalidate(const std::string& caseId) {
+    std::unique_lock lock(mutex);
+    ++generation;
+    // A lista mostra titulo e resumo de todos: qualquer mudanca a invalida.
+    cases.reset();
+    if (caseId.empty()) details.clear();
+    else details.erase(caseId);
+}
+
+void CaseResponses::setWatching(bool active) {
+    bool was = watching.exchange(active);
+    if (active && !was) invalidate({});
+}
+
+bool CaseResponses::matchesETag(std::string_view ifNoneMatch, std::string_view etag) {
+    return anyListItem(ifNoneMatch, [&](std::string_view tag) {
+        if (tag == "*") return true;
+        if (tag.starts_with("W/")) tag.remove_prefix(2);
+        return tag == etag;
+    });
+}
+
+bool CaseResponses::acceptsGzip(std::string_view acceptEncoding) {
+    return anyListItem(acceptEncoding, [](std::string_view item) {
+        size_t semicolon = item.find(';');
+        std::string_view coding = trim(item.substr(0, semicolon));
+        if (coding.size() != 4 && coding != "*") return false;
+        if (coding != "*") {
+            for (size_t i = 0; i < 4; ++i) {
+                if (std::tolower(static_cast<unsigned char>(coding[i])) != "gzip"[i]) return false;
+            }
+        }
+        if (semicolon == std::string_view::npos) return true;
+
+        // q=0 (com ou sem casas decimais) recusa a codificacao.
+        std::string_view param = trim(item.substr(semicolon + 1));
+        if (!param.starts_with("q=") && !param.starts_with("Q=")) return true;
+        param.remove_prefix(2);
+        return param.find_first_not_of("0.") != std::string_view::npos;
+    });
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../engine/GameEngine.hpp"
+#include "../storage/MongoStore.hpp"
+
+namespace FindTheBug {
+
+    // Resposta pronta: corpo serializado uma vez, ETag forte derivado do conteudo e, quando compensa
+    // (e o servidor foi compilado com zlib), o corpo ja comprimido com o proprio ETag.
+    struct CachedResponse {
+        std::string body;
+        std::string etag;
+        std::string gzipBody;  // vazio: sem versao comprimida
+        std::string gzipEtag;
+        std::chrono::steady_clock::time_point builtAt;
+    };
+
+    // Respostas de GET /cases e GET /cases/<id>, montadas uma vez por versao dos casos. O change stream
+    // da colecao cases invalida o que mudou; sem ele (Mongo sem replica set, ou stream caido) cada resposta
+    // vale kFallbackTtl. Os detalhes vem do CaseCache do motor, entao uma resposta nova tambem nao vai ao banco.
+    class CaseResponses {
+    public:
+        static constexpr std::chrono::seconds kFallbackTtl{ 60 };
+        // Clientes revalidam depois disso; com ETag a revalidacao custa um 304 sem corpo.
+        static constexpr std::string_view kCacheControl = "public, max-age=10, must-revalidate";
+
+        CaseResponses(std::shared_ptr<MongoStore> storage, std::shared_ptr<GameEngine> engine);
+
+        std::shared_ptr<const CachedResponse> list();
+        // nullptr se o caso nao existe.
+        std::shared_ptr<const CachedResponse> detail(const std::string& caseId);
+
+        // caseId vazio: o evento nao diz qual caso mudou, descarta tudo.
+        void invalidate(const std::string& caseId);
+        // Ao voltar a ativo descarta tudo: eventos perdidos enquanto o stream estava fora.
+        void setWatching(bool active);
+
+        // If-None-Match: lista de ETags ou "*"; W/ e ignorado (comparacao fraca, RFC 9110).
+        static bool matchesETag(std::string_view ifNoneMatch, std::string_view etag);
+        static bool acceptsGzip(std::string_view acceptEncoding);
+
+    private:
+        static std::shared_ptr<const CachedResponse> build(std::string body);
+        bool fresh(const CachedResponse& response) const;
+
+        std::shared_ptr<MongoStore> storage;
+        std::shared_ptr<GameEngine> engine;
+        std::atomic<bool> watching{ false };
+
+        std::shared_mutex mutex;
+        uint64_t generation{ 0 };  // cresce a cada invalidacao; montagens que a atravessaram nao sao guardadas
+        std::shared_ptr<const CachedResponse> cases;
+        std::unordered_map<std::string, std::shared_ptr<const CachedResponse>> details;
+    };
+}
@@ -0,0 +1,45 @@
+#include "HandoffSnapshot.hpp"
+#include "../shared/JsonScanner.hpp"
+#include "../shared/JsonWriter.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+using namespace FindTheBug;
+
+bool HandoffSnapshot::save(const std::string& path) const {
+    std::string body;
+    body.reserve(256 + lobbies.size() * 512 + sessionCases.size() * 64 + tournaments.size() * 1024);
+    Json::Writer(body).value(*this);
+
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(body.data(), static_cast<std::streamsize>(body.size()))) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+std::optional<HandoffSnapshot> HandoffSnapshot::take(const std::string& path) {
+    std::string data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return std::nullopt;
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    auto json = Json::Object::parse(data);
+    if (!json) return std::nullopt;
+
+    HandoffSnapshot snapshot;
+    if (!Json::readFields(*json, snapshot)) return std::nullopt;
+    if (std::chrono::system_clock::now() - snapshot.writtenAt > kMaxAge) return std::nullopt;
+    return snapshot;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../shared/DTOFields.hpp"
+#include "TournamentRegistry.hpp"
+
+namespace FindTheBug {
+
+    // Estado quente que um processo em drain deixa para o seguinte: lobbies e torneios em memoria e o caso de
+    // cada sessao. O banco continua sendo a fonte da verdade; o snapshot so evita a rajada de leituras dos
+    // clientes reconectando. Gravado como JSON com os mesmos descritores do Mongo e do protocolo.
+    struct HandoffSnapshot {
+        // Mais velho que isso e ignorado: outro no pode ter alterado os lobbies nesse meio tempo.
+        static constexpr std::chrono::minutes kMaxAge{ 5 };
+
+        std::chrono::system_clock::time_point writtenAt;
+        std::vector<LobbyInfo> lobbies;
+        std::unordered_map<std::string, std::string> sessionCases;  // sessionId -> caseId
+        std::vector<TournamentState> tournaments;
+
+        // Grava num arquivo temporario e renomeia: quem le nunca ve um snapshot pela metade.
+        bool save(const std::string& path) const;
+        // Le e apaga o arquivo (um snapshot so serve a um reinicio). nullopt se ausente, invalido ou velho.
+        static std::optional<HandoffSnapshot> take(const std::string& path);
+    };
+}
+
+namespace FindTheBug::Reflect {
+
+    template <> struct Descriptor<TournamentInfo> {
+        static constexpr auto fields = std::make_tuple(
+            field("id", &TournamentInfo::id),
+            field("name", &TournamentInfo::name),
+            field("caseId", &TournamentInfo::caseId));
+    };
+
+    template <> struct Descriptor<TournamentTeam> {
+        static constexpr auto fields = std::make_tuple(
+            field("sessionId", &TournamentTeam::sessionId),
+            field("teamName", &TournamentTeam::teamName),
+            field("score", &TournamentTeam::score),
+            field("revision", &TournamentTeam::revision));
+    };
+
+    template <> struct Descriptor<TournamentState> {
+        static constexpr auto fields = std::make_tuple(
+            field("info", &TournamentState::info),
+            field("version", &TournamentState::version),
+            field("teams", &TournamentState::teams));
+    };
+
+    template <> struct Descriptor<HandoffSnapshot> {
+        static constexpr auto fields = std::make_tuple(
+            field("writtenAt", &HandoffSnapshot::writtenAt),
+            field("lobbies", &HandoffSnapshot::lobbies),
+            field("sessionCases", &HandoffSnapshot::sessionCases),
+            field("tournaments", &HandoffSnapshot::tournaments));
+    };
+}
@@ -1,111 +1,262 @@
 #define NOMINMAX 
 
 #include "HttpServer.hpp"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <print>
 #include <random>
 #include <format>
-#include <sstream>
-#include <iomanip>
+#include <charconv>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+
+#include "../protocol/Commands.hpp"
+#include "../protocol/Messages.hpp"
+#include "../shared/DTOFields.hpp"
+#include "../shared/JsonWriter.hpp"
+#include "../shared/MsgPack.hpp"
 
 using namespace FindTheBug;
 
-std::string escapeJSON(const std::string& s) {
-    std::ostringstream o;
-    for (auto c : s) {
-        switch (c) {
-        case '"': o << "\\\""; break;
-        case '\\': o << "\\\\"; break;
-        case '\b': o << "\\b"; break;
-        case '\f': o << "\\f"; break;
-        case '\n': o << "\\n"; break;
-        case '\r': o << "\\r"; break;
-        case '\t': o << "\\t"; break;
-        default:
-            if ('\x00' <= c && c <= '\x1f') {
-                o << "\\u"
-                    << std::hex << std::setw(4) << std::setfill('0') << (int)c;
-            }
-            else {
-                o << c;
-            }
+static constexpr std::chrono::seconds kOnlineTurnLimit{ 120 };
+static constexpr std::chrono::seconds kOfflineTurnLimit{ 15 };
+static constexpr std::chrono::seconds kCompletedRetention{ 60 };
+static constexpr std::chrono::seconds kStaleSweepInterval{ 30 };
+static constexpr std::chrono::seconds kLobbyIdleEviction{ 5 * 60 };
+
+// Drain: prazo para a fila esvaziar e janela em que os RECONNECT sao espalhados.
+static constexpr std::chrono::seconds kDrainTimeout{ 20 };
+static constexpr std::chrono::milliseconds kReconnectBase{ 1000 };
+static constexpr std::chrono::milliseconds kReconnectSpread{ 10000 };
+static constexpr std::chrono::milliseconds kReconnectMaxBackoff{ 30000 };
+// Tempo para o Crow escrever os RECONNECT antes de fechar as conexoes.
+static constexpr std::chrono::milliseconds kReconnectGrace{ 500 };
+
+static std::atomic<bool> shutdownRequested{ false };
+
+static constexpr std::string_view kInvalidNameError =
+    "Nome invalido: use ate 64 caracteres, sem '.' e sem '$' no inicio.";
+
+// build(w) recebe um Json::Writer ou um MsgPack::Writer, conforme o formato de cada destinatario.
+// O encoder guarda build por referencia: so vale na expressao em que foi criado.
+// A mensagem e escrita direto na string compartilhada que vai para as outboxes, sem copia.
+template <typename Build>
+static MessageEncoder encodeMessage(size_t reserve, const Build& build) {
+    return [&build, reserve](WireFormat format) {
+        auto out = std::make_shared<std::string>();
+        out->reserve(reserve);
+        if (format == WireFormat::MsgPack) {
+            MsgPack::Writer<std::string> w(*out);
+            build(w);
         }
+        else {
+            Json::Writer<std::string> w(*out);
+            build(w);
+        }
+        return OutboundMessage(std::move(out));
+    };
+}
+
+static void sendError(crow::websocket::connection* conn, std::string_view message) {
+    SessionManager::sendTo(conn, encodeMessage(64 + message.size(), [&](auto& w) { Protocol::writeError(w, message); }));
+}
+
+static void sendOverloaded(crow::websocket::connection* conn, std::string_view reason, std::chrono::milliseconds retryAfter) {
+    SessionManager::sendTo(conn, encodeMessage(80, [&](auto& w) {
+        Protocol::writeOverloaded(w, reason, static_cast<int64_t>(retryAfter.count()));
+        }));
+}
+
+// Corpo pronto com validacao condicional: If-None-Match igual ao ETag vira 304 sem corpo.
+static crow::response cachedResponse(const crow::request& req, const CachedResponse& cached) {
+    bool gzip = !cached.gzipBody.empty() && CaseResponses::acceptsGzip(req.get_header_value("Accept-Encoding"));
+    const std::string& etag = gzip ? cached.gzipEtag : cached.etag;
+
+    crow::response res;
+    if (CaseResponses::matchesETag(req.get_header_value("If-None-Match"), etag)) {
+        res.code = 304;
+    }
+    else {
+        res.code = 200;
+        res.body = gzip ? cached.gzipBody : cached.body;
+        res.set_header("Content-Type", "application/json");
+        if (gzip) res.set_header("Content-Encoding", "gzip");
     }
-    return o.str();
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", std::string(CaseResponses::kCacheControl));
+    if (!cached.gzipBody.empty()) res.set_header("Vary", "Accept-Encoding");
+    return res;
 }
 
 HttpServer::HttpServer(
     std::shared_ptr<GameEngine> engine,
     std::shared_ptr<MongoStore> storage,
     std::shared_ptr<SessionManager> sessionManager,
-    std::shared_ptr<TaskQueue> taskQueue
+    std::shared_ptr<TaskQueue> taskQueue,
+    HeartbeatSettings heartbeat
 ) : engine(std::move(engine)),
 storage(std::move(storage)),
 sessionManager(std::move(sessionManager)),
-taskQueue(std::move(taskQueue))
+taskQueue(std::move(taskQueue)),
+heartbeat(heartbeat)
 {
+    lobbies = std::make_unique<LobbyRegistry>(this->storage, this->taskQueue);
+    tournaments = std::make_unique<TournamentRegistry>();
+    sequencer = std::make_unique<StateSequencer>();
+    caseResponses = std::make_unique<CaseResponses>(this->storage, this->engine);
+    admission = std::make_unique<AdmissionControl>();
+    presence = std::make_unique<PresenceTracker>(heartbeat.timeout);
+
+    // Edicoes na colecao cases derrubam o caso compilado e as respostas prontas de /cases.
+    this->storage->watchCases(
+        [this](const std::string& caseId) {
+            this->engine->invalidateCase(caseId);
+            caseResponses->invalidate(caseId);
+        },
+        [this](bool active) { caseResponses->setWatching(active); });
+
+    turnTimer = std::make_unique<TurnTimer>([this](const std::string& sessionId) {
+        this->taskQueue->enqueue([this, sessionId]() { handleTurnDeadline(sessionId); });
+        });
+
     SessionManager::log("[INIT] HttpServer inicializado com fila de tarefas.");
 }
 
+HttpServer::~HttpServer() {
+    shutdown();
+}
+
+void HttpServer::stopBackgroundWork() {
+    reaperThread.request_stop();
+    heartbeatThread.request_stop();
+    if (reaperThread.joinable()) reaperThread.join();
+    if (heartbeatThread.joinable()) heartbeatThread.join();
+    turnTimer->stop();
+}
+
+void HttpServer::shutdown() {
+    // Quem alimenta a fila para antes dela; as tarefas restantes rodam ate o fim com os componentes ainda vivos.
+    stopBackgroundWork();
+    // O watcher chama de volta caseResponses e engine: para antes de destrui-los.
+    storage->stopWatchingCases();
+    taskQueue->shutdown();
+}
+
+bool HttpServer::sleepUnlessStopped(std::stop_token stop, std::chrono::milliseconds interval) {
+    std::unique_lock lock(stopMutex);
+    stopCv.wait_for(lock, stop, interval, []() { return false; });
+    return !stop.stop_requested();
+}
+
 void HttpServer::runReaper() {
-    std::thread([this]() {
-        while (true) {
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+    // Sessoes em jogo antes de um reinicio nao tem prazo agendado; a primeira avaliacao reconstroi o timer.
+    for (const auto& sid : storage->getFrozenSessions(0)) {
+        turnTimer->schedule(sid, std::chrono::system_clock::now());
+    }
 
-            storage->removeStaleSessions(5);
+    reaperThread = std::jthread([this](std::stop_token stop) {
+        while (sleepUnlessStopped(stop, kStaleSweepInterval)) {
+            for (const auto& sid : storage->removeStaleSessions(5)) forgetSession(sid);
+            lobbies->evictIdle(kLobbyIdleEviction);
+            admission->evictIdle(kLobbyIdleEviction);
+            for (const auto& id : tournaments->evictIdle(kLobbyIdleEviction)) {
+                sessionManager->closeSession(TournamentRegistry::channelFor(id));
+            }
+        }
+        });
+}
 
-            auto activeSessions = storage->getFrozenSessions(0);
+void HttpServer::requestShutdown() {
+    shutdownRequested.store(true);
+}
 
-            for (const auto& sid : activeSessions) {
-                auto stateOpt = storage->getGameState(sid);
-                if (!stateOpt) continue;
-                auto state = *stateOpt;
+void HttpServer::enableHandoff(std::string path) {
+    snapshotPath = std::move(path);
+    auto snapshot = HandoffSnapshot::take(snapshotPath);
+    if (!snapshot) return;
 
-                auto now = std::chrono::system_clock::now();
+    size_t adopted = lobbies->adopt(std::move(snapshot->lobbies));
+    engine->adoptSessionCases(snapshot->sessionCases);
 
-                if (state.isCompleted) {
-                    auto endedAgo = std::chrono::duration_cast<std::chrono::seconds>(now - state.lastActivity).count();
+    // Torneios guardam o caso compilado: carrega aqui mesmo, antes de run() abrir a porta.
+    size_t adoptedTournaments = 0;
+    for (auto& tournament : snapshot->tournaments) {
+        auto compiledCase = engine->getCase(tournament.info.caseId);
+        if (!compiledCase) continue;
+        adoptedTournaments += tournaments->adopt(std::move(tournament), std::move(compiledCase));
+    }
 
-                    if (endedAgo > 60) {
-                        SessionManager::log("[REAPER] Jogo finalizado ha >60s na sessao " + sid + ". Deletando.");
-                        storage->deleteSession(sid);
-                        sessionManager->closeSession(sid);
-                    }
-                    continue;
-                }
+    // Compila os casos em uso antes dos clientes voltarem.
+    std::unordered_set<std::string> caseIds;
+    for (const auto& [sessionId, caseId] : snapshot->sessionCases) caseIds.insert(caseId);
+    for (const auto& caseId : caseIds) {
+        taskQueue->enqueue([this, caseId]() { engine->getCase(caseId); });
+    }
 
-                if (state.turnOrder.empty()) {
-                    storage->deleteSession(sid);
-                    sessionManager->closeSession(sid);
-                    continue;
-                }
-                auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - state.turnStartTime).count();
-                std::string currentPlayer = state.turnOrder[state.currentTurnIndex];
+    SessionManager::log(std::format("[HANDOFF] Snapshot carregado: {} lobbies, {} torneios, {} sessoes, {} casos.",
+        adopted, adoptedTournaments, snapshot->sessionCases.size(), caseIds.size()));
+}
+
+void HttpServer::drain() {
+    if (draining.exchange(true)) return;
+    SessionManager::log("[DRAIN] Recusando novas sessoes; esperando a fila de tarefas.");
 
-                bool isOnline = sessionManager->isPlayerOnline(sid, currentPlayer);
-                long timeLimit = isOnline ? 120 : 15;
+    // Prazos de turno, reaper e heartbeat tambem gravam e removem sessoes: param antes do snapshot, senao o
+    // processo novo pode adotar um lobby ou torneio cujo documento ja foi apagado.
+    stopBackgroundWork();
 
-                if (duration > timeLimit) {
+    // Comandos ja aceitos e gravacoes de lobby pendentes terminam aqui.
+    if (!taskQueue->waitIdle(kDrainTimeout)) {
+        SessionManager::log("[DRAIN] Fila nao esvaziou no prazo (" + std::to_string(taskQueue->depth()) + " tarefas).");
+    }
+
+    if (!snapshotPath.empty()) {
+        HandoffSnapshot snapshot;
+        snapshot.writtenAt = std::chrono::system_clock::now();
+        snapshot.lobbies = lobbies->snapshot();
+        snapshot.sessionCases = engine->sessionCases();
+        snapshot.tournaments = tournaments->snapshot();
+        if (snapshot.save(snapshotPath)) {
+            SessionManager::log(std::format("[DRAIN] Snapshot gravado: {} lobbies, {} torneios, {} sessoes.",
+                snapshot.lobbies.size(), snapshot.tournaments.size(), snapshot.sessionCases.size()));
+        }
+        else {
+            SessionManager::log("[DRAIN] Falha ao gravar o snapshot em " + snapshotPath);
+        }
+    }
 
-                    state.currentTurnIndex = (state.currentTurnIndex + 1) % state.turnOrder.size();
+    // Cada conexao sorteia o proprio atraso: o processo novo recebe os clientes espalhados, nao de uma vez.
+    std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<int64_t> jitter(0, kReconnectSpread.count());
+    auto conns = SessionManager::openConnections();
+    for (auto* conn : conns) {
+        int64_t delay = kReconnectBase.count() + jitter(gen);
+        SessionManager::sendTo(conn, encodeMessage(80, [&](auto& w) {
+            Protocol::writeReconnect(w, delay, kReconnectMaxBackoff.count());
+            }));
+    }
+    SessionManager::log("[DRAIN] RECONNECT enviado a " + std::to_string(conns.size()) + " conexoes.");
 
-                    state.turnStartTime = std::chrono::system_clock::now();
+    std::this_thread::sleep_for(kReconnectGrace);
+}
 
-                    if (storage->saveGameState(state)) {
-                        broadcastGameState(sid);
+void HttpServer::runHeartbeat() {
+    heartbeatThread = std::jthread([this](std::stop_token stop) {
+        while (sleepUnlessStopped(stop, heartbeat.interval)) {
+            auto now = std::chrono::system_clock::now();
+            int64_t t = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
 
-                        std::string reason = isOnline ? "TIMEOUT" : "OFFLINE_SKIP";
-                        std::string msg = std::format(
-                            "{{\"type\":\"TURN_SKIPPED\",\"previousPlayer\":\"{}\",\"reason\":\"{}\"}}",
-                            currentPlayer, reason
-                        );
-                        sessionManager->broadcastToSession(sid, msg);
-                    }
-                }
+            // Coalescido: um PING ainda na fila de um cliente lento e substituido, nao acumulado.
+            for (const auto& sid : presence->trackedSessions()) {
+                sessionManager->broadcastToSession(sid, encodeMessage(48, [&](auto& w) { Protocol::writePing(w, t); }), Outbox::kPingKey);
+            }
+            for (const auto& change : presence->sweep(now)) {
+                publishPresence(change);
             }
         }
-        }).detach();
+        });
 }
 
 void HttpServer::run(uint16_t port) {
@@ -113,63 +264,33 @@ void HttpServer::run(uint16_t port) {
     SessionManager::log("[DEBUG] HttpServer::run iniciando na porta " + std::to_string(port));
 
     this->runReaper();
+    this->runHeartbeat();
 
     crow::SimpleApp app;
+    // SIGTERM/SIGINT passam pelo drain (main instala o handler) em vez de parar o Crow na hora.
+    app.signal_clear();
 
     CROW_ROUTE(app, "/cases").methods(crow::HTTPMethod::GET)
-        ([this]() {
-        auto cases = storage->listAvailableCases();
-     
-        std::vector<crow::json::wvalue> casesJson;
-        for (const auto& c : cases) {
-            crow::json::wvalue cv;
-            cv["id"] = c.id;
-            cv["title"] = c.title;
-            cv["shortDescription"] = c.shortDescription;
-            casesJson.push_back(cv);
-        }
-
-        crow::json::wvalue finalJson;
-        finalJson["cases"] = std::move(casesJson);
-        return finalJson;
-
+        ([this](const crow::request& req) {
+        return cachedResponse(req, *caseResponses->list());
             });
 
     CROW_ROUTE(app, "/cases/<string>").methods(crow::HTTPMethod::GET)
-        ([this](std::string caseId) {
-        auto caseOpt = storage->getCase(caseId);
-        if (!caseOpt) return crow::response(404, "Caso nao encontrado");
-
-        const auto& c = *caseOpt;
-        crow::json::wvalue j;
-        j["id"] = c.id;
-        j["title"] = c.title;
-        j["description"] = c.description;
-
-        crow::json::wvalue topo;
-
-        std::vector<crow::json::wvalue> mods;
-        for (const auto& m : c.systemTopology.modules) {
-            crow::json::wvalue mv; mv["name"] = m.name; mods.push_back(mv);
-        }
-        topo["modules"] = std::move(mods);
-
-        std::vector<crow::json::wvalue> funcs;
-        for (const auto& f : c.systemTopology.functions) {
-            crow::json::wvalue fv; fv["name"] = f.name; fv["parentId"] = f.parentId; funcs.push_back(fv);
-        }
-        topo["functions"] = std::move(funcs);
-
-        std::vector<crow::json::wvalue> conns;
-        for (const auto& cn : c.systemTopology.connections) {
-            crow::json::wvalue cv; cv["id"] = cn.id; cv["from"] = cn.from; cv["to"] = cn.to; conns.push_back(cv);
-        }
-        topo["connections"] = std::move(conns);
-
-        j["systemTopology"] = std::move(topo);
+        ([this](const crow::request& req, std::string caseId) {
+        auto response = caseResponses->detail(caseId);
+        if (!response) return crow::response(404, "Caso nao encontrado");
+        return cachedResponse(req, *response);
+            });
 
+    CROW_ROUTE(app, "/metrics").methods(crow::HTTPMethod::GET)
+        ([this]() {
+        std::string body;
+        body.reserve(2048);
+        admission->writeMetrics(body, taskQueue->depth(), taskQueue->capacity());
 
-        return crow::response(j);
+        crow::response res(200, std::move(body));
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
+        return res;
             });
 
     auto wsOpenHandler = std::bind(&HttpServer::handleWebSocketOpen, this, std::placeholders::_1);
@@ -186,6 +307,17 @@ void HttpServer::run(uint16_t port) {
 
     SessionManager::log("[DEBUG] Servidor iniciando...");
 
+    std::jthread shutdownWatcher([this, &app](std::stop_token stop) {
+        while (!stop.stop_requested()) {
+            if (shutdownRequested.load()) {
+                drain();
+                app.stop();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        });
+
     app.port(port).multithreaded().run();
 
 }
@@ -193,293 +325,315 @@ void HttpServer::run(uint16_t port) {
 // Handlers WebSocket
 
 void HttpServer::handleWebSocketOpen(crow::websocket::connection& conn) {
+    SessionManager::openConnection(&conn);
     SessionManager::log("[WS] Nova conexao: " + std::to_string((uintptr_t)&conn));
 }
 
 void HttpServer::handleWebSocketClose(crow::websocket::connection& conn, const std::string& reason) {
-    sessionManager->unregisterConnection(&conn);
+    SessionManager::closeConnection(&conn);
+    admission->forgetConnection(&conn);
+    leaveSession(&conn);
     SessionManager::log("[WS] Fechado (" + reason + ")");
 }
 
 void HttpServer::handleWebSocketMessage(crow::websocket::connection& conn, const std::string& data, bool is_binary) {
-    if (is_binary) return;
-
-    try {
-        auto msg = crow::json::load(data);
-        if (!msg || !msg.has("type")) {
-            SessionManager::sendTo(&conn, "{\"type\":\"ERROR\",\"message\":\"Invalid JSON\"}");
-            return;
+    // Sem arvore: o frame e validado uma vez e cada tipo copia so os proprios campos para o comando,
+    // que segue movido para a tarefa. Frames binarios sao MessagePack, com o mesmo esquema do JSON.
+    // O limite de taxa vem antes de tudo: um frame recusado nao custa nem o parse. Qualquer frame,
+    // mesmo recusado, e sinal de vida do jogador.
+    auto member = sessionManager->memberOf(&conn);
+    if (!member.playerName.empty()) {
+        if (auto change = presence->touch(member.sessionId, member.playerName, std::chrono::system_clock::now())) {
+            publishPresence(*change);
         }
+    }
 
-        std::string type = msg["type"].s();
+    auto admitted = admission->admitFrame(&conn, member.sessionId);
+    if (!admitted.accepted) {
+        if (admitted.notify) sendOverloaded(&conn, "rate", admitted.retryAfter);
+        return;
+    }
 
-        if (type == "CREATE_LOBBY") {
-            if (msg.has("playerName"))
-                processCreateLobby(&conn, msg["playerName"].s());
-        }
-        else if (type == "JOIN_AS_PLAYER") {
-            if (msg.has("sessionId") && msg.has("playerName"))
-                processJoinAsPlayer(&conn, msg["sessionId"].s(), msg["playerName"].s());
-        }
-        else if (type == "JOIN_AS_MASTER") {
-            if (msg.has("sessionId") && msg.has("masterName"))
-                processJoinAsMaster(&conn, msg["sessionId"].s(), msg["masterName"].s());
-        }
-        else if (type == "GET_LOBBY_INFO") {
-            if (msg.has("sessionId"))
-                processGetLobbyInfo(&conn, msg["sessionId"].s());
+    if (is_binary) {
+        auto frame = MsgPack::Object::parse(data);
+        if (!frame || !frame->has("type")) {
+            sendError(&conn, "Invalid MessagePack");
+            return;
         }
-        else if (type == "START_GAME") {
+        dispatchCommand(conn, *frame);
+        return;
+    }
 
-            std::string caseId = msg.has("caseId") ? msg["caseId"].s() : std::string("case_robotics_001");
-            std::string pName = msg.has("playerName") ? msg["playerName"].s() : std::string("");
+    auto frame = Json::Object::parse(data);
+    if (!frame || !frame->has("type")) {
+        sendError(&conn, "Invalid JSON");
+        return;
+    }
+    dispatchCommand(conn, *frame);
+}
 
-            if (msg.has("sessionId") && !pName.empty())
-                processStartGame(&conn, msg["sessionId"].s(), pName, caseId);
-            else
-                SessionManager::sendTo(&conn, "{\"type\":\"ERROR\",\"message\":\"START_GAME requer sessionId e playerName\"}");
-        }
-        else if (type == "SUBMIT_SOLUTION") {
-            if (msg.has("sessionId") && msg.has("answers")) {
-                std::vector<std::string> answers;
-                for (const auto& a : msg["answers"]) answers.push_back(a.s());
-                processSubmitSolution(&conn, msg["sessionId"].s(), answers);
-            }
-        }
-        else if (type == "VALIDATE_SOLUTION") {
-            if (msg.has("sessionId") && msg.has("approved")) {
-                processValidateSolution(&conn, msg["sessionId"].s(), msg["approved"].b());
-            }
-        }
-        else if (type == "GAME_ACTION") {
-            if (msg.has("sessionId") && msg.has("playerId") && msg.has("actionType") && msg.has("targetId")) {
-                ActionType aType = static_cast<ActionType>(msg["actionType"].i());
-                processGameAction(&conn, msg["sessionId"].s(), msg["playerId"].s(), aType, msg["targetId"].s());
-            }
-        }
-        else if (type == "SAVE_NOTE") {
-            if (msg.has("sessionId") && msg.has("playerId") && msg.has("clueId") && msg.has("content")) {
-                processSaveNote(&conn, msg["sessionId"].s(), msg["playerId"].s(), msg["clueId"].s(), msg["content"].s());
-            }
-        }
-        else if (type == "LEAVE_LOBBY") {
-            sessionManager->unregisterConnection(&conn);
-        }
+template <typename Frame>
+void HttpServer::dispatchCommand(crow::websocket::connection& conn, const Frame& frame) {
+    using namespace Protocol;
+
+    auto run = [&]<typename Cmd>(void (HttpServer::*handler)(crow::websocket::connection*, Cmd)) {
+        Cmd cmd;
+        auto status = decode(frame, cmd);
+        if (status == DecodeStatus::Ok) (this->*handler)(&conn, std::move(cmd));
+        return status;
+    };
+
+    switch (commandTypeOf(frame)) {
+    case CommandType::CreateLobby: run(&HttpServer::processCreateLobby); break;
+    case CommandType::JoinAsPlayer: run(&HttpServer::processJoinAsPlayer); break;
+    case CommandType::JoinAsMaster: run(&HttpServer::processJoinAsMaster); break;
+    case CommandType::GetLobbyInfo: run(&HttpServer::processGetLobbyInfo); break;
+    case CommandType::StartGame: {
+        StartGameCommand cmd;
+        if (decode(frame, cmd) == DecodeStatus::Ok && !cmd.playerName.empty())
+            processStartGame(&conn, std::move(cmd));
+        else
+            sendError(&conn, "START_GAME requer sessionId e playerName");
+        break;
     }
-    catch (const std::exception& e) {
-        SessionManager::log("[WS] Erro parsing: " + std::string(e.what()));
+    case CommandType::CreateTournament: run(&HttpServer::processCreateTournament); break;
+    case CommandType::SpectateTournament: run(&HttpServer::processSpectateTournament); break;
+    case CommandType::SubmitSolution: run(&HttpServer::processSubmitSolution); break;
+    case CommandType::ValidateSolution: run(&HttpServer::processValidateSolution); break;
+    case CommandType::GameAction: run(&HttpServer::processGameAction); break;
+    case CommandType::SaveNote: run(&HttpServer::processSaveNote); break;
+    case CommandType::EditSharedNote:
+        if (run(&HttpServer::processEditSharedNote) == DecodeStatus::Invalid)
+            sendError(&conn, "EDIT_SHARED_NOTE com operacoes invalidas");
+        break;
+    case CommandType::GameBatch:
+        if (run(&HttpServer::processGameBatch) == DecodeStatus::Invalid)
+            sendError(&conn, std::format("GAME_BATCH requer entre 1 e {} comandos validos", GameBatchCommand::kMaxCommands));
+        break;
+    case CommandType::Resync: run(&HttpServer::processResync); break;
+    case CommandType::LeaveLobby: leaveSession(&conn); break;
+    case CommandType::Hello: run(&HttpServer::processHello); break;
+    // O frame ja atualizou a presenca; o PONG tambem confirma a entrega do que saiu antes do PING.
+    case CommandType::Pong: SessionManager::acknowledge(&conn); break;
+    case CommandType::Unknown:
+        break;
     }
 }
 
 // Lgica Assncrona (TaskQueue)
 
-void HttpServer::processCreateLobby(crow::websocket::connection* conn, const std::string& playerName) {
+template <typename Task>
+void HttpServer::submit(crow::websocket::connection* conn, MessageClass cls, Task&& task) {
+    // Em drain o estado congela para o snapshot e a fila precisa esvaziar: nenhuma classe entra, nem Control.
+    if (draining.load(std::memory_order_relaxed)) {
+        sendOverloaded(conn, "draining", kReconnectBase);
+        return;
+    }
+
+    if (!admission->acquire(cls)) {
+        sendOverloaded(conn, "busy", AdmissionControl::kBusyRetryAfter);
+        return;
+    }
+    bool queued = taskQueue->tryEnqueue([this, cls, task = std::forward<Task>(task)]() mutable {
+        AdmissionControl::Slot slot(*admission, cls);
+        task();
+        }, AdmissionControl::kQueueHeadroom[static_cast<size_t>(cls)]);
+    if (!queued) {
+        admission->rejectQueued(cls);
+        sendOverloaded(conn, "busy", AdmissionControl::kBusyRetryAfter);
+        return;
+    }
+    admission->admitted(cls);
+}
+
+void HttpServer::processCreateLobby(crow::websocket::connection* conn, Protocol::CreateLobbyCommand cmd) {
+    if (!isValidPlayerName(cmd.playerName)) {
+        sendError(conn, kInvalidNameError);
+        return;
+    }
+
     std::string sessionId = generateSessionId();
 
-    taskQueue->enqueue([this, conn, sessionId, playerName]() {
+    submit(conn, MessageClass::Lobby, [this, conn, sessionId, cmd = std::move(cmd)]() {
         PlayerInfo host;
-        host.name = playerName;
+        host.name = cmd.playerName;
         host.role = PlayerRole::Host;
         host.joinedAt = std::chrono::system_clock::now();
 
-        if (storage->createLobby(sessionId, host)) {
-            sessionManager->registerConnection(sessionId, conn, playerName);
+        if (lobbies->create(sessionId, host)) {
+            registerPlayer(sessionId, conn, cmd.playerName);
 
-            std::string resp = std::format(
-                "{{\"type\":\"LOBBY_CREATED\",\"sessionId\":\"{}\",\"playerName\":\"{}\",\"role\":{}}}",
-                sessionId, escapeJSON(playerName), (int)PlayerRole::Host
-            );
-            SessionManager::sendTo(conn, resp);
+            SessionManager::sendTo(conn, encodeMessage(128, [&](auto& w) {
+                w.beginObject()
+                    .field("type", "LOBBY_CREATED")
+                    .field("sessionId", sessionId)
+                    .field("playerName", cmd.playerName)
+                    .field("role", PlayerRole::Host)
+                    .endObject();
+                }));
 
             SessionManager::log("[LOBBY] Criado: " + sessionId);
         }
         else {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Falha ao criar lobby no DB\"}");
+            sendError(conn, "Falha ao criar lobby no DB");
         }
         });
 }
 
-void HttpServer::processJoinAsPlayer(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerName) {
-    taskQueue->enqueue([this, conn, sessionId, playerName]() {
+void HttpServer::processJoinAsPlayer(crow::websocket::connection* conn, Protocol::JoinAsPlayerCommand cmd) {
+    submit(conn, MessageClass::Lobby, [this, conn, cmd = std::move(cmd)]() {
+
+        auto join = lobbies->joinAsPlayer(cmd.sessionId, cmd.playerName);
 
-        auto lobbyOpt = storage->getLobby(sessionId);
-        if (!lobbyOpt) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Lobby nao encontrado\"}");
+        if (join.result == JoinResult::NotFound) {
+            sendError(conn, "Lobby nao encontrado");
             return;
         }
-        const auto& lobby = *lobbyOpt;
-
-        bool isRejoining = false;
-
-        for (const auto& p : lobby.players) {
-            if (p.name == playerName) {
-                isRejoining = true;
-                break;
-            }
+        if (join.result == JoinResult::InvalidName) {
+            sendError(conn, kInvalidNameError);
+            return;
         }
 
-        if (isRejoining) {
-            sessionManager->registerConnection(sessionId, conn, playerName);
+        registerPlayer(cmd.sessionId, conn, cmd.playerName);
 
-            std::string resp = std::format(
-                "{{\"type\":\"JOINED_LOBBY\",\"sessionId\":\"{}\",\"playerName\":\"{}\",\"isRejoin\":true}}",
-                sessionId, escapeJSON(playerName)
-            );
-            SessionManager::sendTo(conn, resp);
+        if (join.result == JoinResult::Rejoined) {
+            SessionManager::sendTo(conn, encodeMessage(128, [&](auto& w) {
+                w.beginObject()
+                    .field("type", "JOINED_LOBBY")
+                    .field("sessionId", cmd.sessionId)
+                    .field("playerName", cmd.playerName)
+                    .field("isRejoin", true)
+                    .endObject();
+                }));
 
-            if (lobby.phase == GamePhase::Investigation) {
-                broadcastGameState(sessionId);
+            if (join.lobby.phase == GamePhase::Investigation) {
+                sendGameSnapshot(conn, cmd.sessionId);
             }
 
-            SessionManager::log("[RECONNECT] Jogador " + playerName + " voltou para sessao " + sessionId);
-        }
-        else {
-            PlayerInfo p;
-            p.name = playerName;
-            p.role = PlayerRole::Player;
-            p.joinedAt = std::chrono::system_clock::now();
-
-            if (storage->addPlayerToLobby(sessionId, p)) {
-                sessionManager->registerConnection(sessionId, conn, playerName);
-
-                std::string resp = std::format(
-                    "{{\"type\":\"JOINED_LOBBY\",\"sessionId\":\"{}\",\"playerName\":\"{}\",\"role\":{}}}",
-                    sessionId, escapeJSON(playerName), (int)PlayerRole::Player
-                );
-                SessionManager::sendTo(conn, resp);
-                broadcastLobbyState(sessionId);
-            }
-            else {
-                SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Erro ao salvar jogador (Nome em uso?)\"}");
-            }
+            SessionManager::log("[RECONNECT] Jogador " + cmd.playerName + " voltou para sessao " + cmd.sessionId);
+            return;
         }
+
+        SessionManager::sendTo(conn, encodeMessage(128, [&](auto& w) {
+            w.beginObject()
+                .field("type", "JOINED_LOBBY")
+                .field("sessionId", cmd.sessionId)
+                .field("playerName", cmd.playerName)
+                .field("role", PlayerRole::Player)
+                .endObject();
+            }));
+        broadcastLobbyState(join.lobby);
         });
 }
 
-void HttpServer::processJoinAsMaster(crow::websocket::connection* conn, const std::string& sessionId, const std::string& masterName) {
-    taskQueue->enqueue([this, conn, sessionId, masterName]() {
+void HttpServer::processJoinAsMaster(crow::websocket::connection* conn, Protocol::JoinAsMasterCommand cmd) {
+    submit(conn, MessageClass::Lobby, [this, conn, cmd = std::move(cmd)]() {
+
+        auto join = lobbies->claimMaster(cmd.sessionId, cmd.masterName);
 
-        auto lobbyOpt = storage->getLobby(sessionId);
-        if (!lobbyOpt) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Lobby nao encontrado\"}");
+        switch (join.result) {
+        case JoinResult::NotFound:
+            sendError(conn, "Lobby nao encontrado");
             return;
+        case JoinResult::MasterTaken:
+            sendError(conn, "Ja existe um Mestre nesta sessao.");
+            return;
+        case JoinResult::InvalidName:
+            sendError(conn, kInvalidNameError);
+            return;
+        case JoinResult::NameTaken:
+            sendError(conn, "Nome ja em uso nesta sessao.");
+            return;
+        default:
+            break;
         }
 
-        const auto& lobby = *lobbyOpt;
-
-        bool isRejoin = false;
-        bool masterExists = false;
-
-        for (const auto& p : lobby.players) {
-            if (p.role == PlayerRole::Master) {
-                masterExists = true;
-                if (p.name == masterName) {
-                    isRejoin = true;
-                }
-                break;
-            }
+        registerPlayer(cmd.sessionId, conn, cmd.masterName);
+
+        bool isRejoin = join.result == JoinResult::Rejoined;
+        SessionManager::sendTo(conn, encodeMessage(128, [&](auto& w) {
+            w.beginObject()
+                .field("type", "JOINED_LOBBY")
+                .field("sessionId", cmd.sessionId)
+                .field("playerName", cmd.masterName)
+                .field("role", PlayerRole::Master);
+            if (isRejoin) w.field("isRejoin", true);
+            w.endObject();
+            }));
+
+        if (join.lobby.phase != GamePhase::Lobby) {
+            sendGameSnapshot(conn, cmd.sessionId);
         }
-
-        if (masterExists && !isRejoin) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Ja existe um Mestre nesta sessao.\"}");
-            return;
+        else if (!isRejoin) {
+            broadcastLobbyState(join.lobby);
         }
 
         if (isRejoin) {
-            sessionManager->registerConnection(sessionId, conn, masterName);
-
-            std::string resp = std::format(
-                "{{\"type\":\"JOINED_LOBBY\",\"sessionId\":\"{}\",\"playerName\":\"{}\",\"role\":{},\"isRejoin\":true}}",
-                sessionId, escapeJSON(masterName), (int)PlayerRole::Master
-            );
-            SessionManager::sendTo(conn, resp);
-
-            if (lobby.phase != GamePhase::Lobby) {
-                broadcastGameState(sessionId);
-            }
-            SessionManager::log("[RECONNECT] Mestre " + masterName + " voltou para sessao " + sessionId);
-        }
-        else {
-            PlayerInfo m;
-            m.name = masterName;
-            m.role = PlayerRole::Master;
-            m.joinedAt = std::chrono::system_clock::now();
-
-            if (storage->addPlayerToLobby(sessionId, m)) {
-                sessionManager->registerConnection(sessionId, conn, masterName);
-
-                std::string resp = std::format(
-                    "{{\"type\":\"JOINED_LOBBY\",\"sessionId\":\"{}\",\"playerName\":\"{}\",\"role\":{}}}",
-                    sessionId, escapeJSON(masterName), (int)PlayerRole::Master
-                );
-                SessionManager::sendTo(conn, resp);
-
-                if (lobby.phase != GamePhase::Lobby) {
-                    broadcastGameState(sessionId);
-                }
-                else {
-                    broadcastLobbyState(sessionId);
-                }
-            }
-            else {
-                SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Erro ao salvar Mestre.\"}");
-            }
+            SessionManager::log("[RECONNECT] Mestre " + cmd.masterName + " voltou para sessao " + cmd.sessionId);
         }
         });
 }
 
-void HttpServer::processGetLobbyInfo(crow::websocket::connection* conn, const std::string& sessionId) {
-    taskQueue->enqueue([this, conn, sessionId]() {
-        auto lobbyOpt = storage->getLobby(sessionId);
+void HttpServer::processGetLobbyInfo(crow::websocket::connection* conn, Protocol::SessionCommand cmd) {
+    submit(conn, MessageClass::Query, [this, conn, cmd = std::move(cmd)]() {
+        auto lobbyOpt = lobbies->get(cmd.sessionId);
         if (lobbyOpt) {
             auto& lobby = *lobbyOpt;
-            std::ostringstream oss;
-            oss << "{\"type\":\"LOBBY_INFO\",\"exists\":true,\"sessionId\":\"" << lobby.sessionId << "\",";
-            oss << "\"players\":[";
-            bool first = true;
-            for (const auto& p : lobby.players) {
-                if (!first) oss << ",";
-                oss << "{\"name\":\"" << escapeJSON(p.name) << "\",\"role\":" << (int)p.role << "}";
-                first = false;
-            }
-            oss << "]}";
-            SessionManager::sendTo(conn, oss.str());
+            SessionManager::sendTo(conn, encodeMessage(256, [&](auto& w) {
+                w.beginObject()
+                    .field("type", "LOBBY_INFO")
+                    .field("exists", true)
+                    .field("sessionId", lobby.sessionId);
+                w.key("players").beginArray();
+                for (const auto& p : lobby.players) {
+                    w.beginObject().field("name", p.name).field("role", p.role).endObject();
+                }
+                w.endArray().endObject();
+                }));
         }
         else {
-            SessionManager::sendTo(conn, "{\"type\":\"LOBBY_INFO\",\"exists\":false}");
+            SessionManager::sendTo(conn, encodeMessage(64, [](auto& w) {
+                w.beginObject().field("type", "LOBBY_INFO").field("exists", false).endObject();
+                }));
         }
         });
 }
 
-void HttpServer::processStartGame(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerName, const std::string& caseId) {
-    taskQueue->enqueue([this, conn, sessionId, playerName, caseId]() {
-        auto lobbyOpt = storage->getLobby(sessionId);
-        if (!lobbyOpt) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Lobby nao encontrado\"}");
-            return;
-        }
-
-        const auto& lobby = *lobbyOpt;
-
-        bool isHost = false;
-        for (const auto& p : lobby.players) {
-            if (p.name == playerName && p.role == PlayerRole::Host) {
-                isHost = true;
-                break;
+void HttpServer::processStartGame(crow::websocket::connection* conn, Protocol::StartGameCommand cmd) {
+    submit(conn, MessageClass::Lobby, [this, conn, cmd = std::move(cmd)]() {
+        // Em torneio o caso e o do torneio, ja compilado; o pedido do Host e ignorado.
+        std::string caseId = cmd.caseId;
+        if (!cmd.tournamentId.empty()) {
+            auto compiledCase = tournaments->caseFor(cmd.tournamentId);
+            if (!compiledCase) {
+                sendError(conn, "Torneio nao encontrado");
+                return;
             }
+            caseId = compiledCase->data.id;
         }
 
-        if (!isHost) {
-            SessionManager::log("[WARN] Tentativa de inicio por nao-host: " + playerName);
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Permissao negada. Apenas o Host pode iniciar.\"}");
-            return;
-        }
+        auto start = lobbies->beginGame(cmd.sessionId, cmd.playerName);
 
-        if (!lobby.canStartGame()) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Nao e possivel iniciar. Aguardando Mestre ou Jogadores.\"}");
+        switch (start.result) {
+        case StartResult::NotFound:
+            sendError(conn, "Lobby nao encontrado");
+            return;
+        case StartResult::NotHost:
+            SessionManager::log("[WARN] Tentativa de inicio por nao-host: " + cmd.playerName);
+            sendError(conn, "Permissao negada. Apenas o Host pode iniciar.");
             return;
+        case StartResult::NotReady:
+            sendError(conn, "Nao e possivel iniciar. Aguardando Mestre ou Jogadores.");
+            return;
+        case StartResult::AlreadyStarted:
+            sendError(conn, "O jogo ja foi iniciado.");
+            return;
+        case StartResult::Started:
+            break;
         }
 
+        const auto& lobby = start.lobby;
+
         std::vector<std::string> allParticipants;
         std::string hostPlayerId;
         std::string masterPlayerId;
@@ -496,198 +650,528 @@ void HttpServer::processStartGame(crow::websocket::connection* conn, const std::
             }
         }
 
-        if (!engine->initializeGameFromLobby(sessionId, caseId, allParticipants, hostPlayerId, masterPlayerId)) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Erro ao criar sessao de jogo no banco.\"}");
+        if (!engine->initializeGameFromLobby(cmd.sessionId, caseId, allParticipants, hostPlayerId, masterPlayerId)) {
+            lobbies->abortStart(cmd.sessionId);
+            sendError(conn, "Erro ao criar sessao de jogo no banco.");
             return;
         }
 
-        if (storage->updatePhase(sessionId, GamePhase::Investigation)) {
-            std::string msg = std::format(
-                "{{\"type\":\"GAME_STARTED\",\"sessionId\":\"{}\",\"caseId\":\"{}\"}}",
-                sessionId, escapeJSON(caseId)
-            );
-            sessionManager->broadcastToSession(sessionId, msg);
-            SessionManager::log("[GAME] Jogo iniciado pelo Host " + playerName + " na sessao " + sessionId);
+        sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(128, [&](auto& w) {
+            w.beginObject()
+                .field("type", "GAME_STARTED")
+                .field("sessionId", cmd.sessionId)
+                .field("caseId", caseId)
+                .endObject();
+            }));
+        SessionManager::log("[GAME] Jogo iniciado pelo Host " + cmd.playerName + " na sessao " + cmd.sessionId);
+
+        if (!cmd.tournamentId.empty()) {
+            if (auto change = tournaments->enroll(cmd.tournamentId, cmd.sessionId, cmd.playerName)) broadcastStanding(*change);
         }
+
+        // Primeiro prazo possivel; a avaliacao reagenda para o limite online se o jogador estiver conectado.
+        turnTimer->schedule(cmd.sessionId, std::chrono::system_clock::now() + kOfflineTurnLimit);
         });
 }
 
-void HttpServer::processSubmitSolution(crow::websocket::connection* conn, const std::string& sessionId, const std::vector<std::string>& answers) {
-    taskQueue->enqueue([this, conn, sessionId, answers]() {
-        auto gameStateOpt = storage->getGameState(sessionId);
-        if (!gameStateOpt) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Sessao de jogo nao encontrada.\"}");
-            return;
-        }
+void HttpServer::processCreateTournament(crow::websocket::connection* conn, Protocol::CreateTournamentCommand cmd) {
+    if (!isValidPlayerName(cmd.name)) {
+        sendError(conn, kInvalidNameError);
+        return;
+    }
+
+    std::string tournamentId = generateSessionId();
 
-        auto bugCaseOpt = storage->getCase(gameStateOpt->currentCaseId);
-        if (!bugCaseOpt) {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Caso nao encontrado no banco.\"}");
+    submit(conn, MessageClass::Lobby, [this, conn, tournamentId, cmd = std::move(cmd)]() {
+        auto compiledCase = engine->getCase(cmd.caseId);
+        if (!compiledCase) {
+            sendError(conn, "Caso nao encontrado no banco.");
             return;
         }
 
-        const auto& bugCase = *bugCaseOpt;
+        auto info = tournaments->create(tournamentId, cmd.name, std::move(compiledCase));
 
-        std::ostringstream oss;
-        oss << "{\"type\":\"SOLUTION_FOR_REVIEW\",";
-        oss << "\"sessionId\":\"" << sessionId << "\",";
+        SessionManager::sendTo(conn, encodeMessage(128, [&](auto& w) {
+            w.beginObject()
+                .field("type", "TOURNAMENT_CREATED")
+                .field("tournamentId", info.id)
+                .field("name", info.name)
+                .field("caseId", info.caseId)
+                .endObject();
+            }));
 
-        oss << "\"teamAnswers\":[";
-        for (size_t i = 0; i < answers.size(); ++i) {
-            if (i > 0) oss << ",";
-            oss << "\"" << escapeJSON(answers[i]) << "\"";
+        SessionManager::log("[TOURNAMENT] Criado: " + tournamentId + " (" + info.caseId + ")");
+        });
+}
+
+void HttpServer::processSpectateTournament(crow::websocket::connection* conn, Protocol::SpectateTournamentCommand cmd) {
+    submit(conn, MessageClass::Query, [this, conn, cmd = std::move(cmd)]() {
+        auto view = tournaments->view(cmd.tournamentId);
+        if (!view) {
+            sendError(conn, "Torneio nao encontrado");
+            return;
         }
-        oss << "],";
 
-        oss << "\"questions\":[";
-        for (size_t i = 0; i < bugCase.solutionQuestions.size(); ++i) {
-            if (i > 0) oss << ",";
-            oss << "\"" << escapeJSON(bugCase.solutionQuestions[i]) << "\"";
+        // Registra antes de montar o snapshot: deltas posteriores a version chegam por broadcast.
+        if (!sessionManager->registerSpectator(TournamentRegistry::channelFor(cmd.tournamentId), conn)) {
+            sendError(conn, "Jogadores em partida nao podem acompanhar torneios por esta conexao.");
+            return;
         }
-        oss << "],";
 
-        oss << "\"correctAnswers\":[";
-        for (size_t i = 0; i < bugCase.correctAnswers.size(); ++i) {
-            if (i > 0) oss << ",";
-            oss << "\"" << escapeJSON(bugCase.correctAnswers[i]) << "\"";
+        SessionManager::sendTo(conn, encodeMessage(256 + view->top.size() * 96, [&](auto& w) {
+            w.beginObject()
+                .field("type", "LEADERBOARD")
+                .field("tournamentId", view->info.id)
+                .field("name", view->info.name)
+                .field("caseId", view->info.caseId)
+                .field("version", view->version)
+                .field("teams", view->teams);
+            w.key("standings").beginArray();
+            for (size_t i = 0; i < view->top.size(); ++i) {
+                const auto& s = view->top[i];
+                w.beginObject()
+                    .field("sessionId", s.sessionId)
+                    .field("team", view->teamNames[i])
+                    .field("score", s.score)
+                    .field("rank", s.rank)
+                    .endObject();
+            }
+            w.endArray().endObject();
+            }));
+        });
+}
+
+void HttpServer::processSubmitSolution(crow::websocket::connection* conn, Protocol::SubmitSolutionCommand cmd) {
+    submit(conn, MessageClass::Game, [this, conn, cmd = std::move(cmd)]() {
+        auto submission = engine->submitToMaster(cmd.sessionId, cmd.answers);
+        if (!submission.success) {
+            sendError(conn, submission.message);
+            return;
         }
-        oss << "]";
 
-        oss << "}";
+        // Caso ja compilado pelo submitToMaster: vem do cache.
+        auto compiledCase = engine->getCase(submission.newState.currentCaseId);
+        if (!compiledCase) {
+            sendError(conn, "Caso nao encontrado no banco.");
+            return;
+        }
 
-        sessionManager->broadcastToSession(sessionId, oss.str());
+        sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(1024, [&](auto& w) {
+            Protocol::writeSolutionForReview(w, cmd.sessionId, cmd.answers, compiledCase->data, submission.review);
+            }));
 
-        SessionManager::log("[GAME] Solucao enviada para revisao do Mestre na sessao: " + sessionId);
+        SessionManager::log("[GAME] Solucao enviada para revisao do Mestre na sessao: " + cmd.sessionId);
         });
 }
 
-void FindTheBug::HttpServer::processValidateSolution(crow::websocket::connection* conn, const std::string& sessionId, bool approved)
+void HttpServer::processValidateSolution(crow::websocket::connection* conn, Protocol::ValidateSolutionCommand cmd)
 {
-    taskQueue->enqueue([this, sessionId, approved]() {
+    submit(conn, MessageClass::Control, [this, cmd = std::move(cmd)]() {
 
-        GameResult result = engine->finalizeSession(sessionId, approved);
+        auto finalized = engine->finalizeSession(cmd.sessionId, cmd.approved);
+        GameResult result = finalized.outcome;
+        const auto& state = finalized.newState;
+        if (state) reportStanding(*state, result);
 
         if (result == GameResult::Victory) {
-            sessionManager->broadcastToSession(sessionId, "{\"type\":\"GAME_VICTORY\"}");
-            SessionManager::log("[GAME] Vitoria na sessao " + sessionId + ". Encerrando.");
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(32, [](auto& w) {
+                w.beginObject().field("type", "GAME_VICTORY").endObject();
+                }));
+            SessionManager::log("[GAME] Vitoria na sessao " + cmd.sessionId + ". Encerrando.");
 
-            storage->deleteSession(sessionId);
-            sessionManager->closeSession(sessionId);
+            turnTimer->cancel(cmd.sessionId);
+
+            endSession(cmd.sessionId);
         }
         else if (result == GameResult::Defeat) {
-            sessionManager->broadcastToSession(sessionId, "{\"type\":\"GAME_OVER\"}");
-            SessionManager::log("[GAME] Derrota na sessao " + sessionId + ". Encerrando.");
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(32, [](auto& w) {
+                w.beginObject().field("type", "GAME_OVER").endObject();
+                }));
+            SessionManager::log("[GAME] Derrota na sessao " + cmd.sessionId + ". Encerrando.");
+
+            turnTimer->cancel(cmd.sessionId);
 
-            storage->deleteSession(sessionId);
-            sessionManager->closeSession(sessionId);
+            endSession(cmd.sessionId);
         }
         else {
-            broadcastLobbyState(sessionId);
-
-            sessionManager->broadcastToSession(sessionId, "{\"type\":\"SOLUTION_REJECTED\",\"message\":\"Solucao incorreta. Penalidade aplicada.\"}");
+            if (state) publishGameState(*state);
+            broadcastLobbyState(cmd.sessionId);
+
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(128, [](auto& w) {
+                w.beginObject()
+                    .field("type", "SOLUTION_REJECTED")
+                    .field("message", "Solucao incorreta. Penalidade aplicada.")
+                    .endObject();
+                }));
         }
         });
 }
 
-void HttpServer::processGameAction(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerId, ActionType actionType, const std::string& targetId) {
-    taskQueue->enqueue([this, conn, sessionId, playerId, actionType, targetId]() {
+void HttpServer::processGameAction(crow::websocket::connection* conn, Protocol::GameActionCommand cmd) {
+    submit(conn, MessageClass::Game, [this, conn, cmd = std::move(cmd)]() {
 
-        auto result = engine->processAction(playerId, actionType, targetId, sessionId);
+        auto result = engine->processAction(cmd.playerId, cmd.actionType, cmd.targetId, cmd.sessionId);
 
         if (!result.success) {
-            std::string err = std::format("{{\"type\":\"ERROR\",\"message\":\"{}\"}}", escapeJSON(result.message));
-            SessionManager::sendTo(conn, err);
+            sendError(conn, result.message);
             return;
         }
 
-        broadcastGameState(sessionId);
+        armTurnTimer(result.newState);
+        publishGameState(result.newState);
+        reportStanding(result.newState, GameResult::Running);
 
         if (result.revealedClue) {
-            std::string revealMsg = std::format(
-                "{{\"type\":\"CLUE_REVEALED\",\"clueId\":\"{}\",\"content\":\"{}\",\"duration\":30,\"investigator\":\"{}\"}}",
-                result.revealedClue->id,
-                escapeJSON(result.revealedClue->content),
-                playerId
-            );
-            sessionManager->broadcastToSession(sessionId, revealMsg);
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(256 + result.revealedClue->content.size(), [&](auto& w) {
+                Protocol::writeClueRevealed(w, *result.revealedClue, result.revealBonusSeconds, cmd.playerId);
+                }));
+        }
+        });
+}
+
+void HttpServer::processSaveNote(crow::websocket::connection* conn, Protocol::SaveNoteCommand cmd) {
+    submit(conn, MessageClass::Game, [this, conn, cmd = std::move(cmd)]() {
+
+        auto result = engine->savePlayerNote(cmd.sessionId, cmd.playerId, cmd.clueId, cmd.content);
+
+        if (!result.success) {
+            sendError(conn, result.message);
+            return;
         }
+
+        publishNote(cmd.sessionId, cmd.playerId, cmd.clueId, cmd.content);
         });
 }
 
-void HttpServer::processSaveNote(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerId, const std::string& clueId, const std::string& content) {
-    taskQueue->enqueue([this, conn, sessionId, playerId, clueId, content]() {
+void HttpServer::processResync(crow::websocket::connection* conn, Protocol::SessionCommand cmd) {
+    // So quem esta na sessao recebe o estado dela.
+    if (sessionManager->memberOf(conn).sessionId != cmd.sessionId) {
+        sendError(conn, "Conexao nao pertence a sessao.");
+        return;
+    }
+    submit(conn, MessageClass::Query, [this, conn, cmd = std::move(cmd)]() { sendGameSnapshot(conn, cmd.sessionId); });
+}
+
+void HttpServer::processEditSharedNote(crow::websocket::connection* conn, Protocol::EditSharedNoteCommand cmd) {
+    submit(conn, MessageClass::Game, [this, conn, cmd = std::move(cmd)]() mutable {
+
+        auto result = engine->editSharedNote(cmd.sessionId, cmd.playerId, cmd.clueId, cmd.ops);
 
-        bool success = engine->savePlayerNote(sessionId, playerId, clueId, content);
+        if (!result.success) {
+            sendError(conn, result.message);
+            return;
+        }
+
+        // Repassa so as operacoes; cada cliente aplica na propria replica e converge sem reenviar o texto.
+        sequencer->publishEvent(cmd.sessionId, [&](uint64_t seq) {
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(128 + cmd.ops.size() * 96, [&](auto& w) {
+                w.beginObject()
+                    .field("type", "NOTE_OPS")
+                    .field("sessionId", cmd.sessionId)
+                    .field("seq", seq)
+                    .field("clueId", cmd.clueId)
+                    .field("ops", cmd.ops)
+                    .endObject();
+                }));
+            });
+        });
+}
+
+void HttpServer::processGameBatch(crow::websocket::connection* conn, Protocol::GameBatchCommand cmd) {
+    submit(conn, MessageClass::Game, [this, conn, cmd = std::move(cmd)]() {
 
-        if (success) {
+        auto batch = engine->processActions(cmd.sessionId, cmd.commands);
 
-            broadcastGameState(sessionId);
+        if (!batch.success && batch.results.empty()) {
+            sendError(conn, batch.message);
+            return;
         }
-        else {
-            SessionManager::sendTo(conn, "{\"type\":\"ERROR\",\"message\":\"Falha ao salvar nota (Pista nao encontrada?)\"}");
+
+        bool anyApplied = std::any_of(batch.results.begin(), batch.results.end(), [](const auto& r) { return r.success; });
+        SessionManager::sendTo(conn, encodeMessage(256, [&](auto& w) {
+            w.beginObject()
+                .field("type", "BATCH_RESULT")
+                .field("sessionId", cmd.sessionId)
+                .field("persisted", batch.success);
+            w.key("results").beginArray();
+            for (const auto& r : batch.results) {
+                w.beginObject().field("success", r.success).field("message", r.message).endObject();
+            }
+            w.endArray().endObject();
+            }));
+
+        if (!batch.success || !anyApplied) return;
+
+        armTurnTimer(batch.newState);
+        publishGameState(batch.newState);
+        reportStanding(batch.newState, GameResult::Running);
+
+        // O patch nao carrega notas: cada nota gravada no lote vira seu proprio evento.
+        for (size_t i = 0; i < batch.results.size(); ++i) {
+            const auto& command = cmd.commands[i];
+            if (batch.results[i].success && command.kind == CommandKind::SaveNote) {
+                publishNote(cmd.sessionId, command.playerId, command.clueId, command.content);
+            }
+        }
+
+        for (size_t i = 0; i < batch.results.size(); ++i) {
+            const auto& r = batch.results[i];
+            if (!r.success || !r.revealedClue) continue;
+
+            sessionManager->broadcastToSession(cmd.sessionId, encodeMessage(256 + r.revealedClue->content.size(), [&](auto& w) {
+                Protocol::writeClueRevealed(w, *r.revealedClue, r.revealBonusSeconds, cmd.commands[i].playerId);
+                }));
         }
         });
 }
 
-// Helpers
+// Vale para esta conexao, em qualquer sessao. O HELLO_ACK ja sai no formato novo; o que estava na fila
+// sai no formato antigo, e o tipo do frame (texto ou binario) diz ao cliente como decodificar cada um.
+void HttpServer::processHello(crow::websocket::connection* conn, Protocol::HelloCommand cmd) {
+    WireFormat format;
+    if (cmd.encoding == "json") format = WireFormat::Json;
+    else if (cmd.encoding == "msgpack") format = WireFormat::MsgPack;
+    else {
+        sendError(conn, "Formato desconhecido: use json ou msgpack");
+        return;
+    }
 
-void HttpServer::broadcastGameState(const std::string& sessionId) {
-    auto stateOpt = storage->getGameState(sessionId);
-    if (!stateOpt) return;
-    auto& state = *stateOpt;
+    SessionManager::setWireFormat(conn, format);
+    SessionManager::sendTo(conn, encodeMessage(64, [&](auto& w) {
+        w.beginObject().field("type", "HELLO_ACK").field("encoding", cmd.encoding).endObject();
+        }));
+}
 
-    crow::json::wvalue json;
-    json["type"] = "GAME_STATE_UPDATE";
-    json["sessionId"] = state.sessionId;
-    json["currentDay"] = state.currentDay;
-    json["remainingPoints"] = state.remainingPoints;
+// Presenca
 
-    json["currentTurnIndex"] = state.currentTurnIndex;
-    if (!state.turnOrder.empty()) {
-        json["currentTurnPlayer"] = state.turnOrder[state.currentTurnIndex];
+void HttpServer::registerPlayer(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName) {
+    sessionManager->registerConnection(sessionId, conn, playerName);
+    if (auto change = presence->touch(sessionId, playerName, std::chrono::system_clock::now())) {
+        publishPresence(*change);
     }
+}
 
-    std::vector<crow::json::wvalue> cluesJson;
-    for (const auto& c : state.discoveredClues) {
-        crow::json::wvalue cj;
-        cj["id"] = c.id;
-        cj["targetId"] = c.targetId;
-        cj["type"] = static_cast<int>(c.type);
-        cj["content"] = c.content;
+void HttpServer::leaveSession(crow::websocket::connection* conn) {
+    auto member = sessionManager->unregisterConnection(conn);
+    if (member.sessionId.empty()) return;
 
-        crow::json::wvalue notesJson;
-        for (const auto& pair : c.playerNotes) {
-            notesJson[pair.first] = pair.second;
+    // Offline so quando fecha a ultima conexao do jogador na sessao.
+    if (!member.playerName.empty() && !sessionManager->isPlayerOnline(member.sessionId, member.playerName)) {
+        if (auto change = presence->disconnect(member.sessionId, member.playerName)) {
+            publishPresence(*change);
+            return;
         }
-        cj["playerNotes"] = std::move(notesJson);
+    }
+    // Se era o jogador da vez, o limite offline pode ja ter estourado.
+    turnTimer->expedite(member.sessionId, std::chrono::system_clock::now());
+}
+
+void HttpServer::publishPresence(const PresenceChange& change) {
+    int64_t lastSeen = std::chrono::duration_cast<std::chrono::milliseconds>(change.lastSeen.time_since_epoch()).count();
+    sessionManager->broadcastToSession(change.sessionId, encodeMessage(160, [&](auto& w) {
+        Protocol::writePresence(w, change.sessionId, change.playerName, change.online, lastSeen);
+        }));
+
+    // Jogador da vez que caiu: o prazo passa a ser o limite offline, possivelmente ja vencido.
+    if (!change.online) turnTimer->expedite(change.sessionId, std::chrono::system_clock::now());
+}
+
+// Turnos
 
-        cluesJson.push_back(cj);
+void HttpServer::armTurnTimer(const GameState& state) {
+    if (state.isCompleted || state.turnOrder.empty()) {
+        turnTimer->cancel(state.sessionId);
+        return;
     }
-    json["discoveredClues"] = std::move(cluesJson);
 
-    sessionManager->broadcastToSession(sessionId, json.dump());
+    const auto& currentPlayer = state.turnOrder[state.currentTurnIndex];
+    auto limit = presence->isOnline(state.sessionId, currentPlayer, std::chrono::system_clock::now()) ? kOnlineTurnLimit : kOfflineTurnLimit;
+    turnTimer->schedule(state.sessionId, state.turnStartTime + limit);
 }
 
-void HttpServer::broadcastLobbyState(const std::string& sessionId) {
-    auto lobbyOpt = storage->getLobby(sessionId);
-    if (!lobbyOpt) return;
+void HttpServer::handleTurnDeadline(const std::string& sid) {
+    auto stateOpt = storage->getGameState(sid);
+    if (!stateOpt) {
+        engine->forgetSession(sid);
+        lobbies->forget(sid);
+        return;
+    }
+    auto state = *stateOpt;
+
+    auto now = std::chrono::system_clock::now();
+
+    if (state.isCompleted) {
+        if (now - state.lastActivity > kCompletedRetention) {
+            SessionManager::log("[REAPER] Jogo finalizado ha >60s na sessao " + sid + ". Deletando.");
+            endSession(sid);
+        }
+        else {
+            turnTimer->schedule(sid, state.lastActivity + kCompletedRetention + std::chrono::seconds(1));
+        }
+        return;
+    }
+
+    if (state.turnOrder.empty()) {
+        endSession(sid);
+        return;
+    }
+
+    std::string currentPlayer = state.turnOrder[state.currentTurnIndex];
+    bool isOnline = presence->isOnline(sid, currentPlayer, now);
+    auto deadline = state.turnStartTime + (isOnline ? kOnlineTurnLimit : kOfflineTurnLimit);
+
+    if (now < deadline) {
+        turnTimer->schedule(sid, deadline);
+        return;
+    }
 
-    auto& lobby = *lobbyOpt;
-    std::ostringstream oss;
-    oss << "{\"type\":\"LOBBY_UPDATE\",\"sessionId\":\"" << lobby.sessionId << "\",";
-    oss << "\"canStart\":" << (lobby.canStartGame() ? "true" : "false") << ",";
-    oss << "\"players\":[";
-
-    bool first = true;
-    for (const auto& p : lobby.players) {
-        if (p.role == PlayerRole::Master) continue;
-        if (!first) oss << ",";
-        oss << "{\"name\":\"" << escapeJSON(p.name) << "\",\"role\":" << (int)p.role << "}";
-        first = false;
+    // Escrita condicional ao turno lido: uma acao que passou a vez neste meio tempo vence o prazo.
+    auto skipped = storage->skipTurn(sid, state.currentTurnIndex, state.turnStartTime, now);
+    if (!skipped) {
+        if (auto fresh = storage->getGameState(sid)) armTurnTimer(*fresh);
+        return;
     }
-    oss << "]}";
 
-    sessionManager->broadcastToSession(sessionId, oss.str());
+    publishGameState(*skipped);
+    sessionManager->broadcastToSession(sid, encodeMessage(128, [&](auto& w) {
+        w.beginObject()
+            .field("type", "TURN_SKIPPED")
+            .field("previousPlayer", currentPlayer)
+            .field("reason", isOnline ? "TIMEOUT" : "OFFLINE_SKIP")
+            .endObject();
+        }));
+
+    armTurnTimer(*skipped);
+}
+
+// Helpers
+
+// Remove a sessao do banco e de todo estado deste no que a referencia.
+void HttpServer::endSession(const std::string& sessionId) {
+    storage->deleteSession(sessionId);
+    forgetSession(sessionId);
+}
+
+// Sessao que ja saiu do banco (encerrada ou removida pelo reaper): descarta o que ficou em memoria.
+void HttpServer::forgetSession(const std::string& sessionId) {
+    turnTimer->cancel(sessionId);
+    engine->forgetSession(sessionId);
+    lobbies->forget(sessionId);
+    tournaments->forgetSession(sessionId);
+    sequencer->forget(sessionId);
+    admission->forgetSession(sessionId);
+    presence->forgetSession(sessionId);
+    sessionManager->closeSession(sessionId);
+}
+
+void HttpServer::reportStanding(const GameState& state, GameResult outcome) {
+    if (auto change = tournaments->report(state, outcome)) broadcastStanding(*change);
+}
+
+// Apenas o time que mudou; o espectador reordena a propria lista pelo score.
+void HttpServer::broadcastStanding(const StandingChange& change) {
+    sessionManager->broadcastToSession(TournamentRegistry::channelFor(change.tournamentId), encodeMessage(256, [&](auto& w) {
+        w.beginObject()
+            .field("type", "LEADERBOARD_DELTA")
+            .field("tournamentId", change.tournamentId)
+            .field("version", change.version)
+            .field("sessionId", change.sessionId)
+            .field("team", change.teamName)
+            .field("score", change.score)
+            .field("rank", change.rank)
+            .field("previousRank", change.previousRank)
+            .endObject();
+        }));
+}
+
+// O total de cobertura vem do caso compilado em cache.
+InvestigationCoverage HttpServer::coverageTotals(const GameState& state) {
+    auto compiledCase = engine->getCase(state.currentCaseId);
+    return compiledCase ? compiledCase->coverageTotals : InvestigationCoverage{};
+}
+
+void HttpServer::sendGameSnapshot(crow::websocket::connection* conn, const std::string& sessionId) {
+    // Leitura dentro do lock da sessao: nenhum patch sai entre o seq do snapshot e o envio.
+    sequencer->withCurrentSeq(sessionId, [&](uint64_t seq) {
+        auto stateOpt = storage->getGameState(sessionId);
+        if (!stateOpt) return;
+
+        SessionManager::sendTo(conn, encodeMessage(512 + stateOpt->discoveredClues.size() * 256, [&](auto& w) {
+            Protocol::writeGameSnapshot(w, *stateOpt, seq, coverageTotals(*stateOpt));
+            }));
+        });
+}
+
+// Envia so o que mudou desde o ultimo estado publicado: o tamanho nao cresce com a partida.
+// Valores escalares vao absolutos; pistas novas sao anexadas (o cliente ignora ids repetidos).
+void HttpServer::publishGameState(const GameState& state) {
+    sequencer->publishState(state, [&](uint64_t seq, const StateSummary* previous) {
+        bool rebased = !previous
+            || previous->turnOrder != state.turnOrder
+            || previous->clueCount > state.discoveredClues.size();
+
+        if (rebased) {
+            sessionManager->broadcastToSession(state.sessionId, encodeMessage(512 + state.discoveredClues.size() * 256, [&](auto& w) {
+                Protocol::writeGameSnapshot(w, state, seq, coverageTotals(state));
+                }));
+            return;
+        }
+
+        sessionManager->broadcastToSession(state.sessionId, encodeMessage(256, [&](auto& w) {
+            w.beginObject()
+                .field("type", "GAME_STATE_PATCH")
+                .field("sessionId", state.sessionId)
+                .field("seq", seq)
+                .field("revision", state.revision);
+
+            if (state.currentDay != previous->currentDay) w.field("currentDay", state.currentDay);
+            if (state.remainingPoints != previous->remainingPoints) w.field("remainingPoints", state.remainingPoints);
+            if (state.currentTurnIndex != previous->currentTurnIndex) Protocol::writeTurn(w, state);
+            if (state.isSuddenDeath != previous->isSuddenDeath) w.field("isSuddenDeath", state.isSuddenDeath);
+            if (state.isCompleted != previous->isCompleted) w.field("isCompleted", state.isCompleted);
+
+            if (state.discoveredClues.size() > previous->clueCount) {
+                w.key("newClues").beginArray();
+                for (size_t i = previous->clueCount; i < state.discoveredClues.size(); ++i) {
+                    w.value(state.discoveredClues[i]);
+                }
+                w.endArray().key("coverage");
+                Protocol::writeCoverage(w, state.coverage, coverageTotals(state));
+            }
+            w.endObject();
+
+            }));
+        });
+}
+
+// So a nota muda: o evento carrega a nota, nao o estado inteiro.
+void HttpServer::publishNote(const std::string& sessionId, const std::string& playerId, const std::string& clueId, const std::string& content) {
+    sequencer->publishEvent(sessionId, [&](uint64_t seq) {
+        sessionManager->broadcastToSession(sessionId, encodeMessage(128 + content.size(), [&](auto& w) {
+            w.beginObject()
+                .field("type", "NOTE_UPDATED")
+                .field("sessionId", sessionId)
+                .field("seq", seq)
+                .field("clueId", clueId)
+                .field("playerId", playerId);
+            if (content.empty()) w.field("removed", true);
+            else w.field("content", content);
+            w.endObject();
+            }));
+        });
+}
+
+void HttpServer::broadcastLobbyState(const std::string& sessionId) {
+    auto lobbyOpt = lobbies->get(sessionId);
+    if (!lobbyOpt) return;
+    broadcastLobbyState(*lobbyOpt);
+}
+
+void HttpServer::broadcastLobbyState(const LobbyInfo& lobby) {
+    // Roster completo: uma versao mais nova substitui a que ainda estiver na fila.
+    sessionManager->broadcastToSession(lobby.sessionId, encodeMessage(256, [&](auto& w) {
+        Protocol::writeLobbyUpdate(w, lobby);
+        }), "LOBBY_UPDATE");
 }
 
 std::string HttpServer::generateSessionId() {
@@ -1,48 +1,116 @@
 #pragma once
 
+#include <condition_variable>
 #include <memory>
+#include <memory_resource>
 #include <crow.h>
+#include <mutex>
+#include <stop_token>
 #include <string>
+#include <thread>
 
 #include "../engine/GameEngine.hpp"
 #include "../storage/MongoStore.hpp"
 #include "../infra/TaskQueue.hpp"
+#include "../infra/TurnTimer.hpp"
+#include "../protocol/Commands.hpp"
+#include "LobbyRegistry.hpp"
+#include "TournamentRegistry.hpp"
+#include "StateSequencer.hpp"
 #include "SessionManager.hpp"
+#include "CaseResponses.hpp"
+#include "AdmissionControl.hpp"
+#include "PresenceTracker.hpp"
+#include "HandoffSnapshot.hpp"
 
 namespace FindTheBug {
 
+    // Intervalo do PING e tempo sem nenhum frame do jogador ate considera-lo offline.
+    struct HeartbeatSettings {
+        std::chrono::milliseconds interval{ 5000 };
+        std::chrono::milliseconds timeout{ 15000 };
+    };
+
     class HttpServer {
     public:
         HttpServer(
             std::shared_ptr<GameEngine> engine,
             std::shared_ptr<MongoStore> storage,
             std::shared_ptr<SessionManager> sessionManager,
-            std::shared_ptr<TaskQueue> taskQueue
+            std::shared_ptr<TaskQueue> taskQueue,
+            HeartbeatSettings heartbeat = {}
             );
-        ~HttpServer() = default;
+        ~HttpServer();
 
         void runReaper();
+        void runHeartbeat();
         void run(uint16_t port = 8080);
+
+        // Seguro em handler de sinal: run() percebe, faz o drain e para o Crow.
+        static void requestShutdown();
+        // Carrega o snapshot deixado pelo processo anterior (se houver) e grava um novo no drain.
+        void enableHandoff(std::string snapshotPath);
+        // Recusa novos comandos, para o trabalho de fundo, espera a fila de tarefas, grava o snapshot e manda
+        // RECONNECT a todos.
+        void drain();
+        // Para reaper, heartbeat, TurnTimer e watcher de casos e junta a TaskQueue: todos guardam this.
+        // Chamado por main depois de run(); o destrutor chama de novo por seguranca.
+        void shutdown();
     private:
 		// WebSocket handlers
 		void handleWebSocketOpen(crow::websocket::connection& conn);
 		void handleWebSocketClose(crow::websocket::connection& conn, const std::string& reason);
 		void handleWebSocketMessage(crow::websocket::connection& conn, const std::string& data, bool is_binary);
+        // Frame = Json::Object (texto) ou MsgPack::Object (binario).
+        template <typename Frame>
+        void dispatchCommand(crow::websocket::connection& conn, const Frame& frame);
+
+        // Tarefa de um comando de cliente: ocupa uma vaga da classe e a TaskQueue limitada; recusada, o cliente
+        // recebe OVERLOADED. Control tem folga reservada na fila (AdmissionControl::kQueueHeadroom).
+        template <typename Task>
+        void submit(crow::websocket::connection* conn, MessageClass cls, Task&& task);
 
         // Lgica de Negcio
-		void processCreateLobby(crow::websocket::connection* conn, const std::string& playerName);
-        void processJoinAsPlayer(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerName);
-		void processJoinAsMaster(crow::websocket::connection* conn, const std::string& sessionId, const std::string& masterName);
-		void processStartGame(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerName, const std::string& caseId);
-		void processGetLobbyInfo(crow::websocket::connection* conn, const std::string& sessionId);
-		void processSubmitSolution(crow::websocket::connection* conn, const std::string& sessionId, const std::vector<std::string>& answers);
-        void processValidateSolution(crow::websocket::connection* conn, const std::string& sessionId, bool approved);
-        void processGameAction(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerId, ActionType actionType, const std::string& targetId);
-        void processSaveNote(crow::websocket::connection* conn, const std::string& sessionId, const std::string& playerId, const std::string& clueId, const std::string& content);
+		void processCreateLobby(crow::websocket::connection* conn, Protocol::CreateLobbyCommand cmd);
+        void processJoinAsPlayer(crow::websocket::connection* conn, Protocol::JoinAsPlayerCommand cmd);
+		void processJoinAsMaster(crow::websocket::connection* conn, Protocol::JoinAsMasterCommand cmd);
+		void processStartGame(crow::websocket::connection* conn, Protocol::StartGameCommand cmd);
+		void processGetLobbyInfo(crow::websocket::connection* conn, Protocol::SessionCommand cmd);
+        void processCreateTournament(crow::websocket::connection* conn, Protocol::CreateTournamentCommand cmd);
+        void processSpectateTournament(crow::websocket::connection* conn, Protocol::SpectateTournamentCommand cmd);
+		void processSubmitSolution(crow::websocket::connection* conn, Protocol::SubmitSolutionCommand cmd);
+        void processValidateSolution(crow::websocket::connection* conn, Protocol::ValidateSolutionCommand cmd);
+        void processGameAction(crow::websocket::connection* conn, Protocol::GameActionCommand cmd);
+        void processSaveNote(crow::websocket::connection* conn, Protocol::SaveNoteCommand cmd);
+        void processEditSharedNote(crow::websocket::connection* conn, Protocol::EditSharedNoteCommand cmd);
+        void processResync(crow::websocket::connection* conn, Protocol::SessionCommand cmd);
+        void processGameBatch(crow::websocket::connection* conn, Protocol::GameBatchCommand cmd);
+        void processHello(crow::websocket::connection* conn, Protocol::HelloCommand cmd);
+
+        // Presenca
+        void registerPlayer(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName);
+        void leaveSession(crow::websocket::connection* conn);
+        void publishPresence(const PresenceChange& change);
+
+        // Turnos
+        void armTurnTimer(const GameState& state);
+        void handleTurnDeadline(const std::string& sessionId);
 
         // Helpers
-        void broadcastGameState(const std::string& sessionId);
+        void publishGameState(const GameState& state);
+        void publishNote(const std::string& sessionId, const std::string& playerId, const std::string& clueId, const std::string& content);
+        void sendGameSnapshot(crow::websocket::connection* conn, const std::string& sessionId);
+        InvestigationCoverage coverageTotals(const GameState& state);
 		void broadcastLobbyState(const std::string& sessionId);
+        void broadcastLobbyState(const LobbyInfo& lobby);
+        void endSession(const std::string& sessionId);
+        void forgetSession(const std::string& sessionId);
+        void reportStanding(const GameState& state, GameResult outcome);
+        // Para reaper, heartbeat e TurnTimer (drain e shutdown).
+        void stopBackgroundWork();
+        // Espera interval; false se a parada foi pedida antes.
+        bool sleepUnlessStopped(std::stop_token stop, std::chrono::milliseconds interval);
+        void broadcastStanding(const StandingChange& change);
 		std::string generateSessionId();
 
 		// Componentes
@@ -50,5 +118,20 @@ namespace FindTheBug {
         std::shared_ptr<MongoStore> storage;
         std::shared_ptr<SessionManager> sessionManager;
         std::shared_ptr<TaskQueue> taskQueue;
+        std::unique_ptr<TurnTimer> turnTimer;
+        std::unique_ptr<LobbyRegistry> lobbies;
+        std::unique_ptr<TournamentRegistry> tournaments;
+        std::unique_ptr<StateSequencer> sequencer;
+        std::unique_ptr<CaseResponses> caseResponses;
+        std::unique_ptr<AdmissionControl> admission;
+        std::unique_ptr<PresenceTracker> presence;
+        HeartbeatSettings heartbeat;
+        std::atomic<bool> draining{ false };
+        std::string snapshotPath;
+
+        std::mutex stopMutex;
+        std::condition_variable_any stopCv;
+        std::jthread reaperThread;
+        std::jthread heartbeatThread;
     };
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "LobbyRegistry.hpp"
+#include "SessionManager.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+using namespace FindTheBug;
+
+LobbyRegistry::LobbyRegistry(std::shared_ptr<MongoStore> storage, std::shared_ptr<TaskQueue> taskQueue)
+    : storage(std::move(storage)), taskQueue(std::move(taskQueue)) {
+}
+
+LobbyRegistry::Shard& LobbyRegistry::shardFor(const std::string& sessionId) {
+    return shards[std::hash<std::string>{}(sessionId) % kShards];
+}
+
+LobbyRegistry::Entry* LobbyRegistry::acquire(const std::string& sessionId, std::unique_lock<std::mutex>& lock) {
+    auto& shard = shardFor(sessionId);
+    lock = std::unique_lock(shard.mutex);
+
+    auto it = shard.lobbies.find(sessionId);
+    if (it != shard.lobbies.end()) {
+        it->second.lastUsed = std::chrono::steady_clock::now();
+        return &it->second;
+    }
+
+    // Leitura fora do lock; se outra tarefa carregou antes, vale a versao dela.
+    lock.unlock();
+    auto loaded = storage->getLobby(sessionId);
+    lock.lock();
+    if (!loaded) return nullptr;
+
+    auto [inserted, _] = shard.lobbies.try_emplace(sessionId, Entry{ .lobby = std::move(*loaded) });
+    return &inserted->second;
+}
+
+void LobbyRegistry::markDirty(const std::string& sessionId, Entry& entry) {
+    entry.lobby.lastActivity = std::chrono::system_clock::now();
+    entry.dirty = true;
+    if (entry.flushing) return;
+
+    entry.flushing = true;
+    taskQueue->enqueue([this, sessionId]() { flush(sessionId); });
+}
+
+void LobbyRegistry::flush(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+
+    while (true) {
+        LobbyInfo snapshot;
+        {
+            std::lock_guard lock(shard.mutex);
+            auto it = shard.lobbies.find(sessionId);
+            if (it == shard.lobbies.end()) return;
+
+            auto& entry = it->second;
+            if (!entry.dirty) {
+                entry.flushing = false;
+                return;
+            }
+            entry.dirty = false;
+            snapshot = entry.lobby;
+        }
+
+        if (!storage->saveLobby(snapshot)) {
+            SessionManager::log("[LOBBY] Falha ao persistir lobby " + sessionId);
+        }
+    }
+}
+
+std::optional<LobbyInfo> LobbyRegistry::create(const std::string& sessionId, const PlayerInfo& host) {
+    if (!isValidPlayerName(host.name)) return std::nullopt;
+
+    LobbyInfo lobby;
+    lobby.sessionId = sessionId;
+    lobby.phase = GamePhase::Lobby;
+    lobby.createdAt = std::chrono::system_clock::now();
+    lobby.lastActivity = lobby.createdAt;
+    lobby.players.push_back(host);
+
+    if (!storage->createLobby(lobby)) return std::nullopt;
+
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    shard.lobbies.insert_or_assign(sessionId, Entry{ .lobby = lobby });
+    return lobby;
+}
+
+std::optional<LobbyInfo> LobbyRegistry::get(const std::string& sessionId) {
+    std::unique_lock<std::mutex> lock;
+    auto* entry = acquire(sessionId, lock);
+    if (!entry) return std::nullopt;
+    return entry->lobby;
+}
+
+LobbyJoin LobbyRegistry::joinAsPlayer(const std::string& sessionId, const std::string& playerName) {
+    if (!isValidPlayerName(playerName)) return { JoinResult::InvalidName };
+
+    std::unique_lock<std::mutex> lock;
+    auto* entry = acquire(sessionId, lock);
+    if (!entry) return {};
+
+    auto& players = entry->lobby.players;
+    bool known = std::any_of(players.begin(), players.end(),
+        [&](const PlayerInfo& p) { return p.name == playerName; });
+
+    if (known) return { JoinResult::Rejoined, entry->lobby };
+
+    PlayerInfo p;
+    p.name = playerName;
+    p.role = PlayerRole::Player;
+    p.joinedAt = std::chrono::system_clock::now();
+    players.push_back(std::move(p));
+
+    markDirty(sessionId, *entry);
+    return { JoinResult::Joined, entry->lobby };
+}
+
+LobbyJoin LobbyRegistry::claimMaster(const std::string& sessionId, const std::string& masterName) {
+    if (!isValidPlayerName(masterName)) return { JoinResult::InvalidName };
+
+    std::unique_lock<std::mutex> lock;
+    auto* entry = acquire(sessionId, lock);
+    if (!entry) return {};
+
+    auto& players = entry->lobby.players;
+    for (const auto& p : players) {
+        if (p.role == PlayerRole::Master) {
+            return { p.name == masterName ? JoinResult::Rejoined : JoinResult::MasterTaken, entry->lobby };
+        }
+    }
+
+    bool nameInUse = std::any_of(players.begin(), players.end(),
+        [&](const PlayerInfo& p) { return p.name == masterName; });
+    if (nameInUse) return { JoinResult::NameTaken, entry->lobby };
+
+    PlayerInfo m;
+    m.name = masterName;
+    m.role = PlayerRole::Master;
+    m.joinedAt = std::chrono::system_clock::now();
+    players.push_back(std::move(m));
+
+    markDirty(sessionId, *entry);
+    return { JoinResult::Joined, entry->lobby };
+}
+
+LobbyStart LobbyRegistry::beginGame(const std::string& sessionId, const std::string& hostName) {
+    std::unique_lock<std::mutex> lock;
+    auto* entry = acquire(sessionId, lock);
+    if (!entry) return {};
+
+    auto& lobby = entry->lobby;
+    bool isHost = std::any_of(lobby.players.begin(), lobby.players.end(),
+        [&](const PlayerInfo& p) { return p.name == hostName && p.role == PlayerRole::Host; });
+
+    if (!isHost) return { StartResult::NotHost, lobby };
+    if (lobby.phase != GamePhase::Lobby) return { StartResult::AlreadyStarted, lobby };
+    if (!lobby.canStartGame()) return { StartResult::NotReady, lobby };
+
+    lobby.phase = GamePhase::Investigation;
+    markDirty(sessionId, *entry);
+    return { StartResult::Started, lobby };
+}
+
+void LobbyRegistry::abortStart(const std::string& sessionId) {
+    std::unique_lock<std::mutex> lock;
+    auto* entry = acquire(sessionId, lock);
+    if (!entry || entry->lobby.phase != GamePhase::Investigation) return;
+
+    entry->lobby.phase = GamePhase::Lobby;
+    markDirty(sessionId, *entry);
+}
+
+void LobbyRegistry::forget(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    shard.lobbies.erase(sessionId);
+}
+
+size_t LobbyRegistry::evictIdle(std::chrono::seconds maxIdle) {
+    auto cutoff = std::chrono::steady_clock::now() - maxIdle;
+    size_t evicted = 0;
+
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        evicted += std::erase_if(shard.lobbies, [cutoff](const auto& item) {
+            const auto& entry = item.second;
+            return !entry.dirty && !entry.flushing && entry.lastUsed < cutoff;
+        });
+    }
+    return evicted;
+}
+
+std::vector<LobbyInfo> LobbyRegistry::snapshot() {
+    std::vector<LobbyInfo> lobbies;
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        for (const auto& [sessionId, entry] : shard.lobbies) lobbies.push_back(entry.lobby);
+    }
+    return lobbies;
+}
+
+size_t LobbyRegistry::adopt(std::vector<LobbyInfo> lobbies) {
+    size_t adopted = 0;
+    for (auto& lobby : lobbies) {
+        auto& shard = shardFor(lobby.sessionId);
+        std::lock_guard lock(shard.mutex);
+        std::string sessionId = lobby.sessionId;
+        adopted += shard.lobbies.try_emplace(std::move(sessionId), Entry{ .lobby = std::move(lobby) }).second;
+    }
+    return adopted;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../shared/DTOs.hpp"
+#include "../storage/MongoStore.hpp"
+#include "../infra/TaskQueue.hpp"
+
+namespace FindTheBug {
+
+    enum class JoinResult {
+        Joined,
+        Rejoined,
+        NotFound,
+        NameTaken,
+        MasterTaken,
+        InvalidName
+    };
+
+    enum class StartResult {
+        Started,
+        NotFound,
+        NotHost,
+        NotReady,
+        AlreadyStarted
+    };
+
+    // Resultado de uma operacao: o roster ja atualizado, pronto para broadcast.
+    struct LobbyJoin {
+        JoinResult result{ JoinResult::NotFound };
+        LobbyInfo lobby;
+    };
+
+    struct LobbyStart {
+        StartResult result{ StartResult::NotFound };
+        LobbyInfo lobby;
+    };
+
+    // Lobbies autoritativos deste no. Entrar, reentrar, assumir o Mestre e iniciar sao atomicos por lobby;
+    // a gravacao no banco acontece depois, na TaskQueue, uma por vez por lobby e sempre com o roster mais recente.
+    // Lobbies ausentes (reinicio do servidor) sao carregados do banco na primeira operacao.
+    class LobbyRegistry {
+    public:
+        LobbyRegistry(std::shared_ptr<MongoStore> storage, std::shared_ptr<TaskQueue> taskQueue);
+
+        // Unica operacao sincrona: o documento precisa existir antes do GameState ser gravado nele.
+        std::optional<LobbyInfo> create(const std::string& sessionId, const PlayerInfo& host);
+
+        std::optional<LobbyInfo> get(const std::string& sessionId);
+
+        LobbyJoin joinAsPlayer(const std::string& sessionId, const std::string& playerName);
+        LobbyJoin claimMaster(const std::string& sessionId, const std::string& masterName);
+
+        // Lobby -> Investigation. Apenas uma chamada concorrente recebe Started.
+        LobbyStart beginGame(const std::string& sessionId, const std::string& hostName);
+        // Desfaz beginGame quando a criacao do jogo falha.
+        void abortStart(const std::string& sessionId);
+
+        void forget(const std::string& sessionId);
+        // Descarta da memoria lobbies sem atividade; o banco continua com a ultima versao gravada.
+        size_t evictIdle(std::chrono::seconds maxIdle);
+
+        // Handoff entre processos: copia dos lobbies em memoria, e a carga dela no processo novo.
+        // adopt nao substitui lobbies ja carregados e marca os adotados como gravados.
+        std::vector<LobbyInfo> snapshot();
+        size_t adopt(std::vector<LobbyInfo> lobbies);
+
+    private:
+        static constexpr size_t kShards = 32;
+
+        struct Entry {
+            LobbyInfo lobby;
+            bool dirty{ false };
+            bool flushing{ false };
+            std::chrono::steady_clock::time_point lastUsed{ std::chrono::steady_clock::now() };
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, Entry> lobbies;
+        };
+
+        Shard& shardFor(const std::string& sessionId);
+        // Retorna com o lock do shard tomado e a entrada carregada (ou nullptr se o lobby nao existe).
+        Entry* acquire(const std::string& sessionId, std::unique_lock<std::mutex>& lock);
+        void markDirty(const std::string& sessionId, Entry& entry);
+        void flush(const std::string& sessionId);
+
+        std::shared_ptr<MongoStore> storage;
+        std::shared_ptr<TaskQueue> taskQueue;
+        std::array<Shard, kShards> shards;
+    };
+}
@@ -0,0 +1,156 @@
+#include "Outbox.hpp"
+#include "../protocol/Messages.hpp"
+#include "../shared/JsonWriter.hpp"
+#include "../shared/MsgPack.hpp"
+
+#include <array>
+#include <chrono>
+#include <print>
+
+using namespace FindTheBug;
+
+namespace {
+
+    // {"type":"RESYNC_REQUIRED"} nos dois formatos, indexado por WireFormat.
+    const std::array<OutboundMessage, 2> kResyncRequired = {
+        std::make_shared<const std::string>("{\"type\":\"RESYNC_REQUIRED\"}"),
+        std::make_shared<const std::string>("\x81\xa4type\xafRESYNC_REQUIRED", 22)
+    };
+
+    // Mesmo PING do heartbeat: o cliente nao distingue os dois.
+    OutboundMessage encodePing(WireFormat format) {
+        int64_t t = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        auto out = std::make_shared<std::string>();
+        if (format == WireFormat::MsgPack) {
+            MsgPack::Writer<std::string> w(*out);
+            Protocol::writePing(w, t);
+        }
+        else {
+            Json::Writer<std::string> w(*out);
+            Protocol::writePing(w, t);
+        }
+        return out;
+    }
+}
+
+Outbox::Outbox(Sink sink) : sink(std::move(sink)) {
+}
+
+void Outbox::enqueue(OutboundMessage message, WireFormat format, std::string_view coalesceKey) {
+    if (!message) return;
+
+    {
+        std::lock_guard lock(mutex);
+        if (closed) return;
+
+        bool coalesced = false;
+        if (!coalesceKey.empty()) {
+            for (auto& item : queue) {
+                if (item.coalesceKey != coalesceKey) continue;
+                queued = queued - item.message->size() + message->size();
+                item.message = std::move(message);
+                item.format = format;
+                coalesced = true;
+                break;
+            }
+        }
+
+        if (!coalesced) {
+            // Consumidor lento: descarta o atraso em vez de crescer sem limite.
+            if (!queue.empty() && queued + message->size() > kMaxQueuedBytes) {
+                std::println("[WS] Fila de saida cheia ({} mensagens, {} bytes em voo). Descartando.",
+                    queue.size(), sentBytes - confirmedBytes);
+                queue.clear();
+                const auto& resync = kResyncRequired[static_cast<size_t>(format)];
+                queue.push_back({ resync, {}, format });
+                queued = resync->size();
+            }
+            queued += message->size();
+            queue.push_back({ std::move(message), std::string(coalesceKey), format });
+        }
+
+        if (draining) return;
+        draining = true;
+    }
+
+    drain();
+}
+
+void Outbox::acknowledge() {
+    {
+        std::lock_guard lock(mutex);
+        if (pings.empty()) return;
+        confirmedBytes = pings.front();
+        pings.pop_front();
+
+        if (draining || closed || queue.empty()) return;
+        draining = true;
+    }
+
+    drain();
+}
+
+// Cada passada entrega ao Crow o que cabe no limite em voo; ele junta os frames pendentes numa unica escrita.
+void Outbox::drain() {
+    std::deque<Item> batch;
+    while (true) {
+        {
+            std::lock_guard lock(mutex);
+            while (!queue.empty() && sentBytes - confirmedBytes < kMaxInFlightBytes) {
+                auto& item = queue.front();
+                size_t size = item.message->size();
+                WireFormat itemFormat = item.format;
+                bool isPing = item.coalesceKey == kPingKey;
+
+                queued -= size;
+                sentBytes += size;
+                unmarkedBytes = isPing ? 0 : unmarkedBytes + size;
+                if (isPing) pings.push_back(sentBytes);
+                batch.push_back(std::move(item));
+                queue.pop_front();
+
+                if (unmarkedBytes >= kAckIntervalBytes) {
+                    auto ping = encodePing(itemFormat);
+                    sentBytes += ping->size();
+                    unmarkedBytes = 0;
+                    pings.push_back(sentBytes);
+                    batch.push_back({ std::move(ping), std::string(kPingKey), itemFormat });
+                }
+            }
+
+            if (batch.empty()) {
+                draining = false;
+                return;
+            }
+        }
+
+        {
+            std::lock_guard lock(sendMutex);
+            if (sinkClosed) return;
+            for (const auto& item : batch) sink(*item.message, item.format);
+        }
+        batch.clear();
+    }
+}
+
+void Outbox::close() {
+    {
+        std::lock_guard lock(mutex);
+        closed = true;
+        queue.clear();
+        queued = 0;
+    }
+    std::lock_guard lock(sendMutex);
+    sinkClosed = true;
+}
+
+size_t Outbox::queuedBytes() {
+    std::lock_guard lock(mutex);
+    return queued;
+}
+
+size_t Outbox::inFlightBytes() {
+    std::lock_guard lock(mutex);
+    return sentBytes - confirmedBytes;
+}
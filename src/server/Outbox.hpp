@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace FindTheBug {
+
+    // Mensagem serializada uma vez e compartilhada por todos os destinatarios.
+    using OutboundMessage = std::shared_ptr<const std::string>;
+
+    // Formato negociado por conexao (HELLO): JSON em frames de texto ou MessagePack em frames binarios.
+    enum class WireFormat : uint8_t { Json, MsgPack };
+
+    // Fila de saida de uma conexao. O Crow nao avisa quando um frame foi escrito no socket, entao a entrega e
+    // medida pelo heartbeat: o cliente responde cada PING com um PONG, na ordem, e cada PONG confirma tudo o que
+    // saiu antes do PING correspondente. Bytes entregues ao Crow e ainda nao confirmados sao "em voo"; passando de
+    // kMaxInFlightBytes o resto espera na fila, onde vale o coalescing e o limite que dispara RESYNC_REQUIRED.
+    // Um PONG perdido (frame recusado pelo limite de taxa) so deixa as confirmacoes um PING atrasadas.
+    //
+    // Quem encontra a fila parada vira o drenador e envia o que o limite permite, inclusive o que outras tarefas
+    // enfileirarem enquanto isso; as demais so enfileiram e voltam. acknowledge() retoma uma fila travada.
+    class Outbox {
+    public:
+        // Fila parada acima disso e descartada e troca de lugar com um RESYNC_REQUIRED: o que se perdeu volta
+        // com um snapshot.
+        static constexpr size_t kMaxQueuedBytes = 1 << 20;
+        static constexpr size_t kMaxInFlightBytes = 256 << 10;
+        // Sem PING do heartbeat nesse intervalo, o drenador intercala um proprio para o cliente confirmar.
+        static constexpr size_t kAckIntervalBytes = 32 << 10;
+        // Chave de coalescing dos PING: cada um que sai espera um PONG.
+        static constexpr std::string_view kPingKey = "PING";
+
+        // Entrega um frame ao transporte. Chamado fora do lock da fila, na ordem de envio.
+        using Sink = std::function<void(const std::string& frame, WireFormat format)>;
+
+        explicit Outbox(Sink sink);
+
+        // coalesceKey: substitui uma mensagem ainda na fila com a mesma chave.
+        void enqueue(OutboundMessage message, WireFormat format, std::string_view coalesceKey);
+        // PONG recebido: confirma o PING mais antigo em voo e volta a drenar se a fila esperava por isso.
+        void acknowledge();
+        // Descarta a fila e espera um envio em andamento terminar: depois daqui o sink nao e mais chamado.
+        void close();
+
+        void setFormat(WireFormat format) { format_.store(format, std::memory_order_relaxed); }
+        WireFormat format() const { return format_.load(std::memory_order_relaxed); }
+
+        size_t queuedBytes();
+        size_t inFlightBytes();
+
+    private:
+        struct Item {
+            OutboundMessage message;
+            std::string coalesceKey;
+            WireFormat format{ WireFormat::Json };
+        };
+
+        void drain();
+
+        Sink sink;
+
+        std::mutex mutex;
+        std::deque<Item> queue;
+        size_t queued{ 0 };
+        uint64_t sentBytes{ 0 };       // total entregue ao Crow
+        uint64_t confirmedBytes{ 0 };  // ate onde o cliente confirmou
+        uint64_t unmarkedBytes{ 0 };   // entregues depois do ultimo PING
+        std::deque<uint64_t> pings;    // sentBytes logo depois de cada PING em voo
+        bool draining{ false };
+        bool closed{ false };
+
+        std::mutex sendMutex;  // segura close() enquanto o sink esta em curso
+        bool sinkClosed{ false };
+
+        std::atomic<WireFormat> format_{ WireFormat::Json };
+    };
+}
@@ -0,0 +1,78 @@
+#include "PresenceTracker.hpp"
+
+#include <functional>
+
+using namespace FindTheBug;
+
+PresenceTracker::PresenceTracker(Clock::duration timeout) : timeout_(timeout) {
+}
+
+PresenceTracker::Shard& PresenceTracker::shardFor(const std::string& sessionId) {
+    return shards[std::hash<std::string>{}(sessionId) % kShards];
+}
+
+std::optional<PresenceChange> PresenceTracker::touch(const std::string& sessionId, const std::string& playerName, Clock::time_point now) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    auto& entry = shard.sessions[sessionId][playerName];
+    entry.lastSeen = now;
+    if (entry.online) return std::nullopt;
+    entry.online = true;
+    return PresenceChange{ sessionId, playerName, true, now };
+}
+
+std::optional<PresenceChange> PresenceTracker::disconnect(const std::string& sessionId, const std::string& playerName) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    auto session = shard.sessions.find(sessionId);
+    if (session == shard.sessions.end()) return std::nullopt;
+    auto it = session->second.find(playerName);
+    if (it == session->second.end() || !it->second.online) return std::nullopt;
+    it->second.online = false;
+    return PresenceChange{ sessionId, playerName, false, it->second.lastSeen };
+}
+
+std::vector<PresenceChange> PresenceTracker::sweep(Clock::time_point now) {
+    std::vector<PresenceChange> changes;
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        for (auto session = shard.sessions.begin(); session != shard.sessions.end();) {
+            auto& players = session->second;
+            std::erase_if(players, [&](const auto& item) {
+                return !item.second.online && now - item.second.lastSeen > kForgetAfter;
+            });
+            for (auto& [playerName, entry] : players) {
+                if (!entry.online || now - entry.lastSeen <= timeout_) continue;
+                entry.online = false;
+                changes.push_back({ session->first, playerName, false, entry.lastSeen });
+            }
+            session = players.empty() ? shard.sessions.erase(session) : std::next(session);
+        }
+    }
+    return changes;
+}
+
+bool PresenceTracker::isOnline(const std::string& sessionId, const std::string& playerName, Clock::time_point now) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    auto session = shard.sessions.find(sessionId);
+    if (session == shard.sessions.end()) return false;
+    auto it = session->second.find(playerName);
+    // Sem esperar a varredura: quem passou do limite ja conta como offline aqui.
+    return it != session->second.end() && it->second.online && now - it->second.lastSeen <= timeout_;
+}
+
+std::vector<std::string> PresenceTracker::trackedSessions() {
+    std::vector<std::string> result;
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        for (const auto& entry : shard.sessions) result.push_back(entry.first);
+    }
+    return result;
+}
+
+void PresenceTracker::forgetSession(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    shard.sessions.erase(sessionId);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace FindTheBug {
+
+    // Jogador que mudou de estado: vira um PRESENCE para a sessao.
+    struct PresenceChange {
+        std::string sessionId;
+        std::string playerName;
+        bool online{ false };
+        std::chrono::system_clock::time_point lastSeen;
+    };
+
+    // Ultimo sinal de vida de cada jogador, por sessao. Qualquer frame recebido conta (inclusive o PONG
+    // do heartbeat); sem sinal por mais que timeout o jogador fica offline mesmo com o socket registrado,
+    // que e o caso de uma conexao TCP meio aberta. Os prazos de turno consultam esta tabela.
+    class PresenceTracker {
+    public:
+        using Clock = std::chrono::system_clock;
+
+        // Offline ha mais que isso sai da tabela (lobbies abandonados nao passam por forgetSession).
+        static constexpr std::chrono::minutes kForgetAfter{ 30 };
+
+        explicit PresenceTracker(Clock::duration timeout);
+
+        // Retorna a mudanca se o jogador estava offline (ou nao era conhecido).
+        std::optional<PresenceChange> touch(const std::string& sessionId, const std::string& playerName, Clock::time_point now);
+        // Ultima conexao do jogador fechada.
+        std::optional<PresenceChange> disconnect(const std::string& sessionId, const std::string& playerName);
+        // Jogadores online sem sinal ha mais que timeout passam a offline; chamada a cada heartbeat.
+        std::vector<PresenceChange> sweep(Clock::time_point now);
+
+        bool isOnline(const std::string& sessionId, const std::string& playerName, Clock::time_point now);
+
+        // Destino do PING: todas as sessoes conhecidas, inclusive as que so tem jogadores offline
+        // (um cliente vivo que perdeu o prazo volta ao responder).
+        std::vector<std::string> trackedSessions();
+        void forgetSession(const std::string& sessionId);
+
+        Clock::duration timeout() const { return timeout_; }
+
+    private:
+        struct Entry {
+            Clock::time_point lastSeen;
+            bool online{ false };
+        };
+
+        using Players = std::unordered_map<std::string, Entry>;
+
+        static constexpr size_t kShards = 32;
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, Players> sessions;
+        };
+
+        Shard& shardFor(const std::string& sessionId);
+
+        const Clock::duration timeout_;
+        std::array<Shard, kShards> shards;
+    };
+}
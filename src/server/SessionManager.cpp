@@ -1,116 +1,295 @@
 #include "SessionManager.hpp"
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <vector>
 #include <print>
 
 using namespace FindTheBug;
 
-static std::mutex global_send_mutex;
 static std::mutex global_log_mutex;
 
-void SessionManager::registerConnection(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName) {
+namespace {
+
+    constexpr size_t kOutboxShards = 32;
+
+    struct OutboxShard {
+        std::mutex mutex;
+        std::unordered_map<crow::websocket::connection*, std::shared_ptr<Outbox>> outboxes;
+    };
+
+    std::array<OutboxShard, kOutboxShards> outboxShards;
+
+    OutboxShard& outboxShardFor(crow::websocket::connection* conn) {
+        return outboxShards[(reinterpret_cast<uintptr_t>(conn) >> 4) % kOutboxShards];
+    }
+
+    std::shared_ptr<Outbox> findOutbox(crow::websocket::connection* conn) {
+        auto& shard = outboxShardFor(conn);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.outboxes.find(conn);
+        return it == shard.outboxes.end() ? nullptr : it->second;
+    }
+
+    void sendFrame(crow::websocket::connection* conn, const std::string& frame, WireFormat format) {
+        try {
+            if (format == WireFormat::MsgPack) conn->send_binary(frame);
+            else conn->send_text(frame);
+        }
+        catch (const std::exception& e) {
+            SessionManager::log("[ERRO] Falha no envio: " + std::string(e.what()));
+        }
+        catch (...) {
+            SessionManager::log("[ERRO] Falha desconhecida no envio");
+        }
+    }
+}
+
+void SessionManager::openConnection(crow::websocket::connection* conn) {
     if (!conn) return;
+    auto& shard = outboxShardFor(conn);
+    std::lock_guard lock(shard.mutex);
+    shard.outboxes.insert_or_assign(conn, std::make_shared<Outbox>([conn](const std::string& frame, WireFormat format) {
+        sendFrame(conn, frame, format);
+    }));
+}
 
-    std::lock_guard<std::mutex> lock(mutex_);
+std::vector<crow::websocket::connection*> SessionManager::openConnections() {
+    std::vector<crow::websocket::connection*> conns;
+    for (auto& shard : outboxShards) {
+        std::lock_guard lock(shard.mutex);
+        for (const auto& entry : shard.outboxes) conns.push_back(entry.first);
+    }
+    return conns;
+}
 
-    sessionConnections_[sessionId].insert(conn);
-    connectionToSession_[conn] = sessionId;
-    connectionToPlayer_[conn] = playerName;
+void SessionManager::closeConnection(crow::websocket::connection* conn) {
+    std::shared_ptr<Outbox> outbox;
+    {
+        auto& shard = outboxShardFor(conn);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.outboxes.find(conn);
+        if (it == shard.outboxes.end()) return;
+        outbox = std::move(it->second);
+        shard.outboxes.erase(it);
+    }
 
-    log("[SessionManager] Conexao registrada na sessao: " + sessionId);
+    // Espera um envio em andamento terminar: depois daqui a conexao pode ser destruida.
+    outbox->close();
 }
 
-void SessionManager::unregisterConnection(crow::websocket::connection* conn) {
-    std::lock_guard<std::mutex> lock(mutex_);
+SessionManager::SessionShard& SessionManager::shardFor(const std::string& sessionId) {
+    return sessionShards_[std::hash<std::string>{}(sessionId) % kShards];
+}
 
-    if (connectionToSession_.contains(conn)) {
-        std::string sessionId = connectionToSession_[conn];
+SessionManager::ConnectionShard& SessionManager::shardFor(crow::websocket::connection* conn) {
+    return connectionShards_[(reinterpret_cast<uintptr_t>(conn) >> 4) % kShards];
+}
 
-        sessionConnections_[sessionId].erase(conn);
+std::shared_ptr<SessionManager::Session> SessionManager::findSession(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.sessions.find(sessionId);
+    return it == shard.sessions.end() ? nullptr : it->second;
+}
 
-        if (sessionConnections_[sessionId].empty()) {
-            sessionConnections_.erase(sessionId);
-        }
+std::shared_ptr<const SessionManager::Roster> SessionManager::rosterOf(const std::string& sessionId) {
+    auto session = findSession(sessionId);
+    return session ? session->roster.load(std::memory_order_acquire) : nullptr;
+}
 
-        connectionToSession_.erase(conn);
-        connectionToPlayer_.erase(conn);
+void SessionManager::registerConnection(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName) {
+    join(sessionId, conn, playerName, false);
+}
 
-        log("[SessionManager] Conexao removida da sessao: " + sessionId);
-    }
+bool SessionManager::registerSpectator(const std::string& sessionId, crow::websocket::connection* conn) {
+    return join(sessionId, conn, "", true);
 }
 
-bool SessionManager::isPlayerOnline(const std::string& sessionId, const std::string& playerName) {
-    std::lock_guard<std::mutex> lock(mutex_);
+bool SessionManager::join(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName, bool keepPlayers) {
+    if (!conn) return false;
+
+    // Uma conexao pertence a uma sessao so; trocar de sessao sai da anterior.
+    std::string previous;
+    {
+        auto& shard = shardFor(conn);
+        std::lock_guard lock(shard.mutex);
+        auto [it, inserted] = shard.memberships.try_emplace(conn, Membership{ sessionId, playerName });
+        if (!inserted) {
+            if (keepPlayers && !it->second.playerName.empty() && it->second.sessionId != sessionId) return false;
+            if (it->second.sessionId != sessionId) previous = std::move(it->second.sessionId);
+            it->second = Membership{ sessionId, playerName };
+        }
+    }
+    if (!previous.empty()) removeMember(previous, conn);
+
+    auto& shard = shardFor(sessionId);
+    while (true) {
+        std::shared_ptr<Session> session = findSession(sessionId);
+        if (!session) {
+            std::unique_lock lock(shard.mutex);
+            auto& slot = shard.sessions[sessionId];
+            if (!slot) slot = std::make_shared<Session>();
+            session = slot;
+        }
 
-    if (!sessionConnections_.contains(sessionId)) return false;
+        std::lock_guard lock(session->writeMutex);
+        // Esvaziada e removida entre a busca e o lock: a proxima volta cria outra.
+        if (session->closed) continue;
 
-    for (auto* conn : sessionConnections_[sessionId]) {
-        if (connectionToPlayer_.contains(conn) && connectionToPlayer_[conn] == playerName) {
-            return true;
+        auto current = session->roster.load(std::memory_order_acquire);
+        auto next = std::make_shared<Roster>(*current);
+        auto member = std::ranges::find(next->members, conn, &Roster::Member::conn);
+        if (member == next->members.end()) {
+            next->members.push_back({ conn, playerName });
+        }
+        else {
+            // Registro repetido da mesma conexao (reentrada): so o nome pode mudar.
+            if (!member->playerName.empty()) {
+                auto it = next->online.find(member->playerName);
+                if (it != next->online.end() && --it->second == 0) next->online.erase(it);
+            }
+            member->playerName = playerName;
         }
+        if (!playerName.empty()) ++next->online[playerName];
+        session->roster.store(std::move(next), std::memory_order_release);
+        break;
     }
 
-    return false;
+    log("[SessionManager] Conexao registrada na sessao: " + sessionId);
+    return true;
 }
 
-void FindTheBug::SessionManager::closeSession(const std::string& sessionId)
-{
-    std::vector<crow::websocket::connection*> targets;
+void SessionManager::removeMember(const std::string& sessionId, crow::websocket::connection* conn) {
+    auto session = findSession(sessionId);
+    if (!session) return;
 
+    bool emptied = false;
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (sessionConnections_.contains(sessionId)) {
-            for (auto* conn : sessionConnections_[sessionId]) {
-                targets.push_back(conn);
+        std::lock_guard lock(session->writeMutex);
+        if (session->closed) return;
+
+        auto current = session->roster.load(std::memory_order_acquire);
+        auto next = std::make_shared<Roster>();
+        next->members.reserve(current->members.size());
+        next->online = current->online;
+        for (const auto& member : current->members) {
+            if (member.conn != conn) {
+                next->members.push_back(member);
+                continue;
             }
-            sessionConnections_.erase(sessionId);
+            if (member.playerName.empty()) continue;
+            auto it = next->online.find(member.playerName);
+            if (it != next->online.end() && --it->second == 0) next->online.erase(it);
         }
+        emptied = next->members.empty();
+        session->closed = emptied;
+        session->roster.store(std::move(next), std::memory_order_release);
     }
 
-    for (auto* conn : targets) {
-        if (conn) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            connectionToSession_.erase(conn);
-        }
-        try { conn->close("Partida Encerrada"); } catch(...){}
+    if (emptied) {
+        auto& shard = shardFor(sessionId);
+        std::unique_lock lock(shard.mutex);
+        auto it = shard.sessions.find(sessionId);
+        if (it != shard.sessions.end() && it->second == session) shard.sessions.erase(it);
     }
-    log("[SessionManager] Sessao " + sessionId + " encerrada e limpa da RAM.");
 }
 
-void SessionManager::broadcastToSession(const std::string& sessionId, const std::string& message) {
-    
-    std::vector<crow::websocket::connection*> targets;
+Membership SessionManager::unregisterConnection(crow::websocket::connection* conn) {
+    Membership membership;
+    {
+        auto& shard = shardFor(conn);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.memberships.find(conn);
+        if (it == shard.memberships.end()) return {};
+        membership = std::move(it->second);
+        shard.memberships.erase(it);
+    }
+
+    removeMember(membership.sessionId, conn);
+    log("[SessionManager] Conexao removida da sessao: " + membership.sessionId);
+    return membership;
+}
+
+Membership SessionManager::memberOf(crow::websocket::connection* conn) {
+    auto& shard = shardFor(conn);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.memberships.find(conn);
+    return it == shard.memberships.end() ? Membership{} : it->second;
+}
+
+bool SessionManager::isPlayerOnline(const std::string& sessionId, const std::string& playerName) {
+    auto roster = rosterOf(sessionId);
+    return roster && roster->online.contains(playerName);
+}
 
+void FindTheBug::SessionManager::closeSession(const std::string& sessionId)
+{
+    std::shared_ptr<Session> session;
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (sessionConnections_.contains(sessionId)) {
-            for (auto* conn : sessionConnections_[sessionId]) {
-                targets.push_back(conn);
+        auto& shard = shardFor(sessionId);
+        std::unique_lock lock(shard.mutex);
+        auto it = shard.sessions.find(sessionId);
+        if (it != shard.sessions.end()) {
+            session = std::move(it->second);
+            shard.sessions.erase(it);
+        }
+    }
+
+    std::shared_ptr<const Roster> roster;
+    if (session) {
+        std::lock_guard lock(session->writeMutex);
+        session->closed = true;
+        roster = session->roster.exchange(std::make_shared<const Roster>(), std::memory_order_acq_rel);
+    }
+
+    if (roster) {
+        for (const auto& member : roster->members) {
+            {
+                auto& shard = shardFor(member.conn);
+                std::lock_guard lock(shard.mutex);
+                auto it = shard.memberships.find(member.conn);
+                if (it != shard.memberships.end() && it->second.sessionId == sessionId) shard.memberships.erase(it);
             }
+            try { member.conn->close("Partida Encerrada"); } catch(...){}
         }
     }
+    log("[SessionManager] Sessao " + sessionId + " encerrada e limpa da RAM.");
+}
 
-    if (!targets.empty()) {
-        log("[SessionManager] Broadcast para " + sessionId + " (" + std::to_string(targets.size()) + " alvos)");
-        for (auto* conn : targets) {
-            sendTo(conn, message);
+void SessionManager::broadcastToSession(const std::string& sessionId, const MessageEncoder& encode, std::string_view coalesceKey) {
+    // Snapshot: registros e remocoes concorrentes publicam outro roster e nao esperam este envio.
+    auto roster = rosterOf(sessionId);
+
+    if (roster && !roster->members.empty()) {
+        log("[SessionManager] Broadcast para " + sessionId + " (" + std::to_string(roster->members.size()) + " alvos)");
+        // Cada formato e serializado so se algum destinatario o usa, e uma vez so.
+        std::array<OutboundMessage, 2> encoded;
+        for (const auto& member : roster->members) {
+            auto outbox = findOutbox(member.conn);
+            if (!outbox) continue;
+            WireFormat format = outbox->format();
+            auto& message = encoded[static_cast<size_t>(format)];
+            if (!message) message = encode(format);
+            outbox->enqueue(message, format, coalesceKey);
         }
     }
 }
 
-void SessionManager::sendTo(crow::websocket::connection* conn, const std::string& msg) {
+void SessionManager::sendTo(crow::websocket::connection* conn, const MessageEncoder& encode) {
     if (!conn) return;
+    auto outbox = findOutbox(conn);
+    if (!outbox) return;
+    WireFormat format = outbox->format();
+    outbox->enqueue(encode(format), format, {});
+}
 
-    try {
-        std::lock_guard<std::mutex> lock(global_send_mutex);
-        conn->send_text(msg);
-    }
-    catch (const std::exception& e) {
-        log("[ERRO] Falha no envio: " + std::string(e.what()));
-    }
-    catch (...) {
-        log("[ERRO] Falha desconhecida no envio");
-    }
+void SessionManager::acknowledge(crow::websocket::connection* conn) {
+    if (auto outbox = findOutbox(conn)) outbox->acknowledge();
+}
+
+void SessionManager::setWireFormat(crow::websocket::connection* conn, WireFormat format) {
+    if (auto outbox = findOutbox(conn)) outbox->setFormat(format);
 }
 
 void SessionManager::log(const std::string& msg) {
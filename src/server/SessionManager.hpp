@@ -2,35 +2,107 @@
 
 #include "crow.h"
 #include "../shared/DTOs.hpp"
+#include "Outbox.hpp"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 
 namespace FindTheBug {
 
+    // Serializa a mensagem no formato pedido. Num broadcast e chamado no maximo uma vez por formato
+    // presente entre os destinatarios.
+    using MessageEncoder = std::function<OutboundMessage(WireFormat)>;
+
+    // Sessao e jogador de uma conexao registrada (playerName vazio para espectadores).
+    struct Membership {
+        std::string sessionId;
+        std::string playerName;
+    };
+
     class SessionManager {
     public:
         explicit SessionManager() = default;
         ~SessionManager() = default;
 
+		// Uma conexao fica em uma sessao so: registrar em outra a remove da anterior.
 		void registerConnection(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName);
-		void unregisterConnection(crow::websocket::connection* conn);
+		// Registro sem nome (canal de torneio). false, sem mudar nada, se a conexao e de um jogador em outra
+		// sessao: trocar o tiraria do roster dela e do GAME_STATE_UPDATE.
+		bool registerSpectator(const std::string& sessionId, crow::websocket::connection* conn);
+		// Retorna de onde a conexao foi removida (sessionId vazio se nao estava registrada).
+		Membership unregisterConnection(crow::websocket::connection* conn);
+		// Onde a conexao esta registrada (sessionId vazio se nenhuma).
+		Membership memberOf(crow::websocket::connection* conn);
 		void closeSession(const std::string& sessionId);
 
-		void broadcastToSession(const std::string& sessionId, const std::string& message);
+		// coalesceKey: mensagem que substitui, na fila de cada conexao, uma anterior ainda nao enviada com a mesma chave.
+		void broadcastToSession(const std::string& sessionId, const MessageEncoder& encode, std::string_view coalesceKey = {});
 
+		// O(1): indice de presenca do snapshot, sem varrer as conexoes.
 		bool isPlayerOnline(const std::string& sessionId, const std::string& playerName);
-		static void sendTo(crow::websocket::connection* conn, const std::string& message);
+		static void sendTo(crow::websocket::connection* conn, const MessageEncoder& encode);
+
+		// PONG da conexao: libera o envio do que esperava confirmacao de entrega (ver Outbox).
+		static void acknowledge(crow::websocket::connection* conn);
+
+		// Vale para as mensagens enfileiradas a partir daqui; as ja na fila saem no formato em que foram montadas.
+		static void setWireFormat(crow::websocket::connection* conn, WireFormat format);
+
+		// Fila de saida da conexao: criada na abertura, fechada no fechamento (envios posteriores sao ignorados).
+		static void openConnection(crow::websocket::connection* conn);
+		static void closeConnection(crow::websocket::connection* conn);
+		// Conexoes abertas agora (drain: cada uma recebe o proprio RECONNECT).
+		static std::vector<crow::websocket::connection*> openConnections();
 		static void log(const std::string& message);
 
 	private:
-		std::mutex mutex_;
+		// Conexoes de uma sessao. Imutavel depois de publicado: broadcasts e consultas de presenca leem
+		// o snapshot atual sem lock; registrar ou remover copia, altera e publica um novo.
+		struct Roster {
+			struct Member {
+				crow::websocket::connection* conn;
+				std::string playerName;
+			};
+			std::vector<Member> members;
+			// Jogador -> conexoes abertas dele na sessao (espectadores, sem nome, ficam de fora).
+			std::unordered_map<std::string, uint32_t> online;
+		};
+
+		struct Session {
+			std::mutex writeMutex;  // serializa so as escritas; leitores usam o snapshot
+			bool closed{ false };   // removida do shard: quem a encontrou antes procura de novo
+			std::atomic<std::shared_ptr<const Roster>> roster{ std::make_shared<const Roster>() };
+		};
+
+		static constexpr size_t kShards = 32;
+
+		// O mapa so muda quando uma sessao aparece ou some; o lock compartilhado cobre so a busca.
+		struct SessionShard {
+			std::shared_mutex mutex;
+			std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+		};
+
+		struct ConnectionShard {
+			std::mutex mutex;
+			std::unordered_map<crow::websocket::connection*, Membership> memberships;
+		};
 
-		std::unordered_map<std::string, std::unordered_set<crow::websocket::connection*>> sessionConnections_;
-		std::unordered_map<crow::websocket::connection*, std::string> connectionToSession_;
+		SessionShard& shardFor(const std::string& sessionId);
+		ConnectionShard& shardFor(crow::websocket::connection* conn);
+		std::shared_ptr<Session> findSession(const std::string& sessionId);
+		std::shared_ptr<const Roster> rosterOf(const std::string& sessionId);
+		void removeMember(const std::string& sessionId, crow::websocket::connection* conn);
+		bool join(const std::string& sessionId, crow::websocket::connection* conn, const std::string& playerName, bool keepPlayers);
 
-		std::unordered_map<crow::websocket::connection*, std::string> connectionToPlayer_;
+		std::array<SessionShard, kShards> sessionShards_;
+		std::array<ConnectionShard, kShards> connectionShards_;
     };
 
 }
\ No newline at end of file
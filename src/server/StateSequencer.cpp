@@ -0,0 +1,54 @@
+#include "StateSequencer.hpp"
+
+using namespace FindTheBug;
+
+StateSummary StateSummary::of(const GameState& state) {
+    return {
+        .revision = state.revision,
+        .currentDay = state.currentDay,
+        .remainingPoints = state.remainingPoints,
+        .currentTurnIndex = state.currentTurnIndex,
+        .isSuddenDeath = state.isSuddenDeath,
+        .isCompleted = state.isCompleted,
+        .clueCount = state.discoveredClues.size(),
+        .turnOrder = state.turnOrder
+    };
+}
+
+std::shared_ptr<StateSequencer::Stream> StateSequencer::streamFor(const std::string& sessionId) {
+    auto& shard = shards[std::hash<std::string>{}(sessionId) % kShards];
+    std::lock_guard lock(shard.mutex);
+    auto& stream = shard.streams[sessionId];
+    if (!stream) stream = std::make_shared<Stream>();
+    return stream;
+}
+
+bool StateSequencer::publishState(const GameState& state, const StateEmitter& emit) {
+    auto stream = streamFor(state.sessionId);
+    std::lock_guard lock(stream->mutex);
+
+    if (stream->published && state.revision <= stream->last.revision) return false;
+
+    emit(++stream->seq, stream->published ? &stream->last : nullptr);
+    stream->last = StateSummary::of(state);
+    stream->published = true;
+    return true;
+}
+
+void StateSequencer::publishEvent(const std::string& sessionId, const EventEmitter& emit) {
+    auto stream = streamFor(sessionId);
+    std::lock_guard lock(stream->mutex);
+    emit(++stream->seq);
+}
+
+void StateSequencer::withCurrentSeq(const std::string& sessionId, const EventEmitter& emit) {
+    auto stream = streamFor(sessionId);
+    std::lock_guard lock(stream->mutex);
+    emit(stream->seq);
+}
+
+void StateSequencer::forget(const std::string& sessionId) {
+    auto& shard = shards[std::hash<std::string>{}(sessionId) % kShards];
+    std::lock_guard lock(shard.mutex);
+    shard.streams.erase(sessionId);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../shared/DTOs.hpp"
+
+namespace FindTheBug {
+
+    // O que os clientes da sessao ja receberam do estado: base para o proximo patch.
+    struct StateSummary {
+        int64_t revision{ 0 };
+        int currentDay{ 0 };
+        int remainingPoints{ 0 };
+        int currentTurnIndex{ 0 };
+        bool isSuddenDeath{ false };
+        bool isCompleted{ false };
+        size_t clueCount{ 0 };
+        std::vector<std::string> turnOrder;
+
+        static StateSummary of(const GameState& state);
+    };
+
+    // Numera os eventos de estado de cada sessao (seq contiguo, por no) e serializa o envio: o callback roda
+    // com o lock da sessao, entao as mensagens saem na ordem do seq. Pos-imagens com revision ja superada
+    // sao descartadas; o patch mais novo ja contem o que elas trariam.
+    class StateSequencer {
+    public:
+        // previous e nullptr quando o no ainda nao enviou estado desta sessao (inicio ou reinicio do servidor).
+        using StateEmitter = std::function<void(uint64_t seq, const StateSummary* previous)>;
+        using EventEmitter = std::function<void(uint64_t seq)>;
+
+        // false se a pos-imagem e mais antiga que a ultima publicada.
+        bool publishState(const GameState& state, const StateEmitter& emit);
+
+        // Eventos que nao trazem pos-imagem (notas): so consomem um seq.
+        void publishEvent(const std::string& sessionId, const EventEmitter& emit);
+
+        // Snapshot para uma conexao: recebe o seq atual sem avancar; patches seguintes tem seq maior.
+        void withCurrentSeq(const std::string& sessionId, const EventEmitter& emit);
+
+        void forget(const std::string& sessionId);
+
+    private:
+        static constexpr size_t kShards = 32;
+
+        struct Stream {
+            std::mutex mutex;
+            uint64_t seq{ 0 };
+            bool published{ false };
+            StateSummary last;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::shared_ptr<Stream>> streams;
+        };
+
+        std::shared_ptr<Stream> streamFor(const std::string& sessionId);
+
+        std::array<Shard, kShards> shards;
+    };
+}
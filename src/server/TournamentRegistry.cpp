@@ -0,0 +1,168 @@
+#include "TournamentRegistry.hpp"
+
+#include <utility>
+
+using namespace FindTheBug;
+
+TournamentInfo TournamentRegistry::create(const std::string& tournamentId, const std::string& name, std::shared_ptr<const CompiledCase> compiledCase) {
+    auto t = std::make_shared<Tournament>();
+    t->info = { tournamentId, name, compiledCase->data.id };
+    t->compiledCase = std::move(compiledCase);
+    t->idleSince = std::chrono::steady_clock::now();
+
+    std::unique_lock lock(mutex);
+    tournaments.insert_or_assign(tournamentId, t);
+    return t->info;
+}
+
+std::shared_ptr<TournamentRegistry::Tournament> TournamentRegistry::find(const std::string& tournamentId) const {
+    std::shared_lock lock(mutex);
+    auto it = tournaments.find(tournamentId);
+    return it == tournaments.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const CompiledCase> TournamentRegistry::caseFor(const std::string& tournamentId) const {
+    auto t = find(tournamentId);
+    return t ? t->compiledCase : nullptr;
+}
+
+StandingChange TournamentRegistry::record(Tournament& t, const std::string& sessionId, int score) {
+    int previousRank = t.board.rankOf(sessionId);
+    t.board.update(sessionId, score);
+
+    return {
+        .tournamentId = t.info.id,
+        .version = ++t.version,
+        .sessionId = sessionId,
+        .teamName = t.teamNames[sessionId],
+        .score = t.board.scoreOf(sessionId),
+        .rank = t.board.rankOf(sessionId),
+        .previousRank = previousRank
+    };
+}
+
+std::optional<StandingChange> TournamentRegistry::enroll(const std::string& tournamentId, const std::string& sessionId, const std::string& teamName) {
+    auto t = find(tournamentId);
+    if (!t) return std::nullopt;
+
+    std::shared_ptr<Tournament> previous;
+    {
+        std::unique_lock lock(mutex);
+        auto [it, inserted] = bySession.try_emplace(sessionId, t);
+        if (!inserted && it->second != t) previous = std::exchange(it->second, t);
+    }
+    if (previous) {
+        std::lock_guard lock(previous->mutex);
+        previous->revisions.erase(sessionId);
+        if (previous->revisions.empty()) previous->idleSince = std::chrono::steady_clock::now();
+    }
+
+    // Partida nova: dia 1, nenhuma pista.
+    std::lock_guard lock(t->mutex);
+    t->teamNames[sessionId] = teamName;
+    t->revisions.try_emplace(sessionId, int64_t{ 0 });
+    return record(*t, sessionId, Leaderboard::scoreFor(GameState{}, GameResult::Running));
+}
+
+std::optional<StandingChange> TournamentRegistry::report(const GameState& state, GameResult outcome) {
+    std::shared_ptr<Tournament> t;
+    {
+        std::shared_lock lock(mutex);
+        auto it = bySession.find(state.sessionId);
+        if (it == bySession.end()) return std::nullopt;
+        t = it->second;
+    }
+
+    int score = Leaderboard::scoreFor(state, outcome);
+
+    std::lock_guard lock(t->mutex);
+    auto applied = t->revisions.find(state.sessionId);
+    if (applied == t->revisions.end() || state.revision < applied->second) return std::nullopt;
+    applied->second = state.revision;
+
+    if (t->board.contains(state.sessionId) && t->board.scoreOf(state.sessionId) == score) return std::nullopt;
+    return record(*t, state.sessionId, score);
+}
+
+void TournamentRegistry::forgetSession(const std::string& sessionId) {
+    std::shared_ptr<Tournament> t;
+    {
+        std::unique_lock lock(mutex);
+        auto it = bySession.find(sessionId);
+        if (it == bySession.end()) return;
+        t = std::move(it->second);
+        bySession.erase(it);
+    }
+
+    std::lock_guard lock(t->mutex);
+    t->revisions.erase(sessionId);
+    if (t->revisions.empty()) t->idleSince = std::chrono::steady_clock::now();
+}
+
+std::vector<std::string> TournamentRegistry::evictIdle(std::chrono::steady_clock::duration maxIdle) {
+    auto cutoff = std::chrono::steady_clock::now() - maxIdle;
+    std::vector<std::string> evicted;
+
+    std::unique_lock lock(mutex);
+    std::erase_if(tournaments, [&](const auto& entry) {
+        std::lock_guard tournamentLock(entry.second->mutex);
+        if (!entry.second->revisions.empty() || entry.second->idleSince >= cutoff) return false;
+        evicted.push_back(entry.first);
+        return true;
+    });
+    return evicted;
+}
+
+std::vector<TournamentState> TournamentRegistry::snapshot() const {
+    std::vector<std::shared_ptr<Tournament>> all;
+    {
+        std::shared_lock lock(mutex);
+        all.reserve(tournaments.size());
+        for (const auto& [id, t] : tournaments) all.push_back(t);
+    }
+
+    std::vector<TournamentState> out;
+    out.reserve(all.size());
+    for (const auto& t : all) {
+        std::lock_guard lock(t->mutex);
+        auto& state = out.emplace_back(TournamentState{ .info = t->info, .version = t->version });
+        state.teams.reserve(t->teamNames.size());
+        for (const auto& [sessionId, teamName] : t->teamNames) {
+            auto& team = state.teams.emplace_back(TournamentTeam{ .sessionId = sessionId, .teamName = teamName, .score = t->board.scoreOf(sessionId) });
+            if (auto it = t->revisions.find(sessionId); it != t->revisions.end()) team.revision = it->second;
+        }
+    }
+    return out;
+}
+
+bool TournamentRegistry::adopt(TournamentState state, std::shared_ptr<const CompiledCase> compiledCase) {
+    auto t = std::make_shared<Tournament>();
+    t->info = std::move(state.info);
+    t->compiledCase = std::move(compiledCase);
+    t->version = state.version;
+    t->idleSince = std::chrono::steady_clock::now();
+    for (auto& team : state.teams) {
+        t->board.update(team.sessionId, team.score);
+        if (team.revision) t->revisions[team.sessionId] = *team.revision;
+        t->teamNames[team.sessionId] = std::move(team.teamName);
+    }
+
+    std::unique_lock lock(mutex);
+    if (!tournaments.try_emplace(t->info.id, t).second) return false;
+    for (const auto& [sessionId, revision] : t->revisions) bySession.try_emplace(sessionId, t);
+    return true;
+}
+
+std::optional<LeaderboardView> TournamentRegistry::view(const std::string& tournamentId, size_t limit) const {
+    auto t = find(tournamentId);
+    if (!t) return std::nullopt;
+
+    std::lock_guard lock(t->mutex);
+    LeaderboardView out{ .info = t->info, .version = t->version, .teams = t->board.size(), .top = t->board.top(limit) };
+    out.teamNames.reserve(out.top.size());
+    for (const auto& s : out.top) {
+        auto it = t->teamNames.find(s.sessionId);
+        out.teamNames.push_back(it == t->teamNames.end() ? std::string() : it->second);
+    }
+    return out;
+}
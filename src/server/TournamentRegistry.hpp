@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../shared/DTOs.hpp"
+#include "../engine/Leaderboard.hpp"
+#include "../engine/Types.hpp"
+
+namespace FindTheBug {
+
+    struct TournamentInfo {
+        std::string id;
+        std::string name;
+        std::string caseId;
+    };
+
+    // Mudanca de posicao de um time. version cresce por torneio: o espectador descarta, por time,
+    // deltas mais antigos que o ultimo aplicado (as mensagens podem chegar fora de ordem).
+    struct StandingChange {
+        std::string tournamentId;
+        uint64_t version{ 0 };
+        std::string sessionId;
+        std::string teamName;
+        int score{ 0 };
+        int rank{ 0 };
+        int previousRank{ 0 };  // 0: time acabou de entrar
+    };
+
+    struct LeaderboardView {
+        TournamentInfo info;
+        uint64_t version{ 0 };
+        size_t teams{ 0 };
+        std::vector<Standing> top;
+        std::vector<std::string> teamNames;  // indexado como top
+    };
+
+    // Torneio no snapshot de handoff. O caso compilado nao vai junto: o processo novo recompila pelo caseId.
+    struct TournamentTeam {
+        std::string sessionId;
+        std::string teamName;
+        int score{ 0 };
+        std::optional<int64_t> revision;  // ultima revisao aplicada; ausente se a sessao ja foi encerrada
+    };
+
+    struct TournamentState {
+        TournamentInfo info;
+        uint64_t version{ 0 };
+        std::vector<TournamentTeam> teams;
+    };
+
+    // Torneios deste no: varias sessoes jogando o mesmo caso, compilado uma vez e fixado enquanto o torneio existir.
+    // O ranking e mantido em memoria e atualizado pelo pos-estado de cada acao e finalizacao, sem varrer sessions.
+    class TournamentRegistry {
+    public:
+        static constexpr size_t kSnapshotSize = 50;
+
+        static std::string channelFor(const std::string& tournamentId) { return "tournament:" + tournamentId; }
+
+        TournamentInfo create(const std::string& tournamentId, const std::string& name, std::shared_ptr<const CompiledCase> compiledCase);
+
+        // nullptr se o torneio nao existe.
+        std::shared_ptr<const CompiledCase> caseFor(const std::string& tournamentId) const;
+
+        std::optional<StandingChange> enroll(const std::string& tournamentId, const std::string& sessionId, const std::string& teamName);
+
+        // Recalcula o score do time; nullopt se a sessao nao participa de torneio, se o estado e mais antigo que o
+        // ultimo aplicado (pos-imagens de tarefas concorrentes chegam fora de ordem) ou se a posicao nao mudou.
+        std::optional<StandingChange> report(const GameState& state, GameResult outcome);
+
+        // Sessao encerrada: para de receber reports. O time continua no ranking com o ultimo score.
+        void forgetSession(const std::string& sessionId);
+        // Remove torneios sem sessao em andamento ha mais que maxIdle e retorna os ids removidos.
+        std::vector<std::string> evictIdle(std::chrono::steady_clock::duration maxIdle);
+
+        std::optional<LeaderboardView> view(const std::string& tournamentId, size_t limit = kSnapshotSize) const;
+
+        // Handoff entre processos, como em LobbyRegistry. adopt nao substitui torneios ja existentes.
+        std::vector<TournamentState> snapshot() const;
+        bool adopt(TournamentState state, std::shared_ptr<const CompiledCase> compiledCase);
+
+    private:
+        struct Tournament {
+            TournamentInfo info;
+            std::shared_ptr<const CompiledCase> compiledCase;
+
+            mutable std::mutex mutex;
+            Leaderboard board;
+            std::unordered_map<std::string, std::string> teamNames;  // sessionId -> nome do time
+            std::unordered_map<std::string, int64_t> revisions;      // sessao em andamento -> ultima revisao aplicada
+            std::chrono::steady_clock::time_point idleSince;         // quando revisions ficou vazio
+            uint64_t version{ 0 };
+        };
+
+        std::shared_ptr<Tournament> find(const std::string& tournamentId) const;
+        static StandingChange record(Tournament& t, const std::string& sessionId, int score);
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Tournament>> tournaments;
+        std::unordered_map<std::string, std::shared_ptr<Tournament>> bySession;
+    };
+}
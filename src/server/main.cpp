@@ -2,6 +2,7 @@
 #define NOMINMAX 
 
 #include "crow.h"
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <cstdlib>
@@ -35,7 +36,9 @@ int main()
             return -1;
         }
 
-        auto taskQueue = std::make_shared<TaskQueue>(4);
+        // Acima disso comandos de clientes recebem OVERLOADED em vez de crescer a fila.
+        size_t queueCapacity = std::stoul(getEnvVar("TASK_QUEUE_CAPACITY", "2048"));
+        auto taskQueue = std::make_shared<TaskQueue>(4, queueCapacity);
 
         auto storage = std::make_shared<MongoStore>(mongoUri, dbName);
 
@@ -43,10 +46,21 @@ int main()
 
         auto engine = std::make_shared<GameEngine>(storage);
 
-        HttpServer server(engine, storage, sessionManager, taskQueue);
+        HeartbeatSettings heartbeat;
+        heartbeat.interval = std::chrono::milliseconds(std::stoll(getEnvVar("HEARTBEAT_INTERVAL_MS", "5000")));
+        heartbeat.timeout = std::chrono::milliseconds(std::stoll(getEnvVar("PRESENCE_TIMEOUT_MS", "15000")));
 
-        server.run(static_cast<uint16_t>(port));
+        HttpServer server(engine, storage, sessionManager, taskQueue, heartbeat);
+
+        // Deploy: SIGTERM faz o drain; com SNAPSHOT_PATH o proximo processo herda lobbies e casos das sessoes.
+        std::signal(SIGTERM, [](int) { HttpServer::requestShutdown(); });
+        std::signal(SIGINT, [](int) { HttpServer::requestShutdown(); });
+        std::string snapshotPath = getEnvVar("SNAPSHOT_PATH");
+        if (!snapshotPath.empty()) server.enableHandoff(snapshotPath);
 
+        server.run(static_cast<uint16_t>(port));
+        // Antes do destrutor: fila, timers e threads de fundo ainda usam o servidor.
+        server.shutdown();
     }
     catch (const std::exception& e) {
         std::cerr << "[CRASH] Main: " << e.what() << "\n";
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "DTOs.hpp"
+#include "Reflect.hpp"
+
+// Campos serializados de cada DTO. Os nomes sao os mesmos usados no Mongo e no protocolo;
+// alterar um nome aqui altera os dois.
+namespace FindTheBug::Reflect {
+
+	template <> struct EnumNames<CostDiscount> {
+		static constexpr std::array<std::pair<std::string_view, CostDiscount>, 3> values{ {
+			{ "none", CostDiscount::None },
+			{ "investigated", CostDiscount::WhenInvestigated },
+			{ "breakpointed", CostDiscount::WhenBreakpointed },
+		} };
+	};
+
+	template <> struct Descriptor<NoteOp> {
+		static constexpr auto fields = std::make_tuple(
+			field("replica", &NoteOp::replica),
+			field("counter", &NoteOp::counter),
+			field("text", &NoteOp::text),
+			field("refCounter", &NoteOp::refCounter),
+			field("refReplica", &NoteOp::refReplica),
+			field("removeCount", &NoteOp::removeCount));
+	};
+
+	template <> struct Descriptor<DiscoveredClue> {
+		static constexpr auto fields = std::make_tuple(
+			field("id", &DiscoveredClue::id),
+			field("targetId", &DiscoveredClue::targetId),
+			field("targetType", &DiscoveredClue::targetType),
+			field("type", &DiscoveredClue::type),
+			field("content", &DiscoveredClue::content),
+			field("discoveredBy", &DiscoveredClue::discoveredBy),
+			field("playerNotes", &DiscoveredClue::playerNotes),
+			field("sharedNoteOps", &DiscoveredClue::sharedNoteOps));
+	};
+
+	template <> struct Descriptor<PlayerAction> {
+		static constexpr auto fields = std::make_tuple(
+			field("playerId", &PlayerAction::playerId),
+			field("actionType", &PlayerAction::actionType),
+			field("targetId", &PlayerAction::targetId),
+			field("timestamp", &PlayerAction::timestamp));
+	};
+
+	template <> struct Descriptor<Clue> {
+		static constexpr auto fields = std::make_tuple(
+			field("id", &Clue::id),
+			field("targetId", &Clue::targetId),
+			field("targetType", &Clue::targetType),
+			field("type", &Clue::type),
+			field("content", &Clue::content),
+			field("cost", &Clue::cost));
+	};
+
+	template <> struct Descriptor<ModuleNode> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &ModuleNode::name));
+	};
+
+	template <> struct Descriptor<FunctionNode> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &FunctionNode::name),
+			field("parentId", &FunctionNode::parentId));
+	};
+
+	template <> struct Descriptor<ConnectionNode> {
+		static constexpr auto fields = std::make_tuple(
+			field("id", &ConnectionNode::id),
+			field("from", &ConnectionNode::from),
+			field("to", &ConnectionNode::to));
+	};
+
+	template <> struct Descriptor<SystemTopology> {
+		static constexpr auto fields = std::make_tuple(
+			field("modules", &SystemTopology::modules),
+			field("functions", &SystemTopology::functions),
+			field("connections", &SystemTopology::connections));
+	};
+
+	template <> struct Descriptor<ActionCostRule> {
+		static constexpr auto fields = std::make_tuple(
+			field("action", &ActionCostRule::action),
+			field("cost", &ActionCostRule::cost),
+			field("discountedCost", &ActionCostRule::discountedCost),
+			field("discountWhen", &ActionCostRule::discountWhen));
+	};
+
+	template <> struct Descriptor<CaseRules> {
+		static constexpr auto fields = std::make_tuple(
+			field("actionCosts", &CaseRules::actionCosts),
+			field("pointsPerDay", &CaseRules::pointsPerDay),
+			field("dayLimit", &CaseRules::dayLimit),
+			field("clueRevealBonusSeconds", &CaseRules::clueRevealBonusSeconds),
+			field("rejectionPenaltyDays", &CaseRules::rejectionPenaltyDays));
+	};
+
+	template <> struct Descriptor<AnswerConcept> {
+		static constexpr auto fields = std::make_tuple(
+			field("label", &AnswerConcept::label),
+			field("terms", &AnswerConcept::terms));
+	};
+
+	// answerConcepts fica de fora: aceita a forma abreviada ("termo") e e lido a parte pelo MongoStore.
+	template <> struct Descriptor<BugCase> {
+		static constexpr auto fields = std::make_tuple(
+			field("id", &BugCase::id),
+			field("title", &BugCase::title),
+			field("description", &BugCase::description),
+			field("solutionQuestions", &BugCase::solutionQuestions),
+			field("correctAnswers", &BugCase::correctAnswers),
+			field("availableClues", &BugCase::availableClues),
+			field("systemTopology", &BugCase::systemTopology),
+			field("rules", &BugCase::rules));
+	};
+
+	template <> struct Descriptor<CaseSummary> {
+		static constexpr auto fields = std::make_tuple(
+			field("id", &CaseSummary::id),
+			field("title", &CaseSummary::title),
+			field("shortDescription", &CaseSummary::shortDescription));
+	};
+
+	template <> struct Descriptor<InvestigationCoverage> {
+		static constexpr auto fields = std::make_tuple(
+			field("targets", &InvestigationCoverage::targets),
+			field("clues", &InvestigationCoverage::clues));
+	};
+
+	// actionHistory nao e persistido: vive apenas no estado em memoria da acao corrente.
+	template <> struct Descriptor<GameState> {
+		static constexpr auto fields = std::make_tuple(
+			field("sessionId", &GameState::sessionId),
+			field("currentCaseId", &GameState::currentCaseId),
+			field("lastActivity", &GameState::lastActivity),
+			field("currentDay", &GameState::currentDay),
+			field("remainingPoints", &GameState::remainingPoints),
+			field("isCompleted", &GameState::isCompleted),
+			field("isSuddenDeath", &GameState::isSuddenDeath),
+			field("discoveredClues", &GameState::discoveredClues),
+			field("investigatedTargets", &GameState::investigatedTargets),
+			field("breakpointedTargets", &GameState::breakpointedTargets),
+			field("coverage", &GameState::coverage),
+			field("playerIds", &GameState::playerIds),
+			field("hostPlayerId", &GameState::hostPlayerId),
+			field("masterPlayerId", &GameState::masterPlayerId),
+			field("turnOrder", &GameState::turnOrder),
+			field("currentTurnIndex", &GameState::currentTurnIndex),
+			field("turnStartTime", &GameState::turnStartTime),
+			field("revision", &GameState::revision));
+	};
+
+	// connectionId e o ponteiro de conexao sao estado do processo, nao do jogo.
+	template <> struct Descriptor<PlayerInfo> {
+		static constexpr auto fields = std::make_tuple(
+			field("name", &PlayerInfo::name),
+			field("role", &PlayerInfo::role),
+			field("joinedAt", &PlayerInfo::joinedAt));
+	};
+
+	template <> struct Descriptor<LobbyInfo> {
+		static constexpr auto fields = std::make_tuple(
+			field("sessionId", &LobbyInfo::sessionId),
+			field("players", &LobbyInfo::players),
+			field("phase", &LobbyInfo::phase),
+			field("createdAt", &LobbyInfo::createdAt),
+			field("lastActivity", &LobbyInfo::lastActivity));
+	};
+}
\ No newline at end of file
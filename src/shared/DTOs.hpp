@@ -1,9 +1,13 @@
 #pragma once
 
 #include "Enums.hpp"
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include "crow.h"
 
@@ -17,6 +21,19 @@ namespace FindTheBug {
 		Finished
 	};
 
+	// Operacao da nota compartilhada (RGA). Cada code point inserido tem id (counter, replica);
+	// counter 0 representa o inicio do texto. Ver engine/SharedNote.
+	struct NoteOp {
+		std::string replica;     // autor, carimbado pelo servidor
+		int64_t counter{ 0 };    // insercao: id do primeiro code point; os seguintes usam counter+1, counter+2...
+		std::string text;        // insercao: texto UTF-8
+		int64_t refCounter{ 0 }; // insercao: id a esquerda; remocao: primeiro id removido
+		std::string refReplica;
+		int32_t removeCount{ 0 }; // > 0: remove refCounter..refCounter+removeCount-1 de refReplica
+
+		bool isRemove() const { return removeCount > 0; }
+	};
+
 	struct DiscoveredClue {
 		std::string id;
 		std::string targetId;
@@ -25,6 +42,7 @@ namespace FindTheBug {
 		std::string content;
 		std::string discoveredBy;
 		std::map<std::string, std::string> playerNotes;
+		std::vector<NoteOp> sharedNoteOps; // log da nota compartilhada, em ordem de chegada
 	};
 
 	struct PlayerAction {
@@ -64,6 +82,29 @@ namespace FindTheBug {
 		std::vector<ConnectionNode> connections;
 	};
 
+	// action e cost sao obrigatorios: sem um deles a regra e descartada em vez de cair num padrao.
+	struct ActionCostRule {
+		std::optional<ActionType> action;
+		std::optional<int> cost;
+		int discountedCost{ -1 }; // negativo: igual a cost
+		CostDiscount discountWhen{ CostDiscount::None };
+	};
+
+	// Regras de balanceamento definidas no documento do caso. Campos ausentes usam o padrao do jogo.
+	struct CaseRules {
+		std::vector<ActionCostRule> actionCosts;
+		int pointsPerDay{ 12 };
+		int dayLimit{ 5 };
+		int clueRevealBonusSeconds{ 30 };
+		int rejectionPenaltyDays{ 2 };
+	};
+
+	// Conceito exigido em uma resposta; qualquer um dos termos (sinonimos) o satisfaz.
+	struct AnswerConcept {
+		std::string label;
+		std::vector<std::string> terms;
+	};
+
 	struct BugCase {
 		std::string id;
 		std::string title;
@@ -71,9 +112,11 @@ namespace FindTheBug {
 
 		std::vector<std::string> solutionQuestions;
 		std::vector<std::string> correctAnswers;
+		std::vector<std::vector<AnswerConcept>> answerConcepts; // indexado como correctAnswers
 
 		std::vector<Clue> availableClues;
 		SystemTopology systemTopology;
+		CaseRules rules;
 	};
 
 	struct CaseSummary {
@@ -82,6 +125,13 @@ namespace FindTheBug {
 		std::string shortDescription;
 	};
 
+	// Progresso da investigacao, indexado por TargetType e ClueType.
+	// Mantido pelo motor a cada pista nova para que o painel do Mestre nao precise varrer o estado.
+	struct InvestigationCoverage {
+		std::array<int, kTargetTypeCount> targets{}; // alvos distintos com ao menos uma pista
+		std::array<int, kClueTypeCount> clues{};
+	};
+
 	struct GameState {
 		std::string sessionId;
 		std::string currentCaseId;
@@ -97,6 +147,8 @@ namespace FindTheBug {
 		std::unordered_set<std::string> investigatedTargets;
 		std::unordered_set<std::string> breakpointedTargets;
 
+		InvestigationCoverage coverage;
+
 		// Jogadores
 		std::vector<std::string> playerIds;
 		std::string hostPlayerId;
@@ -107,8 +159,24 @@ namespace FindTheBug {
 		int currentTurnIndex;
 		std::chrono::system_clock::time_point turnStartTime;
 
+		// Incrementada so pelo armazenamento, na mesma operacao atomica de cada mudanca gravada; ordena pos-imagens
+		// concorrentes. Quem leu o estado nunca a altera: duas escritas nao podem sair com a mesma revisao.
+		int64_t revision{ 0 };
+
 	};
 
+	// O nome do jogador vira chave de documento (playerNotes) e caminho de update no banco:
+	// sem '.', sem '$' inicial e sem caracteres de controle.
+	inline constexpr size_t kMaxPlayerNameLength = 64;
+
+	inline bool isValidPlayerName(std::string_view name) {
+		if (name.empty() || name.size() > kMaxPlayerNameLength || name.front() == '$') return false;
+		for (unsigned char c : name) {
+			if (c < 0x20 || c == '.' || c == 0x7f) return false;
+		}
+		return true;
+	}
+
 	struct PlayerInfo {
 		std::string id;
 		std::string name;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace FindTheBug {
 
 	enum class GameResult { Running, Victory, Defeat };
@@ -15,6 +17,13 @@ namespace FindTheBug {
 		SkipTurn
 	};
 
+	// Condicao que aplica o custo reduzido de uma acao sobre o alvo.
+	enum class CostDiscount {
+		None = 0,
+		WhenInvestigated = 1,
+		WhenBreakpointed = 2
+	};
+
 	enum class ClueType {
 		Documentation = 0,
 		Log = 1,
@@ -24,12 +33,16 @@ namespace FindTheBug {
 		IntegrationTestResult = 5
 	};
 
+	inline constexpr size_t kClueTypeCount = static_cast<size_t>(ClueType::IntegrationTestResult) + 1;
+
 	enum class TargetType {
 		Module = 0,
 		Function = 1,
 		Connection = 2
 	};
 
+	inline constexpr size_t kTargetTypeCount = static_cast<size_t>(TargetType::Connection) + 1;
+
 	enum class PlayerRole {
 		Player,
 		Master,
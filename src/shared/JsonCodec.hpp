@@ -0,0 +1,239 @@
+#pragma once
+
+#include "Reflect.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <crow.h>
+#include <string>
+#include <string_view>
+
+// Codec JSON gerado a partir dos descritores de Reflect.hpp.
+// A escrita e feita direto no buffer de saida (std::string ou std::pmr::string), sem arvore intermediaria.
+namespace FindTheBug::Json {
+
+    namespace detail {
+        // SWAR: verdadeiro se algum dos 8 bytes e < 0x20, '"' ou '\\'. Bytes UTF-8 (>= 0x80) nunca casam.
+        inline bool hasEscapableByte(uint64_t word) {
+            constexpr uint64_t ones = 0x0101010101010101ull;
+            constexpr uint64_t high = 0x8080808080808080ull;
+            uint64_t quote = word ^ (ones * '"');
+            uint64_t slash = word ^ (ones * '\\');
+            uint64_t hits = ((word - ones * 0x20) & ~word)
+                | ((quote - ones) & ~quote)
+                | ((slash - ones) & ~slash);
+            return (hits & high) != 0;
+        }
+    }
+
+    template <typename Out>
+    void appendEscaped(Out& out, std::string_view s) {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        // Trechos sem caracteres especiais sao copiados de uma vez; a busca avanca 8 bytes por passo.
+        size_t runStart = 0;
+        size_t i = 0;
+        while (i < s.size()) {
+            if (i + 8 <= s.size()) {
+                uint64_t word;
+                std::memcpy(&word, s.data() + i, sizeof(word));
+                if (!detail::hasEscapableByte(word)) {
+                    i += 8;
+                    continue;
+                }
+            }
+
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                ++i;
+                continue;
+            }
+
+            out.append(s.data() + runStart, i - runStart);
+            runStart = ++i;
+
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xf];
+                out += hex[c & 0xf];
+            }
+        }
+        out.append(s.data() + runStart, s.size() - runStart);
+    }
+
+    template <typename Out>
+    void appendQuoted(Out& out, std::string_view s) {
+        out += '"';
+        appendEscaped(out, s);
+        out += '"';
+    }
+
+    template <typename Out>
+    void appendInt(Out& out, long long value) {
+        char buf[24];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, static_cast<size_t>(end - buf));
+    }
+
+    // ---- Escrita ----
+
+    template <typename Out, typename T>
+    void write(Out& out, const T& value);
+
+    template <typename Out, Reflect::Described T>
+    void writeObject(Out& out, const T& value) {
+        out += '{';
+        bool first = true;
+        Reflect::forEachField<T>([&](const auto& f) {
+            out += f.jsonKey(first);
+            first = false;
+            write(out, value.*(f.member));
+        });
+        out += '}';
+    }
+
+    template <typename Out, typename T>
+    void write(Out& out, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += value ? "true" : "false";
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            appendInt(out, static_cast<long long>(value));
+        }
+        else if constexpr (Reflect::Integer<T>) {
+            appendInt(out, static_cast<long long>(value));
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            appendQuoted(out, value);
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            // Milissegundos desde a epoca, como Date.now() no cliente.
+            appendInt(out, std::chrono::duration_cast<std::chrono::milliseconds>(value.time_since_epoch()).count());
+        }
+        else if constexpr (Reflect::Optional<T>) {
+            if (value) write(out, *value);
+            else out += "null";
+        }
+        else if constexpr (Reflect::Described<T>) {
+            writeObject(out, value);
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            out += '{';
+            bool first = true;
+            for (const auto& [key, item] : value) {
+                if (!first) out += ',';
+                first = false;
+                appendQuoted(out, key);
+                out += ':';
+                write(out, item);
+            }
+            out += '}';
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            out += '[';
+            bool first = true;
+            for (const auto& item : value) {
+                if (!first) out += ',';
+                first = false;
+                write(out, item);
+            }
+            out += ']';
+        }
+        else {
+            static_assert(sizeof(T) == 0, "Json::write: tipo sem descritor");
+        }
+    }
+
+    template <typename T>
+    std::string toString(const T& value, size_t reserve = 256) {
+        std::string out;
+        out.reserve(reserve);
+        write(out, value);
+        return out;
+    }
+
+    // ---- Leitura ----
+    // Campos ausentes ou com tipo incompativel mantem o valor padrao do DTO.
+
+    template <typename T>
+    bool read(const crow::json::rvalue& json, T& out);
+
+    template <Reflect::Described T>
+    bool readObject(const crow::json::rvalue& json, T& out) {
+        if (json.t() != crow::json::type::Object) return false;
+        for (const auto& item : json) {
+            Reflect::visitField<T>(item.key(), [&](const auto& f) {
+                read(item, out.*(f.member));
+            });
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool read(const crow::json::rvalue& json, T& out) {
+        auto t = json.t();
+        if constexpr (std::is_same_v<T, bool>) {
+            if (t != crow::json::type::True && t != crow::json::type::False) return false;
+            out = (t == crow::json::type::True);
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            if (t == crow::json::type::String) return Reflect::parseEnum(std::string_view(std::string(json.s())), out);
+            if (t != crow::json::type::Number) return false;
+            out = static_cast<T>(json.i());
+        }
+        else if constexpr (Reflect::Integer<T>) {
+            if (t != crow::json::type::Number) return false;
+            out = static_cast<T>(json.i());
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            if (t != crow::json::type::String) return false;
+            out = json.s();
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            if (t != crow::json::type::Number) return false;
+            out = T(std::chrono::milliseconds(json.i()));
+        }
+        else if constexpr (Reflect::Optional<T>) {
+            if (t == crow::json::type::Null) {
+                out.reset();
+                return true;
+            }
+            typename T::value_type inner{};
+            if (!read(json, inner)) return false;
+            out = std::move(inner);
+        }
+        else if constexpr (Reflect::Described<T>) {
+            return readObject(json, out);
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            if (t != crow::json::type::Object) return false;
+            out.clear();
+            for (const auto& item : json) {
+                typename T::mapped_type value{};
+                if (read(item, value)) out.emplace(item.key(), std::move(value));
+            }
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            if (t != crow::json::type::List) return false;
+            if constexpr (!Reflect::IsStdArray<T>::value) out.clear();
+            size_t i = 0;
+            for (const auto& item : json) {
+                Reflect::ElementType<T> value{};
+                if (read(item, value) && !Reflect::insertElement(out, i, std::move(value))) break;
+                ++i;
+            }
+        }
+        else {
+            static_assert(sizeof(T) == 0, "Json::read: tipo sem descritor");
+        }
+        return true;
+    }
+}
\ No newline at end of file
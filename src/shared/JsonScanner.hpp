@@ -0,0 +1,450 @@
+#pragma once
+
+#include "Reflect.hpp"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Leitura sob demanda de JSON recebido: uma passada valida o texto e marca onde cada valor comeca e termina,
+// sem montar arvore nem alocar. Valores sao trechos do texto original e so viram string/numero quando pedidos,
+// entao o texto precisa viver enquanto eles forem usados.
+namespace FindTheBug::Json {
+
+    enum class Kind : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    namespace detail {
+        inline constexpr int kMaxDepth = 64;
+
+        inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+        inline int hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        inline const char* skipSpace(const char* p, const char* end) {
+            while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+            return p;
+        }
+
+        // p aponta para a aspa de abertura. Retorna o byte apos a aspa de fechamento, ou nullptr se invalida.
+        inline const char* scanString(const char* p, const char* end) {
+            for (++p; p < end; ++p) {
+                unsigned char c = static_cast<unsigned char>(*p);
+                if (c == '"') return p + 1;
+                if (c < 0x20) return nullptr;
+                if (c != '\\') continue;
+
+                if (++p == end) return nullptr;
+                switch (*p) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    if (end - p < 5) return nullptr;
+                    for (int i = 1; i <= 4; ++i) {
+                        if (hexValue(p[i]) < 0) return nullptr;
+                    }
+                    p += 4;
+                    break;
+                default:
+                    return nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        inline const char* scanNumber(const char* p, const char* end) {
+            if (p < end && *p == '-') ++p;
+            if (p == end || !isDigit(*p)) return nullptr;
+            if (*p == '0') ++p;  // sem zeros a esquerda
+            else while (p < end && isDigit(*p)) ++p;
+            if (p < end && *p == '.') {
+                const char* fraction = ++p;
+                while (p < end && isDigit(*p)) ++p;
+                if (p == fraction) return nullptr;
+            }
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                ++p;
+                if (p < end && (*p == '+' || *p == '-')) ++p;
+                const char* exponent = p;
+                while (p < end && isDigit(*p)) ++p;
+                if (p == exponent) return nullptr;
+            }
+            return p;
+        }
+
+        inline const char* scanLiteral(const char* p, const char* end, std::string_view word) {
+            if (static_cast<size_t>(end - p) < word.size() || std::string_view(p, word.size()) != word) return nullptr;
+            return p + word.size();
+        }
+
+        inline const char* scanValue(const char* p, const char* end, int depth);
+
+        inline const char* scanContainer(const char* p, const char* end, int depth) {
+            if (depth >= kMaxDepth) return nullptr;
+            bool object = *p == '{';
+            char close = object ? '}' : ']';
+
+            p = skipSpace(p + 1, end);
+            if (p < end && *p == close) return p + 1;
+
+            while (p < end) {
+                if (object) {
+                    if (*p != '"') return nullptr;
+                    p = scanString(p, end);
+                    if (!p) return nullptr;
+                    p = skipSpace(p, end);
+                    if (p == end || *p != ':') return nullptr;
+                    p = skipSpace(p + 1, end);
+                }
+                p = scanValue(p, end, depth + 1);
+                if (!p) return nullptr;
+                p = skipSpace(p, end);
+                if (p == end) return nullptr;
+                if (*p == close) return p + 1;
+                if (*p != ',') return nullptr;
+                p = skipSpace(p + 1, end);
+            }
+            return nullptr;
+        }
+
+        // Retorna o byte apos o valor que comeca em p, ou nullptr se o texto nao e JSON valido.
+        inline const char* scanValue(const char* p, const char* end, int depth) {
+            if (p == end) return nullptr;
+            switch (*p) {
+            case '"': return scanString(p, end);
+            case '{': case '[': return scanContainer(p, end, depth);
+            case 't': return scanLiteral(p, end, "true");
+            case 'f': return scanLiteral(p, end, "false");
+            case 'n': return scanLiteral(p, end, "null");
+            default: return scanNumber(p, end);
+            }
+        }
+
+        inline void appendUtf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out += static_cast<char>(cp);
+            }
+            else if (cp < 0x800) {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000) {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+
+        inline uint32_t readHex4(const char* p) {
+            return (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) | (hexValue(p[2]) << 4) | hexValue(p[3]);
+        }
+
+        // body: conteudo de uma string ja validada, sem as aspas.
+        inline void unescape(std::string_view body, std::string& out) {
+            size_t slash = body.find('\\');
+            if (slash == std::string_view::npos) {
+                out.assign(body);
+                return;
+            }
+
+            out.assign(body.substr(0, slash));
+            const char* p = body.data() + slash;
+            const char* end = body.data() + body.size();
+            while (p < end) {
+                if (*p != '\\') {
+                    const char* run = p;
+                    while (p < end && *p != '\\') ++p;
+                    out.append(run, static_cast<size_t>(p - run));
+                    continue;
+                }
+                char c = p[1];
+                p += 2;
+                switch (c) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp = readHex4(p);
+                    p += 4;
+                    if (cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        uint32_t low = readHex4(p + 2);
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            p += 6;
+                        }
+                    }
+                    // Surrogate sem par nao e code point valido.
+                    if (cp >= 0xD800 && cp < 0xE000) cp = 0xFFFD;
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: out += c; break;  // '"', '\\' e '/'
+                }
+            }
+        }
+    }
+
+    // Trecho de um valor ja validado. Copiar e barato (dois ponteiros).
+    class Value {
+    public:
+        Value() = default;
+
+        // nullopt se o texto nao for exatamente um valor JSON (espacos nas bordas sao aceitos).
+        static std::optional<Value> parse(std::string_view text) {
+            const char* end = text.data() + text.size();
+            const char* begin = detail::skipSpace(text.data(), end);
+            const char* after = detail::scanValue(begin, end, 0);
+            if (!after || detail::skipSpace(after, end) != end) return std::nullopt;
+            return Value(std::string_view(begin, static_cast<size_t>(after - begin)));
+        }
+
+        Kind kind() const {
+            switch (text.empty() ? 'n' : text.front()) {
+            case '"': return Kind::String;
+            case '{': return Kind::Object;
+            case '[': return Kind::Array;
+            case 't': case 'f': return Kind::Bool;
+            case 'n': return Kind::Null;
+            default: return Kind::Number;
+            }
+        }
+
+        std::string_view raw() const { return text; }
+
+        // Chaves chegam cruas em forEachMember; decodifica quando o nome precisa ser guardado.
+        static void decodeKey(std::string_view key, std::string& out) { detail::unescape(key, out); }
+
+        // Sem escapes o conteudo e copiado de uma vez; com escapes, decodificado direto em out.
+        bool toString(std::string& out) const {
+            if (kind() != Kind::String) return false;
+            detail::unescape(text.substr(1, text.size() - 2), out);
+            return true;
+        }
+
+        // Sem escapes, o conteudo como trecho do texto; false se for preciso decodificar.
+        bool toStringView(std::string_view& out) const {
+            if (kind() != Kind::String) return false;
+            std::string_view body = text.substr(1, text.size() - 2);
+            if (body.find('\\') != std::string_view::npos) return false;
+            out = body;
+            return true;
+        }
+
+        bool toInt(long long& out) const {
+            if (kind() != Kind::Number) return false;
+            const char* end = text.data() + text.size();
+            auto [ptr, ec] = std::from_chars(text.data(), end, out);
+            if (ec == std::errc() && ptr == end) return true;
+
+            // Fracao ou expoente: trunca, como o leitor do crow.
+            double d = 0;
+            auto [dptr, dec] = std::from_chars(text.data(), end, d);
+            if (dec != std::errc() || dptr != end) return false;
+            out = static_cast<long long>(d);
+            return true;
+        }
+
+        bool toBool(bool& out) const {
+            if (kind() != Kind::Bool) return false;
+            out = text.front() == 't';
+            return true;
+        }
+
+        // fn(Value) para cada elemento. false se nao for lista.
+        template <typename Fn>
+        bool forEachElement(Fn&& fn) const {
+            if (kind() != Kind::Array) return false;
+            walk([&](std::string_view, Value item) { fn(item); });
+            return true;
+        }
+
+        // fn(chave, Value) para cada membro, na ordem do texto. Chaves chegam cruas (sem decodificar escapes);
+        // as do protocolo sao ASCII.
+        template <typename Fn>
+        bool forEachMember(Fn&& fn) const {
+            if (kind() != Kind::Object) return false;
+            walk(fn);
+            return true;
+        }
+
+    private:
+        explicit Value(std::string_view validated) : text(validated) {}
+
+        // O trecho ja foi validado: os scans aqui nao falham.
+        template <typename Fn>
+        void walk(Fn&& fn) const {
+            bool object = text.front() == '{';
+            const char* end = text.data() + text.size() - 1;
+            const char* p = detail::skipSpace(text.data() + 1, end);
+            while (p < end) {
+                std::string_view key;
+                if (object) {
+                    const char* keyEnd = detail::scanString(p, end);
+                    key = std::string_view(p + 1, static_cast<size_t>(keyEnd - p - 2));
+                    p = detail::skipSpace(keyEnd, end);
+                    p = detail::skipSpace(p + 1, end);
+                }
+                const char* after = detail::scanValue(p, end, 0);
+                fn(key, Value(std::string_view(p, static_cast<size_t>(after - p))));
+                p = detail::skipSpace(after, end);
+                if (p < end) p = detail::skipSpace(p + 1, end);  // virgula
+            }
+        }
+
+        std::string_view text{ "null" };
+    };
+
+    // Objeto de topo de uma mensagem, indexado em uma passada. Mensagens do protocolo tem poucos campos:
+    // acima de kMaxMembers os excedentes sao ignorados. V e o valor do formato (Json::Value, MsgPack::Value).
+    template <typename V>
+    class BasicObject {
+    public:
+        static constexpr size_t kMaxMembers = 16;
+
+        static std::optional<BasicObject> parse(std::string_view text) {
+            auto value = V::parse(text);
+            if (!value || value->kind() != Kind::Object) return std::nullopt;
+            return BasicObject(*value);
+        }
+
+        explicit BasicObject(const V& value) {
+            value.forEachMember([this](std::string_view key, V item) {
+                if (count < kMaxMembers) members[count++] = { key, item };
+            });
+        }
+
+        const V* find(std::string_view key) const {
+            for (size_t i = 0; i < count; ++i) {
+                if (members[i].first == key) return &members[i].second;
+            }
+            return nullptr;
+        }
+
+        bool has(std::string_view key) const { return find(key) != nullptr; }
+
+        template <typename Fn>
+        void forEachMember(Fn&& fn) const {
+            for (size_t i = 0; i < count; ++i) fn(members[i].first, members[i].second);
+        }
+
+    private:
+        std::array<std::pair<std::string_view, V>, kMaxMembers> members{};
+        size_t count{ 0 };
+    };
+
+    using Object = BasicObject<Value>;
+
+    // ---- Leitura para DTOs, mesmas regras de read(crow::json::rvalue) ----
+
+    // Valor de qualquer formato lido sob demanda (Json::Value, MsgPack::Value).
+    template <typename V>
+    concept ScannedValue = requires(const V& v, std::string& s, long long& i, bool& b) {
+        { v.kind() } -> std::same_as<Kind>;
+        { v.toString(s) } -> std::same_as<bool>;
+        { v.toInt(i) } -> std::same_as<bool>;
+        { v.toBool(b) } -> std::same_as<bool>;
+        V::decodeKey(std::string_view{}, s);
+    };
+
+    template <ScannedValue V, typename T>
+    bool read(const V& json, T& out);
+
+    // Campos do descritor encontrados no objeto. false se algum deles tem tipo incompativel.
+    template <ScannedValue V, Reflect::Described T>
+    bool readFields(const BasicObject<V>& json, T& out) {
+        bool ok = true;
+        json.forEachMember([&](std::string_view key, const V& item) {
+            Reflect::visitField<T>(key, [&](const auto& f) {
+                ok = read(item, out.*(f.member)) && ok;
+            });
+        });
+        return ok;
+    }
+
+    template <ScannedValue V, typename T>
+    bool read(const V& json, T& out) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return json.toBool(out);
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            if (json.kind() == Kind::String) {
+                std::string name;
+                json.toString(name);
+                return Reflect::parseEnum(std::string_view(name), out);
+            }
+            long long v = 0;
+            if (!json.toInt(v)) return false;
+            out = static_cast<T>(v);
+        }
+        else if constexpr (Reflect::Integer<T>) {
+            long long v = 0;
+            if (!json.toInt(v)) return false;
+            out = static_cast<T>(v);
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            return json.toString(out);
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            long long ms = 0;
+            if (!json.toInt(ms)) return false;
+            out = T(std::chrono::milliseconds(ms));
+        }
+        else if constexpr (Reflect::Optional<T>) {
+            if (json.kind() == Kind::Null) {
+                out.reset();
+                return true;
+            }
+            typename T::value_type inner{};
+            if (!read(json, inner)) return false;
+            out = std::move(inner);
+        }
+        else if constexpr (Reflect::Described<T>) {
+            return json.forEachMember([&](std::string_view key, const V& item) {
+                Reflect::visitField<T>(key, [&](const auto& f) {
+                    read(item, out.*(f.member));
+                });
+            });
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            if (json.kind() != Kind::Object) return false;
+            out.clear();
+            json.forEachMember([&](std::string_view key, const V& item) {
+                typename T::mapped_type value{};
+                std::string name;
+                V::decodeKey(key, name);
+                if (read(item, value)) out.emplace(std::move(name), std::move(value));
+            });
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            if (json.kind() != Kind::Array) return false;
+            if constexpr (!Reflect::IsStdArray<T>::value) out.clear();
+            size_t i = 0;
+            bool full = false;
+            json.forEachElement([&](const V& item) {
+                if (full) return;
+                Reflect::ElementType<T> value{};
+                if (read(item, value) && !Reflect::insertElement(out, i, std::move(value))) full = true;
+                ++i;
+            });
+        }
+        else {
+            static_assert(sizeof(T) == 0, "Json::read: tipo sem descritor");
+        }
+        return true;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "JsonCodec.hpp"
+#include <cstdint>
+#include <string_view>
+
+namespace FindTheBug::Json {
+
+    // Escritor incremental sobre um buffer reutilizavel (std::string ou std::pmr::string da arena da tarefa).
+    // Cuida das virgulas e delega valores ao codec; nao aloca nada alem do proprio buffer.
+    // Chaves sao literais do protocolo e vao sem escape. Aninhamento limitado a 64 niveis.
+    template <typename Out>
+    class Writer {
+    public:
+        explicit Writer(Out& out) : out(out) {}
+
+        Writer& beginObject() { return open('{'); }
+        Writer& endObject() { return close('}'); }
+        Writer& beginArray() { return open('['); }
+        Writer& endArray() { return close(']'); }
+
+        Writer& key(std::string_view name) {
+            separate();
+            out += '"';
+            out += name;
+            out += "\":";
+            pendingValue = true;
+            return *this;
+        }
+
+        Writer& string(std::string_view s) {
+            separate();
+            appendQuoted(out, s);
+            return *this;
+        }
+
+        Writer& integer(long long value) {
+            separate();
+            appendInt(out, value);
+            return *this;
+        }
+
+        Writer& boolean(bool value) {
+            separate();
+            out += value ? "true" : "false";
+            return *this;
+        }
+
+        Writer& null() {
+            separate();
+            out += "null";
+            return *this;
+        }
+
+        // Qualquer tipo que o codec conhece: escalares, DTOs descritos, sequencias e mapas.
+        template <typename T>
+        Writer& value(const T& v) {
+            separate();
+            write(out, v);
+            return *this;
+        }
+
+        template <typename T>
+        Writer& field(std::string_view name, const T& v) {
+            key(name);
+            return value(v);
+        }
+
+        Out& buffer() { return out; }
+
+    private:
+        void separate() {
+            if (pendingValue) {
+                pendingValue = false;
+                return;
+            }
+            if (depth == 0) return;
+            uint64_t bit = uint64_t{ 1 } << (depth - 1);
+            if (nonEmpty & bit) out += ',';
+            nonEmpty |= bit;
+        }
+
+        Writer& open(char c) {
+            separate();
+            out += c;
+            ++depth;
+            nonEmpty &= ~(uint64_t{ 1 } << (depth - 1));
+            return *this;
+        }
+
+        Writer& close(char c) {
+            --depth;
+            out += c;
+            return *this;
+        }
+
+        Out& out;
+        uint64_t nonEmpty{ 0 };  // bit n: o container de profundidade n + 1 ja tem elemento
+        int depth{ 0 };
+        bool pendingValue{ false };
+    };
+}
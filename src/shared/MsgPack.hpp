@@ -0,0 +1,446 @@
+#pragma once
+
+#include "JsonScanner.hpp"
+#include "Reflect.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// MessagePack com o mesmo esquema do JSON: objetos viram mapas com as mesmas chaves, enums e datas
+// os mesmos inteiros. Clientes que negociam o formato binario recebem e mandam exatamente as mesmas
+// mensagens, so que menores e sem escapes.
+namespace FindTheBug::MsgPack {
+
+    namespace detail {
+        inline constexpr int kMaxDepth = 64;
+
+        // Cabecalho de 5 bytes reservado por container aberto no Writer: cabe qualquer contagem.
+        inline constexpr size_t kPlaceholder = 5;
+
+        template <typename Out>
+        void appendBigEndian(Out& out, uint64_t value, int bytes) {
+            for (int i = bytes - 1; i >= 0; --i) out += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+
+        // Grava em buf o menor cabecalho de mapa ou lista para count itens; retorna o tamanho.
+        inline size_t containerHeader(char* buf, bool map, size_t count) {
+            if (count < 16) {
+                buf[0] = static_cast<char>((map ? 0x80 : 0x90) | count);
+                return 1;
+            }
+            size_t width = count <= 0xffff ? 2 : 4;
+            buf[0] = static_cast<char>(map ? (width == 2 ? 0xde : 0xdf) : (width == 2 ? 0xdc : 0xdd));
+            for (size_t i = 0; i < width; ++i) buf[1 + i] = static_cast<char>((count >> (8 * (width - 1 - i))) & 0xff);
+            return 1 + width;
+        }
+    }
+
+    template <typename Out>
+    void appendInt(Out& out, long long value) {
+        if (value >= 0) {
+            auto v = static_cast<uint64_t>(value);
+            if (v < 0x80) out += static_cast<char>(v);
+            else if (v <= 0xff) { out += static_cast<char>(0xcc); detail::appendBigEndian(out, v, 1); }
+            else if (v <= 0xffff) { out += static_cast<char>(0xcd); detail::appendBigEndian(out, v, 2); }
+            else if (v <= 0xffffffff) { out += static_cast<char>(0xce); detail::appendBigEndian(out, v, 4); }
+            else { out += static_cast<char>(0xcf); detail::appendBigEndian(out, v, 8); }
+            return;
+        }
+        auto bits = static_cast<uint64_t>(value);
+        if (value >= -32) out += static_cast<char>(value);  // fixint negativo: 0xe0..0xff
+        else if (value >= INT8_MIN) { out += static_cast<char>(0xd0); detail::appendBigEndian(out, bits, 1); }
+        else if (value >= INT16_MIN) { out += static_cast<char>(0xd1); detail::appendBigEndian(out, bits, 2); }
+        else if (value >= INT32_MIN) { out += static_cast<char>(0xd2); detail::appendBigEndian(out, bits, 4); }
+        else { out += static_cast<char>(0xd3); detail::appendBigEndian(out, bits, 8); }
+    }
+
+    template <typename Out>
+    void appendString(Out& out, std::string_view s) {
+        if (s.size() < 32) out += static_cast<char>(0xa0 | s.size());
+        else if (s.size() <= 0xff) { out += static_cast<char>(0xd9); detail::appendBigEndian(out, s.size(), 1); }
+        else if (s.size() <= 0xffff) { out += static_cast<char>(0xda); detail::appendBigEndian(out, s.size(), 2); }
+        else { out += static_cast<char>(0xdb); detail::appendBigEndian(out, s.size(), 4); }
+        out.append(s.data(), s.size());
+    }
+
+    template <typename Out>
+    void appendHeader(Out& out, bool map, size_t count) {
+        char buf[detail::kPlaceholder];
+        out.append(buf, detail::containerHeader(buf, map, count));
+    }
+
+    // ---- Escrita (mesmas regras de Json::write) ----
+
+    template <typename Out, typename T>
+    void write(Out& out, const T& value);
+
+    template <typename Out, Reflect::Described T>
+    void writeObject(Out& out, const T& value) {
+        appendHeader(out, true, std::tuple_size_v<std::remove_cvref_t<decltype(Reflect::Descriptor<T>::fields)>>);
+        Reflect::forEachField<T>([&](const auto& f) {
+            appendString(out, f.name);
+            write(out, value.*(f.member));
+        });
+    }
+
+    template <typename Out, typename T>
+    void write(Out& out, const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += static_cast<char>(value ? 0xc3 : 0xc2);
+        }
+        else if constexpr (std::is_enum_v<T> || Reflect::Integer<T>) {
+            appendInt(out, static_cast<long long>(value));
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            appendString(out, value);
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            appendInt(out, std::chrono::duration_cast<std::chrono::milliseconds>(value.time_since_epoch()).count());
+        }
+        else if constexpr (Reflect::Optional<T>) {
+            if (value) write(out, *value);
+            else out += static_cast<char>(0xc0);
+        }
+        else if constexpr (Reflect::Described<T>) {
+            writeObject(out, value);
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            appendHeader(out, true, value.size());
+            for (const auto& [key, item] : value) {
+                appendString(out, key);
+                write(out, item);
+            }
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            appendHeader(out, false, static_cast<size_t>(std::distance(value.begin(), value.end())));
+            for (const auto& item : value) write(out, item);
+        }
+        else {
+            static_assert(sizeof(T) == 0, "MsgPack::write: tipo sem descritor");
+        }
+    }
+
+    // Mesma interface de Json::Writer, para que as mensagens sejam montadas uma vez para os dois formatos.
+    // A contagem de um container so e conhecida no fim: o cabecalho e reservado com 5 bytes e, ao fechar,
+    // trocado pelo menor que cabe (quase sempre 1 byte), puxando o corpo para tras.
+    template <typename Out>
+    class Writer {
+    public:
+        explicit Writer(Out& out) : out(out) {}
+
+        Writer& beginObject() { return open(true); }
+        Writer& endObject() { return close(); }
+        Writer& beginArray() { return open(false); }
+        Writer& endArray() { return close(); }
+
+        Writer& key(std::string_view name) {
+            ++frames[depth - 1].count;
+            appendString(out, name);
+            pendingValue = true;
+            return *this;
+        }
+
+        Writer& string(std::string_view s) {
+            element();
+            appendString(out, s);
+            return *this;
+        }
+
+        Writer& integer(long long value) {
+            element();
+            appendInt(out, value);
+            return *this;
+        }
+
+        Writer& boolean(bool value) {
+            element();
+            out += static_cast<char>(value ? 0xc3 : 0xc2);
+            return *this;
+        }
+
+        Writer& null() {
+            element();
+            out += static_cast<char>(0xc0);
+            return *this;
+        }
+
+        template <typename T>
+        Writer& value(const T& v) {
+            element();
+            write(out, v);
+            return *this;
+        }
+
+        template <typename T>
+        Writer& field(std::string_view name, const T& v) {
+            key(name);
+            return value(v);
+        }
+
+        Out& buffer() { return out; }
+
+    private:
+        struct Frame {
+            size_t offset{ 0 };
+            size_t count{ 0 };
+            bool map{ false };
+        };
+
+        // Conta o item no container aberto; em mapas quem conta e key().
+        void element() {
+            if (pendingValue) {
+                pendingValue = false;
+                return;
+            }
+            if (depth > 0) ++frames[depth - 1].count;
+        }
+
+        Writer& open(bool map) {
+            element();
+            frames[depth++] = { out.size(), 0, map };
+            out.append(detail::kPlaceholder, '\0');
+            return *this;
+        }
+
+        Writer& close() {
+            const Frame& frame = frames[--depth];
+            char header[detail::kPlaceholder];
+            size_t size = detail::containerHeader(header, frame.map, frame.count);
+            std::copy(header, header + size, out.begin() + static_cast<std::ptrdiff_t>(frame.offset));
+            if (size < detail::kPlaceholder) out.erase(frame.offset + size, detail::kPlaceholder - size);
+            return *this;
+        }
+
+        Out& out;
+        std::array<Frame, detail::kMaxDepth> frames{};
+        int depth{ 0 };
+        bool pendingValue{ false };
+    };
+
+    // ---- Leitura sob demanda (mesma interface de Json::Value) ----
+
+    namespace detail {
+        inline uint64_t readBigEndian(const uint8_t* p, int bytes) {
+            uint64_t v = 0;
+            for (int i = 0; i < bytes; ++i) v = (v << 8) | p[i];
+            return v;
+        }
+
+        inline bool isString(uint8_t b) { return (b & 0xe0) == 0xa0 || b == 0xd9 || b == 0xda || b == 0xdb; }
+
+        // Tamanho do cabecalho e do conteudo de str/bin; false se o byte nao for desses tipos.
+        inline bool stringLayout(const uint8_t* p, size_t available, size_t& header, size_t& length) {
+            uint8_t b = p[0];
+            if ((b & 0xe0) == 0xa0) {
+                header = 1;
+                length = b & 0x1f;
+                return true;
+            }
+            int width = (b == 0xd9 || b == 0xc4) ? 1 : (b == 0xda || b == 0xc5) ? 2 : (b == 0xdb || b == 0xc6) ? 4 : 0;
+            if (width == 0 || available < static_cast<size_t>(1 + width)) return false;
+            header = 1 + static_cast<size_t>(width);
+            length = readBigEndian(p + 1, width);
+            return true;
+        }
+
+        // Cabecalho de mapa/lista: tamanho do cabecalho e numero de itens (pares, em mapas).
+        inline bool containerLayout(const uint8_t* p, size_t available, bool& map, size_t& header, size_t& count) {
+            uint8_t b = p[0];
+            if ((b & 0xf0) == 0x80 || (b & 0xf0) == 0x90) {
+                map = (b & 0xf0) == 0x80;
+                header = 1;
+                count = b & 0x0f;
+                return true;
+            }
+            if (b < 0xdc || b > 0xdf) return false;
+            map = b >= 0xde;
+            int width = (b == 0xdc || b == 0xde) ? 2 : 4;
+            if (available < static_cast<size_t>(1 + width)) return false;
+            header = 1 + static_cast<size_t>(width);
+            count = readBigEndian(p + 1, width);
+            return true;
+        }
+
+        // Retorna o byte apos o valor que comeca em p, ou nullptr se truncado ou invalido.
+        // ext e 0xc1 sao rejeitados: o esquema nao usa; chaves de mapa precisam ser strings.
+        inline const uint8_t* scanValue(const uint8_t* p, const uint8_t* end, int depth) {
+            if (p >= end) return nullptr;
+            auto available = static_cast<size_t>(end - p);
+            uint8_t b = *p;
+
+            if (b <= 0x7f || b >= 0xe0 || b == 0xc0 || b == 0xc2 || b == 0xc3) return p + 1;
+
+            size_t header = 0;
+            size_t length = 0;
+            if (stringLayout(p, available, header, length)) {
+                return available - header >= length ? p + header + length : nullptr;
+            }
+
+            bool map = false;
+            if (containerLayout(p, available, map, header, length)) {
+                if (depth >= kMaxDepth) return nullptr;
+                p += header;
+                // Cada item ocupa ao menos um byte: contagens impossiveis caem aqui sem percorrer nada.
+                if (length > static_cast<size_t>(end - p)) return nullptr;
+                for (size_t i = 0; i < length; ++i) {
+                    if (map) {
+                        if (p == end || !isString(*p)) return nullptr;
+                        p = scanValue(p, end, depth + 1);
+                        if (!p) return nullptr;
+                    }
+                    p = scanValue(p, end, depth + 1);
+                    if (!p) return nullptr;
+                }
+                return p;
+            }
+
+            size_t width = 0;
+            switch (b) {
+            case 0xcc: case 0xd0: width = 1; break;
+            case 0xcd: case 0xd1: width = 2; break;
+            case 0xce: case 0xd2: case 0xca: width = 4; break;
+            case 0xcf: case 0xd3: case 0xcb: width = 8; break;
+            default: return nullptr;
+            }
+            return available > width ? p + 1 + width : nullptr;
+        }
+    }
+
+    // Trecho de um valor ja validado; o buffer do frame precisa viver enquanto ele for usado.
+    class Value {
+    public:
+        Value() = default;
+
+        // nullopt se os bytes nao forem exatamente um valor MessagePack.
+        static std::optional<Value> parse(std::string_view bytes) {
+            auto begin = reinterpret_cast<const uint8_t*>(bytes.data());
+            const uint8_t* after = detail::scanValue(begin, begin + bytes.size(), 0);
+            if (!after || after != begin + bytes.size()) return std::nullopt;
+            return Value(bytes);
+        }
+
+        Json::Kind kind() const {
+            uint8_t b = first();
+            if (b == 0xc0) return Json::Kind::Null;
+            if (b == 0xc2 || b == 0xc3) return Json::Kind::Bool;
+            if ((b & 0xe0) == 0xa0 || (b >= 0xc4 && b <= 0xc6) || (b >= 0xd9 && b <= 0xdb)) return Json::Kind::String;
+            if ((b & 0xf0) == 0x80 || b == 0xde || b == 0xdf) return Json::Kind::Object;
+            if ((b & 0xf0) == 0x90 || b == 0xdc || b == 0xdd) return Json::Kind::Array;
+            return Json::Kind::Number;
+        }
+
+        std::string_view raw() const { return bytes; }
+
+        static void decodeKey(std::string_view key, std::string& out) { out.assign(key); }
+
+        bool toString(std::string& out) const {
+            std::string_view s;
+            if (!toStringView(s)) return false;
+            out.assign(s);
+            return true;
+        }
+
+        // Conteudo da string como trecho do frame (str e bin).
+        bool toStringView(std::string_view& out) const {
+            size_t header = 0;
+            size_t length = 0;
+            if (!detail::stringLayout(data(), bytes.size(), header, length)) return false;
+            out = bytes.substr(header, length);
+            return true;
+        }
+
+        // Floats sao truncados, como no JSON; uint64 acima de LLONG_MAX nao cabe.
+        bool toInt(long long& out) const {
+            uint8_t b = first();
+            const uint8_t* p = data() + 1;
+            if (b <= 0x7f) out = b;
+            else if (b >= 0xe0) out = static_cast<int8_t>(b);
+            else if (b == 0xcc) out = p[0];
+            else if (b == 0xcd) out = static_cast<long long>(detail::readBigEndian(p, 2));
+            else if (b == 0xce) out = static_cast<long long>(detail::readBigEndian(p, 4));
+            else if (b == 0xcf) {
+                uint64_t v = detail::readBigEndian(p, 8);
+                if (v > static_cast<uint64_t>(INT64_MAX)) return false;
+                out = static_cast<long long>(v);
+            }
+            else if (b == 0xd0) out = static_cast<int8_t>(p[0]);
+            else if (b == 0xd1) out = static_cast<int16_t>(detail::readBigEndian(p, 2));
+            else if (b == 0xd2) out = static_cast<int32_t>(detail::readBigEndian(p, 4));
+            else if (b == 0xd3) out = static_cast<long long>(detail::readBigEndian(p, 8));
+            else if (b == 0xca) {
+                auto bits = static_cast<uint32_t>(detail::readBigEndian(p, 4));
+                float f;
+                std::memcpy(&f, &bits, sizeof(f));
+                out = static_cast<long long>(f);
+            }
+            else if (b == 0xcb) {
+                uint64_t bits = detail::readBigEndian(p, 8);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                out = static_cast<long long>(d);
+            }
+            else return false;
+            return true;
+        }
+
+        bool toBool(bool& out) const {
+            if (kind() != Json::Kind::Bool) return false;
+            out = first() == 0xc3;
+            return true;
+        }
+
+        template <typename Fn>
+        bool forEachElement(Fn&& fn) const {
+            if (kind() != Json::Kind::Array) return false;
+            walk([&](std::string_view, Value item) { fn(item); });
+            return true;
+        }
+
+        // Chaves sao strings (validado no scan) e chegam como trecho do frame.
+        template <typename Fn>
+        bool forEachMember(Fn&& fn) const {
+            if (kind() != Json::Kind::Object) return false;
+            walk(fn);
+            return true;
+        }
+
+    private:
+        explicit Value(std::string_view validated) : bytes(validated) {}
+
+        const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(bytes.data()); }
+        uint8_t first() const { return data()[0]; }
+
+        template <typename Fn>
+        void walk(Fn&& fn) const {
+            bool map = false;
+            size_t header = 0;
+            size_t count = 0;
+            detail::containerLayout(data(), bytes.size(), map, header, count);
+            const uint8_t* end = data() + bytes.size();
+            const uint8_t* p = data() + header;
+            for (size_t i = 0; i < count; ++i) {
+                std::string_view key;
+                if (map) {
+                    const uint8_t* keyEnd = detail::scanValue(p, end, 0);
+                    Value(slice(p, keyEnd)).toStringView(key);
+                    p = keyEnd;
+                }
+                const uint8_t* after = detail::scanValue(p, end, 0);
+                fn(key, Value(slice(p, after)));
+                p = after;
+            }
+        }
+
+        static std::string_view slice(const uint8_t* begin, const uint8_t* end) {
+            return std::string_view(reinterpret_cast<const char*>(begin), static_cast<size_t>(end - begin));
+        }
+
+        std::string_view bytes{ "\xc0", 1 };
+    };
+
+    using Object = Json::BasicObject<Value>;
+}
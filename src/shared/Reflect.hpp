@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace FindTheBug::Reflect {
+
+    inline constexpr size_t kMaxFieldName = 40;
+
+    // Descritor de um campo: nome serializado + ponteiro para membro.
+    // 'key' guarda a chave JSON pronta (,"nome":) para que o codec a escreva com um unico append.
+    template <typename Owner, typename Member>
+    struct Field {
+        using OwnerType = Owner;
+        using MemberType = Member;
+
+        std::string_view name;
+        Member Owner::* member;
+        std::array<char, kMaxFieldName + 4> key{};
+        size_t keyLength{ 0 };
+
+        constexpr Field(std::string_view fieldName, Member Owner::* fieldMember)
+            : name(fieldName), member(fieldMember) {
+            if (fieldName.size() > kMaxFieldName) throw "Reflect::field: nome longo demais";
+            key[keyLength++] = ',';
+            key[keyLength++] = '"';
+            for (char c : fieldName) key[keyLength++] = c;
+            key[keyLength++] = '"';
+            key[keyLength++] = ':';
+        }
+
+        // Chave com virgula (demais campos) ou sem (primeiro campo).
+        constexpr std::string_view jsonKey(bool first) const {
+            return first ? std::string_view(key.data() + 1, keyLength - 1) : std::string_view(key.data(), keyLength);
+        }
+    };
+
+    template <typename Owner, typename Member>
+    constexpr Field<Owner, Member> field(std::string_view name, Member Owner::* member) {
+        return { name, member };
+    }
+
+    // Especializado por cada DTO serializavel (ver DTOFields.hpp):
+    //     static constexpr auto fields = std::make_tuple(field("id", &T::id), ...);
+    // Membros fora da tupla nao sao gravados nem lidos.
+    template <typename T>
+    struct Descriptor;
+
+    template <typename T>
+    concept Described = requires { Descriptor<T>::fields; };
+
+    template <Described T, typename Fn>
+    constexpr void forEachField(Fn&& fn) {
+        std::apply([&](const auto&... f) { (fn(f), ...); }, Descriptor<T>::fields);
+    }
+
+    // Aplica fn ao campo chamado 'name'. Retorna false se nenhum campo tiver esse nome.
+    template <Described T, typename Fn>
+    constexpr bool visitField(std::string_view name, Fn&& fn) {
+        return std::apply([&](const auto&... f) {
+            return ((f.name == name ? (fn(f), true) : false) || ...);
+        }, Descriptor<T>::fields);
+    }
+
+    // Nomes opcionais para enums, aceitos na leitura alem do valor inteiro:
+    //     static constexpr std::array<std::pair<std::string_view, E>, N> values{...};
+    template <typename E>
+    struct EnumNames;
+
+    template <typename E>
+    concept NamedEnum = std::is_enum_v<E> && requires { EnumNames<E>::values; };
+
+    template <typename E>
+    constexpr bool parseEnum(std::string_view name, E& out) {
+        if constexpr (NamedEnum<E>) {
+            for (const auto& [text, value] : EnumNames<E>::values) {
+                if (text == name) {
+                    out = value;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // ---- Classificacao dos tipos de membro, compartilhada pelos codecs ----
+
+    template <typename T> struct IsVector : std::false_type {};
+    template <typename T, typename A> struct IsVector<std::vector<T, A>> : std::true_type {};
+
+    template <typename T> struct IsStdArray : std::false_type {};
+    template <typename T, size_t N> struct IsStdArray<std::array<T, N>> : std::true_type {};
+
+    template <typename T> struct IsStringSet : std::false_type {};
+    template <typename H, typename E, typename A> struct IsStringSet<std::unordered_set<std::string, H, E, A>> : std::true_type {};
+
+    template <typename T> struct IsStringMap : std::false_type {};
+    template <typename V, typename C, typename A> struct IsStringMap<std::map<std::string, V, C, A>> : std::true_type {};
+    template <typename V, typename H, typename E, typename A> struct IsStringMap<std::unordered_map<std::string, V, H, E, A>> : std::true_type {};
+
+    template <typename T> struct IsOptional : std::false_type {};
+    template <typename T> struct IsOptional<std::optional<T>> : std::true_type {};
+
+    template <typename T>
+    concept Sequence = IsVector<T>::value || IsStdArray<T>::value || IsStringSet<T>::value;
+
+    template <typename T>
+    concept StringMap = IsStringMap<T>::value;
+
+    template <typename T>
+    concept Optional = IsOptional<T>::value;
+
+    template <typename T>
+    concept TimePoint = std::is_same_v<T, std::chrono::system_clock::time_point>;
+
+    template <typename T>
+    concept Integer = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+    // Insere um elemento no fim de um container de Sequence (vector/set) ou na posicao i (array).
+    template <Sequence C, typename V>
+    bool insertElement(C& container, size_t i, V&& value) {
+        if constexpr (IsStdArray<C>::value) {
+            if (i >= container.size()) return false;
+            container[i] = std::forward<V>(value);
+        }
+        else if constexpr (IsStringSet<C>::value) {
+            container.insert(std::forward<V>(value));
+        }
+        else {
+            container.push_back(std::forward<V>(value));
+        }
+        return true;
+    }
+
+    template <Sequence C>
+    using ElementType = std::remove_cvref_t<decltype(*std::declval<C&>().begin())>;
+}
\ No newline at end of file
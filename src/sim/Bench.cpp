@@ -0,0 +1,848 @@
+#include "Bench.hpp"
+#include "CaseFixture.hpp"
+
+#include "../engine/FuzzyMatcher.hpp"
+#include "../engine/KeywordMatcher.hpp"
+#include "../engine/TextNormalizer.hpp"
+#include "../protocol/Commands.hpp"
+#include "../protocol/Messages.hpp"
+#include "../shared/DTOFields.hpp"
+#include "../shared/JsonCodec.hpp"
+#include "../shared/JsonWriter.hpp"
+#include "../shared/MsgPack.hpp"
+#include "../storage/BsonCodec.hpp"
+
+#include <bsoncxx/builder/stream/array.hpp>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/builder/stream/helpers.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <random>
+
+namespace FindTheBug::Sim {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        // Impede que o compilador descarte o resultado das chamadas medidas.
+        volatile size_t gSink = 0;
+
+        template <typename Fn>
+        BenchResult measure(std::string name, size_t iterations, Fn&& fn) {
+            // Aquecimento: caches e tabelas thread_local.
+            for (size_t i = 0; i < std::min<size_t>(iterations / 10, 1000); ++i) gSink = gSink + fn(i);
+
+            auto start = Clock::now();
+            size_t acc = 0;
+            for (size_t i = 0; i < iterations; ++i) acc += fn(i);
+            auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            gSink = gSink + acc;
+
+            BenchResult result;
+            result.name = std::move(name);
+            result.iterations = iterations;
+            result.nsPerOp = iterations > 0 ? elapsed / static_cast<double>(iterations) : 0.0;
+            return result;
+        }
+
+        // ---- Correspondencia de respostas ----
+
+        enum class Variant { Exact, Typo, Reworded, Unrelated, Count };
+
+        struct AnswerPair {
+            std::string submitted;
+            std::string expected;
+            Variant variant;
+        };
+
+        const std::array<const char*, 24> kWords = {
+            "ponteiro", "nulo", "funcao", "parseConfig", "buffer", "overflow", "indice", "fora",
+            "limite", "loop", "infinito", "condicao", "corrida", "mutex", "deadlock", "memoria",
+            "vazamento", "arquivo", "fechado", "retorno", "ignorado", "divisao", "zero", "cache"
+        };
+
+        std::string phrase(std::mt19937_64& rng, size_t words) {
+            std::string out;
+            for (size_t i = 0; i < words; ++i) {
+                if (i > 0) out += ' ';
+                out += kWords[rng() % kWords.size()];
+            }
+            return out;
+        }
+
+        std::string withTypos(std::string s, std::mt19937_64& rng, size_t edits) {
+            for (size_t e = 0; e < edits && !s.empty(); ++e) {
+                size_t pos = rng() % s.size();
+                switch (rng() % 3) {
+                case 0: s[pos] = static_cast<char>('a' + rng() % 26); break;
+                case 1: s.erase(pos, 1); break;
+                default: s.insert(pos, 1, static_cast<char>('a' + rng() % 26)); break;
+                }
+            }
+            return s;
+        }
+
+        std::vector<AnswerPair> makeAnswerPairs(uint64_t seed, size_t count) {
+            std::mt19937_64 rng(seed);
+            std::vector<AnswerPair> pairs;
+            pairs.reserve(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                // Metade curta (cabe em uma palavra de 64 bits), metade longa (blocos multiplos).
+                size_t words = (i % 2 == 0) ? 3 + rng() % 4 : 12 + rng() % 10;
+                std::string expected = phrase(rng, words);
+                auto variant = static_cast<Variant>(i % static_cast<size_t>(Variant::Count));
+
+                std::string submitted;
+                switch (variant) {
+                case Variant::Exact: submitted = expected; break;
+                case Variant::Typo: submitted = withTypos(expected, rng, 1 + words / 4); break;
+                case Variant::Reworded: submitted = "acho que " + withTypos(expected, rng, 1) + " na " + phrase(rng, 2); break;
+                default: submitted = phrase(rng, words); break;
+                }
+                pairs.push_back({ std::move(submitted), std::move(expected), variant });
+            }
+            return pairs;
+        }
+
+        // Regra anterior do ValidationSystem: minusculas + substring nos dois sentidos.
+        bool legacyMatch(const std::string& submitted, const std::string& expected) {
+            auto lower = [](const std::string& s) {
+                std::string r;
+                r.reserve(s.size());
+                for (unsigned char c : s) r += static_cast<char>(std::tolower(c));
+                return r;
+            };
+            std::string s1 = lower(submitted);
+            std::string s2 = lower(expected);
+            return s1.find(s2) != std::string::npos || s2.find(s1) != std::string::npos;
+        }
+
+        size_t dpEditDistance(const std::string& a, const std::string& b) {
+            std::vector<size_t> prev(b.size() + 1);
+            std::vector<size_t> cur(b.size() + 1);
+            for (size_t j = 0; j <= b.size(); ++j) prev[j] = j;
+            for (size_t i = 1; i <= a.size(); ++i) {
+                cur[0] = i;
+                for (size_t j = 1; j <= b.size(); ++j) {
+                    size_t sub = prev[j - 1] + (a[i - 1] != b[j - 1] ? 1 : 0);
+                    cur[j] = std::min({ prev[j] + 1, cur[j - 1] + 1, sub });
+                }
+                std::swap(prev, cur);
+            }
+            return prev[b.size()];
+        }
+
+        std::string acceptanceDetail(const std::vector<AnswerPair>& pairs, const std::function<bool(const AnswerPair&)>& accepts) {
+            std::array<size_t, static_cast<size_t>(Variant::Count)> total{};
+            std::array<size_t, static_cast<size_t>(Variant::Count)> accepted{};
+            for (const auto& p : pairs) {
+                auto v = static_cast<size_t>(p.variant);
+                total[v]++;
+                if (accepts(p)) accepted[v]++;
+            }
+            auto pct = [&](Variant v) {
+                auto i = static_cast<size_t>(v);
+                return total[i] ? 100.0 * static_cast<double>(accepted[i]) / static_cast<double>(total[i]) : 0.0;
+            };
+            return std::format("aceitas: exata {:.0f}% erro {:.0f}% reescrita {:.0f}% outra {:.0f}%",
+                pct(Variant::Exact), pct(Variant::Typo), pct(Variant::Reworded), pct(Variant::Unrelated));
+        }
+
+        std::vector<BenchResult> benchMatch(const BenchConfig& config) {
+            constexpr double kAccept = 0.8;
+            auto pairs = makeAnswerPairs(config.seed, 4096);
+            const size_t mask = pairs.size() - 1;
+
+            std::vector<BenchResult> results;
+
+            auto legacy = measure("legacy-substring", config.iterations, [&](size_t i) {
+                const auto& p = pairs[i & mask];
+                return static_cast<size_t>(legacyMatch(p.submitted, p.expected));
+            });
+            legacy.detail = acceptanceDetail(pairs, [](const AnswerPair& p) { return legacyMatch(p.submitted, p.expected); });
+            results.push_back(std::move(legacy));
+
+            std::string s1;
+            std::string s2;
+            auto fuzzyScore = [&](const AnswerPair& p) {
+                TextNormalizer::normalize(p.submitted, s1);
+                TextNormalizer::normalize(p.expected, s2);
+                return FuzzyMatcher::score(s1, s2).confidence;
+            };
+
+            auto fuzzy = measure("fuzzy-score", config.iterations, [&](size_t i) {
+                return static_cast<size_t>(fuzzyScore(pairs[i & mask]) >= kAccept);
+            });
+            fuzzy.detail = acceptanceDetail(pairs, [&](const AnswerPair& p) { return fuzzyScore(p) >= kAccept; });
+            results.push_back(std::move(fuzzy));
+
+            results.push_back(measure("edit-distance-dp", config.iterations / 4, [&](size_t i) {
+                const auto& p = pairs[i & mask];
+                return dpEditDistance(p.submitted, p.expected);
+            }));
+
+            results.push_back(measure("edit-distance-bitpar", config.iterations, [&](size_t i) {
+                const auto& p = pairs[i & mask];
+                return FuzzyMatcher::editDistance(p.submitted, p.expected);
+            }));
+
+            // Conceitos: cada palavra do vocabulario e um conceito com dois sinonimos.
+            std::vector<std::pair<std::string, uint32_t>> terms;
+            KeywordMatcher matcher;
+            for (size_t w = 0; w < kWords.size(); ++w) {
+                std::string word;
+                TextNormalizer::normalize(kWords[w], word);
+                for (const auto& term : { word, word + "s" }) {
+                    terms.emplace_back(term, static_cast<uint32_t>(w));
+                    matcher.addPattern(term, static_cast<uint32_t>(w));
+                }
+            }
+            matcher.build();
+
+            std::vector<std::string> lowered;
+            lowered.reserve(pairs.size());
+            for (const auto& p : pairs) {
+                TextNormalizer::normalize(p.submitted, s1);
+                lowered.push_back(s1);
+            }
+
+            auto keywordsFind = measure("keywords-find", config.iterations, [&](size_t i) {
+                const auto& text = lowered[i & mask];
+                uint64_t found = 0;
+                for (const auto& [term, id] : terms) {
+                    if (text.find(term) != std::string::npos) found |= 1ULL << id;
+                }
+                return static_cast<size_t>(found);
+            });
+            keywordsFind.detail = std::format("{} termos", terms.size());
+            results.push_back(std::move(keywordsFind));
+
+            auto keywordsAutomaton = measure("keywords-automaton", config.iterations, [&](size_t i) {
+                return static_cast<size_t>(matcher.scan(lowered[i & mask]));
+            });
+            keywordsAutomaton.detail = std::format("{} termos", terms.size());
+            results.push_back(std::move(keywordsAutomaton));
+
+            return results;
+        }
+
+        // ---- Normalizacao de texto ----
+
+        std::vector<BenchResult> benchNormalize(const BenchConfig& config) {
+            const std::array<const char*, 6> samples = {
+                "A funcao parseConfig nao valida o ponteiro recebido e acessa memoria liberada no retorno.",
+                "A Fun\u00e7\u00e3o parseConfig n\u00e3o valida o ponteiro; ac\u00e9ssa mem\u00f3ria liberada!",
+                "mod0_fn0",
+                "  Condi\u00e7\u00e3o   de   corrida \u2014 dois threads   sem MUTEX  ",
+                "DIVIS\u00c3O POR ZERO QUANDO O \u00cdNDICE \u00c9 NEGATIVO",
+                "\u201cCache\u201d invalidado ap\u00f3s escrita, leitura devolve valor antigo.",
+            };
+
+            std::vector<std::string> texts;
+            size_t bytes = 0;
+            for (const char* sample : samples) {
+                texts.emplace_back(sample);
+                bytes += texts.back().size();
+            }
+            const size_t avgBytes = bytes / texts.size();
+
+            std::vector<BenchResult> results;
+
+            std::string out;
+            auto legacy = measure("tolower-bytes", config.iterations, [&](size_t i) {
+                const auto& text = texts[i % texts.size()];
+                out.clear();
+                for (unsigned char c : text) out += static_cast<char>(std::tolower(c));
+                return out.size();
+            });
+            legacy.detail = std::format("~{} bytes/texto, apenas ASCII (nao remove acentos)", avgBytes);
+            results.push_back(std::move(legacy));
+
+            auto normalized = measure("text-normalizer", config.iterations, [&](size_t i) {
+                TextNormalizer::normalize(texts[i % texts.size()], out);
+                return out.size();
+            });
+            normalized.detail = std::format("~{} bytes/texto", avgBytes);
+            results.push_back(std::move(normalized));
+
+            return results;
+        }
+
+        // ---- Codecs de DTO ----
+
+        // Estado de meio de partida: todas as pistas do caso sintetico descobertas, notas de cada jogador.
+        GameState makeSampleState(const BugCase& bugCase) {
+            GameState state;
+            state.sessionId = "bench-session";
+            state.currentCaseId = bugCase.id;
+            state.lastActivity = std::chrono::system_clock::now();
+            state.turnStartTime = state.lastActivity;
+            state.currentDay = 3;
+            state.remainingPoints = 7;
+            state.playerIds = { "Ana", "Bruno", "Carla", "Diego" };
+            state.turnOrder = state.playerIds;
+            state.currentTurnIndex = 1;
+            state.hostPlayerId = "Ana";
+            state.masterPlayerId = "Mestre";
+
+            for (const auto& clue : bugCase.availableClues) {
+                DiscoveredClue dc;
+                dc.id = clue.id;
+                dc.targetId = clue.targetId;
+                dc.targetType = clue.targetType;
+                dc.type = clue.type;
+                dc.content = clue.content;
+                dc.discoveredBy = state.playerIds[state.discoveredClues.size() % state.playerIds.size()];
+                if (state.discoveredClues.size() % 3 == 0) {
+                    dc.playerNotes[dc.discoveredBy] = "Suspeito: \"" + clue.targetId + "\" nao valida a entrada.";
+                }
+                state.discoveredClues.push_back(std::move(dc));
+                if (clue.type == ClueType::Code) state.investigatedTargets.insert(clue.targetId);
+                if (clue.type == ClueType::Breakpoint) state.breakpointedTargets.insert(clue.targetId);
+            }
+            return state;
+        }
+
+        // Caminho manual anterior de GAME_STATE_UPDATE (lista de pistas).
+        void writeCluesByHand(std::string& out, const std::vector<DiscoveredClue>& clues) {
+            out += '[';
+            bool firstClue = true;
+            for (const auto& c : clues) {
+                if (!firstClue) out += ',';
+                firstClue = false;
+                out += "{\"id\":";
+                Json::appendQuoted(out, c.id);
+                out += ",\"targetId\":";
+                Json::appendQuoted(out, c.targetId);
+                out += ",\"type\":";
+                Json::appendInt(out, static_cast<int>(c.type));
+                out += ",\"content\":";
+                Json::appendQuoted(out, c.content);
+                out += ",\"playerNotes\":{";
+                bool firstNote = true;
+                for (const auto& [player, note] : c.playerNotes) {
+                    if (!firstNote) out += ',';
+                    firstNote = false;
+                    Json::appendQuoted(out, player);
+                    out += ':';
+                    Json::appendQuoted(out, note);
+                }
+                out += "}}";
+            }
+            out += ']';
+        }
+
+        // Caminho anterior das rotas /cases: arvore crow::json::wvalue + dump().
+        std::string writeCluesWithWvalue(const std::vector<DiscoveredClue>& clues) {
+            std::vector<crow::json::wvalue> list;
+            list.reserve(clues.size());
+            for (const auto& c : clues) {
+                crow::json::wvalue cv;
+                cv["id"] = c.id;
+                cv["targetId"] = c.targetId;
+                cv["type"] = static_cast<int>(c.type);
+                cv["content"] = c.content;
+                crow::json::wvalue notes;
+                for (const auto& [player, note] : c.playerNotes) notes[player] = note;
+                cv["playerNotes"] = std::move(notes);
+                list.push_back(std::move(cv));
+            }
+            crow::json::wvalue root;
+            root["discoveredClues"] = std::move(list);
+            return root.dump();
+        }
+
+        // Caminho anterior de MongoStore::saveGameState (builder stream).
+        bsoncxx::document::value encodeStateByHand(const GameState& state) {
+            using namespace bsoncxx::builder::stream;
+
+            array inv;
+            for (const auto& t : state.investigatedTargets) inv << t;
+            array bp;
+            for (const auto& t : state.breakpointedTargets) bp << t;
+            array players;
+            for (const auto& p : state.playerIds) players << p;
+            array turns;
+            for (const auto& p : state.turnOrder) turns << p;
+
+            array clues;
+            for (const auto& clue : state.discoveredClues) {
+                document notes;
+                for (const auto& [player, note] : clue.playerNotes) notes << player << note;
+                clues << open_document
+                    << "id" << clue.id
+                    << "targetId" << clue.targetId
+                    << "targetType" << static_cast<int>(clue.targetType)
+                    << "type" << static_cast<int>(clue.type)
+                    << "content" << clue.content
+                    << "discoveredBy" << clue.discoveredBy
+                    << "playerNotes" << notes
+                    << close_document;
+            }
+
+            return document{}
+                << "currentCaseId" << state.currentCaseId
+                << "currentDay" << state.currentDay
+                << "remainingPoints" << state.remainingPoints
+                << "isCompleted" << state.isCompleted
+                << "isSuddenDeath" << state.isSuddenDeath
+                << "playerIds" << players
+                << "hostPlayerId" << state.hostPlayerId
+                << "currentTurnIndex" << state.currentTurnIndex
+                << "turnOrder" << turns
+                << "turnStartTime" << bsoncxx::types::b_date(state.turnStartTime)
+                << "discoveredClues" << clues
+                << "investigatedTargets" << inv
+                << "breakpointedTargets" << bp
+                << "lastActivity" << bsoncxx::types::b_date(state.lastActivity)
+                << finalize;
+        }
+
+        std::vector<BenchResult> benchCodec(const BenchConfig& config) {
+            auto bugCase = makeSyntheticCase("bench_case", {});
+            auto state = makeSampleState(bugCase);
+            const size_t iterations = std::max<size_t>(config.iterations / 20, 1);
+
+            std::vector<BenchResult> results;
+            std::string out;
+
+            auto byHand = measure("json-clues-manual", iterations, [&](size_t) {
+                out.clear();
+                writeCluesByHand(out, state.discoveredClues);
+                return out.size();
+            });
+            byHand.detail = std::format("{} pistas, {} bytes", state.discoveredClues.size(), out.size());
+            results.push_back(std::move(byHand));
+
+            results.push_back(measure("json-clues-wvalue", iterations, [&](size_t) {
+                return writeCluesWithWvalue(state.discoveredClues).size();
+            }));
+
+            auto codecClues = measure("json-clues-codec", iterations, [&](size_t) {
+                out.clear();
+                Json::write(out, state.discoveredClues);
+                return out.size();
+            });
+            codecClues.detail = std::format("{} bytes (inclui targetType/discoveredBy)", out.size());
+            results.push_back(std::move(codecClues));
+
+            auto codecState = measure("json-state-codec", iterations, [&](size_t) {
+                out.clear();
+                Json::write(out, state);
+                return out.size();
+            });
+            codecState.detail = std::format("{} bytes", out.size());
+            results.push_back(std::move(codecState));
+
+            std::string stateJson = Json::toString(state, 4096);
+            results.push_back(measure("json-state-codec-read", iterations, [&](size_t) {
+                auto parsed = crow::json::load(stateJson);
+                GameState decoded;
+                Json::read(parsed, decoded);
+                return decoded.discoveredClues.size();
+            }));
+
+            results.push_back(measure("bson-state-manual", iterations, [&](size_t) {
+                return encodeStateByHand(state).view().length();
+            }));
+
+            results.push_back(measure("bson-state-codec", iterations, [&](size_t) {
+                return Bson::toDocument(state).view().length();
+            }));
+
+            auto stored = Bson::toDocument(state);
+            results.push_back(measure("bson-state-codec-read", iterations, [&](size_t) {
+                GameState decoded;
+                Bson::readFields(stored.view(), decoded);
+                return decoded.discoveredClues.size();
+            }));
+
+            return results;
+        }
+
+        // ---- Mensagens de saida ----
+
+        // Caminho anterior de Json::appendEscaped: um byte por vez.
+        void escapeScalar(std::string& out, std::string_view s) {
+            static constexpr char hex[] = "0123456789abcdef";
+            size_t runStart = 0;
+            for (size_t i = 0; i < s.size(); ++i) {
+                unsigned char c = static_cast<unsigned char>(s[i]);
+                if (c >= 0x20 && c != '"' && c != '\\') continue;
+                out.append(s.data() + runStart, i - runStart);
+                runStart = i + 1;
+                switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += hex[(c >> 4) & 0xf];
+                    out += hex[c & 0xf];
+                }
+            }
+            out.append(s.data() + runStart, s.size() - runStart);
+        }
+
+        // Caminho anterior de CLUE_REVEALED: std::format com uma string temporaria por campo escapado.
+        std::string clueRevealedWithFormat(const Clue& clue, int duration, const std::string& investigator) {
+            std::string content;
+            Json::appendEscaped(content, clue.content);
+            return std::format(
+                "{{\"type\":\"CLUE_REVEALED\",\"clueId\":\"{}\",\"content\":\"{}\",\"duration\":{},\"investigator\":\"{}\"}}",
+                clue.id, content, duration, investigator);
+        }
+
+        LobbyInfo makeSampleLobby(const GameState& state) {
+            LobbyInfo lobby;
+            lobby.sessionId = "BENCH1";
+            lobby.players.push_back({ .name = "Mestre", .role = PlayerRole::Master });
+            for (const auto& p : state.playerIds) {
+                lobby.players.push_back({ .name = p, .role = p == state.hostPlayerId ? PlayerRole::Host : PlayerRole::Player });
+            }
+            return lobby;
+        }
+
+        InvestigationCoverage makeSampleTotals() {
+            InvestigationCoverage totals;
+            totals.targets.fill(8);
+            totals.clues.fill(4);
+            return totals;
+        }
+
+        const std::vector<std::string> kSampleAnswers = { "mod0_fn0", "acho que e ponteiro \"nulo\"", "validar a entrada antes de usar" };
+
+        ValidationResult makeSampleReview() {
+            ValidationResult review;
+            review.confidencePerQuestion = { 1.0, 0.72, 0.4 };
+            review.conceptsPerQuestion = {
+                { { "mod0_fn0" }, {} },
+                { { "ponteiro", "nulo" }, {} },
+                { { "validar" }, { "entrada" } },
+            };
+            return review;
+        }
+
+        std::vector<BenchResult> benchMessages(const BenchConfig& config) {
+            auto bugCase = makeSyntheticCase("bench_case", {});
+            auto state = makeSampleState(bugCase);
+            const size_t iterations = std::max<size_t>(config.iterations / 20, 1);
+
+            std::vector<BenchResult> results;
+            std::string out;
+
+            // Textos que vao para a rede: conteudo de pistas (longo, quase sem escapes) e notas com aspas.
+            std::vector<std::string> texts;
+            size_t bytes = 0;
+            for (const auto& dc : state.discoveredClues) {
+                texts.push_back(dc.content);
+                for (const auto& [player, note] : dc.playerNotes) texts.push_back(note);
+            }
+            for (const auto& t : texts) bytes += t.size();
+            const size_t avgBytes = texts.empty() ? 0 : bytes / texts.size();
+
+            auto scalar = measure("escape-scalar", config.iterations, [&](size_t i) {
+                out.clear();
+                escapeScalar(out, texts[i % texts.size()]);
+                return out.size();
+            });
+            scalar.detail = std::format("~{} bytes/texto", avgBytes);
+            results.push_back(std::move(scalar));
+
+            auto swar = measure("escape-swar", config.iterations, [&](size_t i) {
+                out.clear();
+                Json::appendEscaped(out, texts[i % texts.size()]);
+                return out.size();
+            });
+            swar.detail = std::format("~{} bytes/texto", avgBytes);
+            results.push_back(std::move(swar));
+
+            auto lobby = makeSampleLobby(state);
+            auto lobbyUpdate = measure("lobby-update", config.iterations, [&](size_t) {
+                out.clear();
+                Json::Writer w(out);
+                Protocol::writeLobbyUpdate(w, lobby);
+                return out.size();
+            });
+            lobbyUpdate.detail = std::format("{} jogadores, {} bytes", lobby.players.size(), out.size());
+            results.push_back(std::move(lobbyUpdate));
+
+            auto totals = makeSampleTotals();
+            auto snapshot = measure("game-state-update", iterations, [&](size_t i) {
+                out.clear();
+                Json::Writer w(out);
+                Protocol::writeGameSnapshot(w, state, i, totals);
+                return out.size();
+            });
+            snapshot.detail = std::format("{} pistas, {} bytes", state.discoveredClues.size(), out.size());
+            results.push_back(std::move(snapshot));
+
+            auto review = makeSampleReview();
+            auto solution = measure("solution-for-review", config.iterations, [&](size_t) {
+                out.clear();
+                Json::Writer w(out);
+                Protocol::writeSolutionForReview(w, state.sessionId, kSampleAnswers, bugCase, review);
+                return out.size();
+            });
+            solution.detail = std::format("{} bytes", out.size());
+            results.push_back(std::move(solution));
+
+            const Clue& clue = bugCase.availableClues.front();
+            results.push_back(measure("clue-revealed-format", config.iterations, [&](size_t) {
+                return clueRevealedWithFormat(clue, 30, state.playerIds[1]).size();
+            }));
+
+            auto revealed = measure("clue-revealed-writer", config.iterations, [&](size_t) {
+                out.clear();
+                Json::Writer w(out);
+                Protocol::writeClueRevealed(w, clue, 30, state.playerIds[1]);
+                return out.size();
+            });
+            revealed.detail = std::format("{} bytes, buffer reutilizado", out.size());
+            results.push_back(std::move(revealed));
+
+            return results;
+        }
+
+        // ---- Decodificacao de comandos ----
+
+        // Caminho anterior de handleWebSocketMessage: arvore do crow, cadeia de comparacoes e copia de cada campo.
+        size_t decodeWithTree(const std::string& data) {
+            static const std::array<const char*, 9> earlierTypes = {
+                "CREATE_LOBBY", "JOIN_AS_PLAYER", "JOIN_AS_MASTER", "GET_LOBBY_INFO", "START_GAME",
+                "CREATE_TOURNAMENT", "SPECTATE_TOURNAMENT", "SUBMIT_SOLUTION", "VALIDATE_SOLUTION"
+            };
+            auto msg = crow::json::load(data);
+            if (!msg || !msg.has("type")) return 0;
+            std::string type = msg["type"].s();
+            for (const char* t : earlierTypes) {
+                if (type == t) return 0;
+            }
+
+            if (type == "GAME_ACTION") {
+                if (!msg.has("sessionId") || !msg.has("playerId") || !msg.has("actionType") || !msg.has("targetId")) return 0;
+                std::string sessionId = msg["sessionId"].s();
+                std::string playerId = msg["playerId"].s();
+                std::string targetId = msg["targetId"].s();
+                return sessionId.size() + playerId.size() + targetId.size() + static_cast<size_t>(msg["actionType"].i());
+            }
+            if (type == "SAVE_NOTE") {
+                if (!msg.has("sessionId") || !msg.has("playerId") || !msg.has("clueId") || !msg.has("content")) return 0;
+                std::string sessionId = msg["sessionId"].s();
+                std::string playerId = msg["playerId"].s();
+                std::string clueId = msg["clueId"].s();
+                std::string content = msg["content"].s();
+                return sessionId.size() + playerId.size() + clueId.size() + content.size();
+            }
+            if (type == "EDIT_SHARED_NOTE") return 0;
+            if (type == "GAME_BATCH") {
+                std::vector<Command> commands;
+                for (const auto& c : msg["commands"]) {
+                    if (!c.has("kind") || !c.has("playerId")) continue;
+                    Command cmd;
+                    cmd.playerId = c["playerId"].s();
+                    std::string kind = c["kind"].s();
+                    if (kind == "GAME_ACTION" && c.has("actionType") && c.has("targetId")) {
+                        cmd.actionType = static_cast<ActionType>(c["actionType"].i());
+                        cmd.targetId = c["targetId"].s();
+                    }
+                    else {
+                        continue;
+                    }
+                    commands.push_back(std::move(cmd));
+                }
+                std::string sessionId = msg["sessionId"].s();
+                return sessionId.size() + commands.size();
+            }
+            return 0;
+        }
+
+        // Object: Json::Object ou MsgPack::Object.
+        template <typename Object = Json::Object>
+        size_t decodeOnDemand(const std::string& data) {
+            using namespace Protocol;
+            auto frame = Object::parse(data);
+            if (!frame) return 0;
+            switch (commandTypeOf(*frame)) {
+            case CommandType::GameAction: {
+                GameActionCommand cmd;
+                if (decode(*frame, cmd) != DecodeStatus::Ok) return 0;
+                return cmd.sessionId.size() + cmd.playerId.size() + cmd.targetId.size() + static_cast<size_t>(cmd.actionType);
+            }
+            case CommandType::SaveNote: {
+                SaveNoteCommand cmd;
+                if (decode(*frame, cmd) != DecodeStatus::Ok) return 0;
+                return cmd.sessionId.size() + cmd.playerId.size() + cmd.clueId.size() + cmd.content.size();
+            }
+            case CommandType::GameBatch: {
+                GameBatchCommand cmd;
+                if (decode(*frame, cmd) != DecodeStatus::Ok) return 0;
+                return cmd.sessionId.size() + cmd.commands.size();
+            }
+            default:
+                return 0;
+            }
+        }
+
+        std::vector<std::pair<const char*, std::string>> commandFrames() {
+            std::string batch = R"({"type":"GAME_BATCH","sessionId":"AB12CD","commands":[)";
+            for (int i = 0; i < 8; ++i) {
+                if (i > 0) batch += ',';
+                batch += std::format(R"({{"kind":"GAME_ACTION","playerId":"Bruno","actionType":2,"targetId":"mod{}_fn0"}})", i);
+            }
+            batch += "]}";
+
+            return {
+                { "game-action", R"({"type":"GAME_ACTION","sessionId":"AB12CD","playerId":"Bruno","actionType":2,"targetId":"mod0_fn0"})" },
+                { "save-note", R"({"type":"SAVE_NOTE","sessionId":"AB12CD","playerId":"Bruno","clueId":"clue_7","content":"Suspeito: \"parseConfig\" nao valida a entrada quando o buffer chega vazio."})" },
+                { "game-batch", batch },
+            };
+        }
+
+        std::vector<BenchResult> benchDecode(const BenchConfig& config) {
+            std::vector<BenchResult> results;
+            for (const auto& [name, frame] : commandFrames()) {
+                if (decodeWithTree(frame) != decodeOnDemand(frame)) {
+                    BenchResult mismatch;
+                    mismatch.name = std::string("decode-") + name;
+                    mismatch.detail = "ERRO: caminhos divergem";
+                    results.push_back(std::move(mismatch));
+                    continue;
+                }
+
+                auto tree = measure(std::string("decode-tree-") + name, config.iterations, [&](size_t) {
+                    return decodeWithTree(frame);
+                });
+                tree.detail = std::format("{} bytes", frame.size());
+                results.push_back(std::move(tree));
+
+                auto onDemand = measure(std::string("decode-scan-") + name, config.iterations, [&](size_t) {
+                    return decodeOnDemand(frame);
+                });
+                onDemand.detail = std::format("{} bytes", frame.size());
+                results.push_back(std::move(onDemand));
+            }
+            return results;
+        }
+
+        // ---- Formato na rede: JSON x MessagePack ----
+
+        // Reescreve um valor JSON em outro formato, campo a campo (frames de comando de clientes binarios).
+        template <typename Writer>
+        void transcode(Writer& w, const Json::Value& v) {
+            switch (v.kind()) {
+            case Json::Kind::Null: w.null(); break;
+            case Json::Kind::Bool: { bool b = false; v.toBool(b); w.boolean(b); break; }
+            case Json::Kind::Number: { long long n = 0; v.toInt(n); w.integer(n); break; }
+            case Json::Kind::String: { std::string text; v.toString(text); w.string(text); break; }
+            case Json::Kind::Array:
+                w.beginArray();
+                v.forEachElement([&](const Json::Value& item) { transcode(w, item); });
+                w.endArray();
+                break;
+            case Json::Kind::Object:
+                w.beginObject();
+                v.forEachMember([&](std::string_view key, const Json::Value& item) {
+                    w.key(key);
+                    transcode(w, item);
+                });
+                w.endObject();
+                break;
+            }
+        }
+
+        // Mesma mensagem nos dois formatos: tempo de montagem e tamanho do frame.
+        template <typename Build>
+        void compareEncodings(std::vector<BenchResult>& results, const std::string& name, size_t iterations, Build&& build) {
+            std::string json;
+            auto jsonResult = measure("wire-json-" + name, iterations, [&](size_t i) {
+                json.clear();
+                Json::Writer w(json);
+                build(w, i);
+                return json.size();
+            });
+            jsonResult.detail = std::format("{} bytes", json.size());
+            results.push_back(std::move(jsonResult));
+
+            std::string packed;
+            auto packedResult = measure("wire-msgpack-" + name, iterations, [&](size_t i) {
+                packed.clear();
+                MsgPack::Writer w(packed);
+                build(w, i);
+                return packed.size();
+            });
+            packedResult.detail = std::format("{} bytes ({}% do JSON)", packed.size(), packed.size() * 100 / std::max<size_t>(json.size(), 1));
+            results.push_back(std::move(packedResult));
+        }
+
+        std::vector<BenchResult> benchWire(const BenchConfig& config) {
+            auto bugCase = makeSyntheticCase("bench_case", {});
+            auto state = makeSampleState(bugCase);
+            auto lobby = makeSampleLobby(state);
+            auto totals = makeSampleTotals();
+            auto review = makeSampleReview();
+            const size_t iterations = std::max<size_t>(config.iterations / 20, 1);
+
+            std::vector<BenchResult> results;
+            compareEncodings(results, "lobby-update", config.iterations, [&](auto& w, size_t) {
+                Protocol::writeLobbyUpdate(w, lobby);
+            });
+            compareEncodings(results, "game-state-update", iterations, [&](auto& w, size_t i) {
+                Protocol::writeGameSnapshot(w, state, i, totals);
+            });
+            compareEncodings(results, "solution-for-review", config.iterations, [&](auto& w, size_t) {
+                Protocol::writeSolutionForReview(w, state.sessionId, kSampleAnswers, bugCase, review);
+            });
+
+            for (const auto& [name, json] : commandFrames()) {
+                std::string packed;
+                MsgPack::Writer w(packed);
+                transcode(w, *Json::Value::parse(json));
+
+                if (decodeOnDemand<Json::Object>(json) != decodeOnDemand<MsgPack::Object>(packed)) {
+                    BenchResult mismatch;
+                    mismatch.name = std::string("wire-decode-") + name;
+                    mismatch.detail = "ERRO: formatos divergem";
+                    results.push_back(std::move(mismatch));
+                    continue;
+                }
+
+                auto jsonResult = measure(std::string("wire-json-decode-") + name, config.iterations, [&](size_t) {
+                    return decodeOnDemand<Json::Object>(json);
+                });
+                jsonResult.detail = std::format("{} bytes", json.size());
+                results.push_back(std::move(jsonResult));
+
+                auto packedResult = measure(std::string("wire-msgpack-decode-") + name, config.iterations, [&](size_t) {
+                    return decodeOnDemand<MsgPack::Object>(packed);
+                });
+                packedResult.detail = std::format("{} bytes", packed.size());
+                results.push_back(std::move(packedResult));
+            }
+            return results;
+        }
+    }
+
+    std::vector<BenchResult> runBench(const std::string& name, const BenchConfig& config) {
+        if (name == "match") return benchMatch(config);
+        if (name == "normalize") return benchNormalize(config);
+        if (name == "codec") return benchCodec(config);
+        if (name == "messages") return benchMessages(config);
+        if (name == "decode") return benchDecode(config);
+        if (name == "wire") return benchWire(config);
+        return {};
+    }
+
+    std::vector<std::string> benchNames() {
+        return { "match", "normalize", "codec", "messages", "decode", "wire" };
+    }
+}
\ No newline at end of file
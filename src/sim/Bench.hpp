@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace FindTheBug::Sim {
+
+    struct BenchConfig {
+        size_t iterations{ 200000 };
+        uint64_t seed{ 42 };
+    };
+
+    struct BenchResult {
+        std::string name;
+        size_t iterations{ 0 };
+        double nsPerOp{ 0 };
+        std::string detail;
+    };
+
+    // Microbenchmarks isolados do motor, sem sessoes nem armazenamento.
+    // Retorna vazio se o nome nao for conhecido.
+    std::vector<BenchResult> runBench(const std::string& name, const BenchConfig& config);
+
+    std::vector<std::string> benchNames();
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "CaseFixture.hpp"
+#include <format>
+
+namespace FindTheBug::Sim {
+
+    BugCase makeSyntheticCase(const std::string& caseId, const FixtureShape& shape) {
+        BugCase bc;
+        bc.id = caseId;
+        bc.title = "Caso Sintetico";
+        bc.description = "Caso gerado pelo simulador para medicao de carga.";
+        bc.solutionQuestions = { "Qual funcao contem o bug?", "Qual a causa raiz?", "Como corrigir?" };
+        bc.correctAnswers = { "mod0_fn0", "ponteiro nulo", "validar entrada" };
+        bc.answerConcepts = {
+            { { "mod0_fn0", { "mod0_fn0" } } },
+            { { "ponteiro", { "ponteiro", "pointer" } }, { "nulo", { "nulo", "null", "nullptr" } } },
+            { { "validacao", { "validar", "validacao", "checar" } }, { "entrada", { "entrada", "input", "parametro" } } },
+        };
+
+        for (size_t m = 0; m < shape.modules; ++m) {
+            std::string moduleName = std::format("mod{}", m);
+            bc.systemTopology.modules.push_back({ .name = moduleName });
+
+            bc.availableClues.push_back({
+                .id = moduleName + "_doc", .targetId = moduleName, .targetType = TargetType::Module,
+                .type = ClueType::Documentation, .content = "Documentacao de " + moduleName, .cost = 1 });
+            bc.availableClues.push_back({
+                .id = moduleName + "_log", .targetId = moduleName, .targetType = TargetType::Module,
+                .type = ClueType::Log, .content = "Log de " + moduleName, .cost = 1 });
+
+            for (size_t f = 0; f < shape.functionsPerModule; ++f) {
+                std::string fnName = std::format("{}_fn{}", moduleName, f);
+                bc.systemTopology.functions.push_back({ .name = fnName, .parentId = moduleName });
+
+                // Metade das funcoes nao revela nada, para exercitar o caminho sem pista.
+                if (f % 2 != 0) continue;
+
+                bc.availableClues.push_back({
+                    .id = fnName + "_code", .targetId = fnName, .targetType = TargetType::Function,
+                    .type = ClueType::Code, .content = "Codigo de " + fnName, .cost = 2 });
+                bc.availableClues.push_back({
+                    .id = fnName + "_bp", .targetId = fnName, .targetType = TargetType::Function,
+                    .type = ClueType::Breakpoint, .content = "Breakpoint em " + fnName, .cost = 2 });
+                bc.availableClues.push_back({
+                    .id = fnName + "_unit", .targetId = fnName, .targetType = TargetType::Function,
+                    .type = ClueType::UnitTestResult, .content = "Teste unitario de " + fnName, .cost = 2 });
+            }
+
+            if (m + 1 < shape.modules) {
+                std::string connId = std::format("conn{}_{}", m, m + 1);
+                bc.systemTopology.connections.push_back({
+                    .id = connId, .from = moduleName, .to = std::format("mod{}", m + 1) });
+                bc.availableClues.push_back({
+                    .id = connId + "_it", .targetId = connId, .targetType = TargetType::Connection,
+                    .type = ClueType::IntegrationTestResult, .content = "Integracao " + connId, .cost = 3 });
+            }
+        }
+
+        return bc;
+    }
+
+    std::vector<std::string> targetsFor(const BugCase& bugCase, ActionType actionType) {
+        std::vector<std::string> targets;
+        const auto& topo = bugCase.systemTopology;
+
+        switch (actionType) {
+        case ActionType::ReadDocumentation:
+        case ActionType::InsertLog:
+            for (const auto& m : topo.modules) targets.push_back(m.name);
+            break;
+        case ActionType::InvestigateFunction:
+        case ActionType::SetBreakpoint:
+        case ActionType::RunUnitTests:
+            for (const auto& f : topo.functions) targets.push_back(f.name);
+            break;
+        case ActionType::RunIntegrationTests:
+            for (const auto& c : topo.connections) targets.push_back(c.id);
+            break;
+        default:
+            break;
+        }
+        return targets;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../shared/DTOs.hpp"
+#include <string>
+#include <vector>
+
+namespace FindTheBug::Sim {
+
+    struct FixtureShape {
+        size_t modules{ 8 };
+        size_t functionsPerModule{ 6 };
+    };
+
+    // Caso sintetico com topologia e pistas para cada tipo de acao.
+    BugCase makeSyntheticCase(const std::string& caseId, const FixtureShape& shape);
+
+    std::vector<std::string> targetsFor(const BugCase& bugCase, ActionType actionType);
+}
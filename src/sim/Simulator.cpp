@@ -0,0 +1,335 @@
+#include "Simulator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <print>
+#include <random>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace FindTheBug::Sim {
+
+    namespace {
+
+        constexpr size_t kOperationCount = static_cast<size_t>(Operation::Count);
+
+        constexpr std::array<ActionType, 6> kInvestigationActions = {
+            ActionType::ReadDocumentation,
+            ActionType::InsertLog,
+            ActionType::InvestigateFunction,
+            ActionType::SetBreakpoint,
+            ActionType::RunUnitTests,
+            ActionType::RunIntegrationTests
+        };
+
+        long long currentRssBytes() {
+#if defined(__linux__)
+            std::ifstream statm("/proc/self/statm");
+            long long pages = 0;
+            long long resident = 0;
+            if (statm >> pages >> resident) {
+                return resident * static_cast<long long>(sysconf(_SC_PAGESIZE));
+            }
+#endif
+            return 0;
+        }
+
+        struct Bot {
+            std::string sessionId;
+            std::vector<std::string> participants;
+            GameState state;
+            std::vector<std::string> clues;
+            size_t cursor{ 0 };
+        };
+
+        struct ThreadStats {
+            std::array<std::vector<uint64_t>, kOperationCount> samples;
+            std::array<size_t, kOperationCount> failures{};
+            size_t gamesFinished{ 0 };
+        };
+
+        LatencySummary summarize(std::vector<uint64_t>& samplesNs, size_t failures) {
+            LatencySummary s;
+            s.calls = samplesNs.size();
+            s.failures = failures;
+            if (samplesNs.empty()) return s;
+
+            std::sort(samplesNs.begin(), samplesNs.end());
+            auto at = [&](double q) {
+                size_t idx = std::min(samplesNs.size() - 1, static_cast<size_t>(q * samplesNs.size()));
+                return samplesNs[idx] / 1000.0;
+            };
+            s.p50Us = at(0.50);
+            s.p90Us = at(0.90);
+            s.p99Us = at(0.99);
+            s.p999Us = at(0.999);
+            s.maxUs = samplesNs.back() / 1000.0;
+            return s;
+        }
+    }
+
+    const char* operationName(Operation op) {
+        switch (op) {
+        case Operation::ProcessAction:   return "processAction";
+        case Operation::ProcessActions:  return "processActions";
+        case Operation::SavePlayerNote:  return "savePlayerNote";
+        case Operation::FinalizeSession: return "finalizeSession";
+        default:                         return "?";
+        }
+    }
+
+    class Simulator::Impl {
+    public:
+        SimConfig config;
+        std::shared_ptr<GameStore> storage;
+        BugCase bugCase;
+        SessionPreparer prepareSession;
+        std::unique_ptr<GameEngine> engine;
+
+        std::array<std::vector<std::string>, 8> targetsByAction;
+        std::vector<std::pair<ActionType, std::string>> script;
+        std::vector<Bot> bots;
+
+        template <typename F>
+        auto timed(ThreadStats& stats, Operation op, F&& fn) {
+            auto start = std::chrono::steady_clock::now();
+            auto result = fn();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            stats.samples[static_cast<size_t>(op)].push_back(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            return result;
+        }
+
+        void buildTargets() {
+            for (auto action : kInvestigationActions) {
+                auto targets = targetsFor(bugCase, action);
+                for (const auto& t : targets) script.emplace_back(action, t);
+                targetsByAction[static_cast<size_t>(action)] = std::move(targets);
+            }
+        }
+
+        bool startGame(Bot& bot) {
+            const auto& host = bot.participants.front();
+            const auto& master = bot.participants.back();
+            if (!engine->initializeGameFromLobby(bot.sessionId, config.caseId, bot.participants, host, master)) {
+                return false;
+            }
+            auto stateOpt = storage->getGameState(bot.sessionId);
+            if (!stateOpt) return false;
+            bot.state = std::move(*stateOpt);
+            bot.clues.clear();
+            return true;
+        }
+
+        std::pair<ActionType, std::string> nextAction(Bot& bot, std::mt19937_64& rng) {
+            if (config.mode == BotMode::Scripted && !script.empty()) {
+                return script[bot.cursor++ % script.size()];
+            }
+
+            for (;;) {
+                auto action = kInvestigationActions[rng() % kInvestigationActions.size()];
+                const auto& targets = targetsByAction[static_cast<size_t>(action)];
+                if (targets.empty()) continue;
+                return { action, targets[rng() % targets.size()] };
+            }
+        }
+
+        void rememberClue(Bot& bot, const std::optional<Clue>& clue) {
+            if (!clue) return;
+            if (std::find(bot.clues.begin(), bot.clues.end(), clue->id) == bot.clues.end()) {
+                bot.clues.push_back(clue->id);
+            }
+        }
+
+        void finalize(Bot& bot, bool approved, ThreadStats& stats) {
+            auto result = timed(stats, Operation::FinalizeSession, [&] {
+                return engine->finalizeSession(bot.sessionId, approved);
+            });
+
+            if (result.outcome != GameResult::Running) {
+                stats.gamesFinished++;
+                if (!startGame(bot)) stats.failures[static_cast<size_t>(Operation::FinalizeSession)]++;
+                return;
+            }
+
+            if (result.newState) bot.state = std::move(*result.newState);
+        }
+
+        void step(Bot& bot, std::mt19937_64& rng, ThreadStats& stats) {
+            if (bot.state.isSuddenDeath) {
+                finalize(bot, rng() % 2 == 0, stats);
+                return;
+            }
+
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+            if (!bot.clues.empty() && unit(rng) < config.noteRatio) {
+                const auto& player = bot.state.turnOrder[rng() % bot.state.turnOrder.size()];
+                const auto& clueId = bot.clues[rng() % bot.clues.size()];
+                std::string content = (rng() % 4 == 0) ? std::string() : std::format("nota {} de {}", bot.cursor, player);
+
+                bool ok = timed(stats, Operation::SavePlayerNote, [&] {
+                    return engine->savePlayerNote(bot.sessionId, player, clueId, content).success;
+                });
+                if (!ok) stats.failures[static_cast<size_t>(Operation::SavePlayerNote)]++;
+                return;
+            }
+
+            if (config.batchSize > 1) {
+                std::vector<Command> commands;
+                commands.reserve(config.batchSize);
+                for (size_t i = 0; i < config.batchSize; ++i) {
+                    auto [action, target] = nextAction(bot, rng);
+                    size_t turn = (bot.state.currentTurnIndex + i) % bot.state.turnOrder.size();
+                    commands.push_back({
+                        .kind = CommandKind::GameAction,
+                        .playerId = bot.state.turnOrder[turn],
+                        .actionType = action,
+                        .targetId = std::move(target)
+                    });
+                }
+
+                auto batch = timed(stats, Operation::ProcessActions, [&] {
+                    return engine->processActions(bot.sessionId, commands);
+                });
+                if (!batch.success) {
+                    stats.failures[static_cast<size_t>(Operation::ProcessActions)]++;
+                    return;
+                }
+                for (const auto& r : batch.results) rememberClue(bot, r.revealedClue);
+                bot.state = std::move(batch.newState);
+                return;
+            }
+
+            auto [action, target] = nextAction(bot, rng);
+            std::string player = bot.state.turnOrder[bot.state.currentTurnIndex];
+
+            auto result = timed(stats, Operation::ProcessAction, [&] {
+                return engine->processAction(player, action, target, bot.sessionId);
+            });
+
+            if (!result.success) {
+                stats.failures[static_cast<size_t>(Operation::ProcessAction)]++;
+            }
+            rememberClue(bot, result.revealedClue);
+            if (!result.newState.sessionId.empty()) {
+                bot.state = std::move(result.newState);
+            }
+        }
+
+        template <typename F>
+        void forEachSlice(F&& fn) {
+            size_t threadCount = std::max<size_t>(1, std::min(config.threads, bots.size()));
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (size_t t = 0; t < threadCount; ++t) {
+                size_t begin = bots.size() * t / threadCount;
+                size_t end = bots.size() * (t + 1) / threadCount;
+                threads.emplace_back([&fn, t, begin, end] { fn(t, begin, end); });
+            }
+            for (auto& th : threads) th.join();
+        }
+    };
+
+    Simulator::Simulator(SimConfig config, std::shared_ptr<GameStore> storage, BugCase bugCase, SessionPreparer prepareSession)
+        : pImpl(std::make_unique<Impl>()) {
+        pImpl->config = std::move(config);
+        pImpl->storage = std::move(storage);
+        pImpl->bugCase = std::move(bugCase);
+        pImpl->prepareSession = std::move(prepareSession);
+        pImpl->engine = std::make_unique<GameEngine>(pImpl->storage);
+        pImpl->buildTargets();
+    }
+
+    Simulator::~Simulator() = default;
+
+    SimReport Simulator::run() {
+        auto& impl = *pImpl;
+        const auto& config = impl.config;
+        SimReport report;
+
+        report.rssBaselineBytes = currentRssBytes();
+
+        impl.bots.resize(config.sessions);
+        for (size_t i = 0; i < config.sessions; ++i) {
+            auto& bot = impl.bots[i];
+            bot.sessionId = std::format("SIM{:06}", i);
+            for (size_t p = 0; p < std::max<size_t>(2, config.playersPerSession); ++p) {
+                bot.participants.push_back(std::format("bot{}", p));
+            }
+            bot.participants.push_back("master");
+            bot.cursor = i;
+        }
+
+        std::atomic<size_t> setupFailures{ 0 };
+        impl.forEachSlice([&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& bot = impl.bots[i];
+                if (impl.prepareSession && !impl.prepareSession(bot.sessionId, bot.participants.front())) {
+                    setupFailures++;
+                    continue;
+                }
+                if (!impl.startGame(bot)) setupFailures++;
+            }
+        });
+
+        if (setupFailures > 0) {
+            std::print(stderr, "[SIM] {} sessoes falharam na inicializacao.\n", setupFailures.load());
+        }
+
+        report.rssAfterSetupBytes = currentRssBytes();
+
+        size_t threadCount = std::max<size_t>(1, std::min(config.threads, impl.bots.size()));
+        std::vector<ThreadStats> stats(threadCount);
+
+        auto start = std::chrono::steady_clock::now();
+
+        impl.forEachSlice([&](size_t t, size_t begin, size_t end) {
+            std::mt19937_64 rng(config.seed + t);
+            auto& local = stats[t];
+
+            for (size_t s = 0; s < config.stepsPerSession; ++s) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (impl.bots[i].state.turnOrder.empty()) continue;
+                    impl.step(impl.bots[i], rng, local);
+                }
+            }
+
+            for (size_t i = begin; i < end; ++i) {
+                if (impl.bots[i].state.turnOrder.empty()) continue;
+                impl.finalize(impl.bots[i], true, local);
+            }
+        });
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        report.wallSeconds = std::chrono::duration<double>(elapsed).count();
+        report.rssAfterRunBytes = currentRssBytes();
+
+        for (size_t op = 0; op < kOperationCount; ++op) {
+            std::vector<uint64_t> merged;
+            size_t failures = 0;
+            for (auto& local : stats) {
+                merged.insert(merged.end(), local.samples[op].begin(), local.samples[op].end());
+                failures += local.failures[op];
+            }
+            report.operations[op] = summarize(merged, failures);
+            report.totalCalls += report.operations[op].calls;
+        }
+
+        for (const auto& local : stats) report.gamesFinished += local.gamesFinished;
+
+        if (report.wallSeconds > 0) {
+            report.callsPerSecond = report.totalCalls / report.wallSeconds;
+        }
+        if (config.sessions > 0 && report.rssAfterRunBytes > 0) {
+            report.bytesPerSession = static_cast<double>(report.rssAfterRunBytes - report.rssBaselineBytes) / config.sessions;
+        }
+
+        return report;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../engine/GameEngine.hpp"
+#include "../storage/GameStore.hpp"
+#include "CaseFixture.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FindTheBug::Sim {
+
+    enum class BotMode {
+        Random,
+        Scripted
+    };
+
+    enum class Operation {
+        ProcessAction,
+        ProcessActions,
+        SavePlayerNote,
+        FinalizeSession,
+        Count
+    };
+
+    struct SimConfig {
+        size_t sessions{ 1000 };
+        size_t playersPerSession{ 4 };
+        size_t threads{ std::thread::hardware_concurrency() };
+        size_t stepsPerSession{ 200 };
+        size_t batchSize{ 0 };
+        double noteRatio{ 0.2 };
+        BotMode mode{ BotMode::Random };
+        uint64_t seed{ 42 };
+        std::string caseId{ "sim_case" };
+    };
+
+    struct LatencySummary {
+        size_t calls{ 0 };
+        size_t failures{ 0 };
+        double p50Us{ 0 };
+        double p90Us{ 0 };
+        double p99Us{ 0 };
+        double p999Us{ 0 };
+        double maxUs{ 0 };
+    };
+
+    struct SimReport {
+        double wallSeconds{ 0 };
+        size_t totalCalls{ 0 };
+        size_t gamesFinished{ 0 };
+        double callsPerSecond{ 0 };
+        long long rssBaselineBytes{ 0 };
+        long long rssAfterSetupBytes{ 0 };
+        long long rssAfterRunBytes{ 0 };
+        double bytesPerSession{ 0 };
+        std::array<LatencySummary, static_cast<size_t>(Operation::Count)> operations{};
+    };
+
+    const char* operationName(Operation op);
+
+    class Simulator {
+    public:
+        // prepareSession e chamado antes de initializeGameFromLobby (ex.: criar o documento de lobby no Mongo).
+        using SessionPreparer = std::function<bool(const std::string& sessionId, const std::string& hostName)>;
+
+        Simulator(SimConfig config, std::shared_ptr<GameStore> storage, BugCase bugCase, SessionPreparer prepareSession = {});
+        ~Simulator();
+
+        SimReport run();
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> pImpl;
+    };
+}
@@ -0,0 +1,218 @@
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <print>
+#include <string>
+
+#include "../storage/MemoryStore.hpp"
+#include "../storage/MongoStore.hpp"
+#include "Bench.hpp"
+#include "CaseFixture.hpp"
+#include "Simulator.hpp"
+
+using namespace FindTheBug;
+using namespace FindTheBug::Sim;
+
+namespace {
+
+    void printUsage() {
+        std::print(
+            "Uso: findthebug-sim [opcoes]\n"
+            "  --sessions N          sessoes simultaneas (padrao 1000)\n"
+            "  --players N           jogadores por sessao, sem contar o Mestre (padrao 4)\n"
+            "  --threads N           threads de bots (padrao: nucleos)\n"
+            "  --steps N             passos por sessao (padrao 200)\n"
+            "  --batch N             envia N acoes por chamada via processActions\n"
+            "  --notes R             fracao de passos que editam notas (padrao 0.2)\n"
+            "  --mode random|scripted\n"
+            "  --seed N\n"
+            "  --backend memory|mongo\n"
+            "  --mongo-uri URI       obrigatorio com --backend mongo\n"
+            "  --db NOME             banco usado com --backend mongo (padrao FindTheBugSim)\n"
+            "  --case ID             caso existente no banco (backend mongo)\n"
+            "  --json                imprime o relatorio em JSON\n"
+            "  --bench NOME          executa um microbenchmark ({}) em vez da simulacao\n"
+            "  --iterations N        iteracoes por microbenchmark (padrao 200000)\n",
+            [] {
+                std::string names;
+                for (const auto& n : benchNames()) names += (names.empty() ? "" : "|") + n;
+                return names;
+            }());
+    }
+
+    void printBench(const std::vector<BenchResult>& results, bool json) {
+        if (json) {
+            std::print("[");
+            for (size_t i = 0; i < results.size(); ++i) {
+                const auto& r = results[i];
+                std::print("{}{{\"name\":\"{}\",\"iterations\":{},\"nsPerOp\":{:.1f},\"detail\":\"{}\"}}",
+                    i > 0 ? "," : "", r.name, r.iterations, r.nsPerOp, r.detail);
+            }
+            std::print("]\n");
+            return;
+        }
+
+        std::print("{:<22} {:>12} {:>12}  {}\n", "benchmark", "iteracoes", "ns/op", "detalhe");
+        for (const auto& r : results) {
+            std::print("{:<22} {:>12} {:>12.1f}  {}\n", r.name, r.iterations, r.nsPerOp, r.detail);
+        }
+    }
+
+    void printReport(const SimConfig& config, const SimReport& report) {
+        std::print("[SIM] {} sessoes, {} threads, {} passos/sessao\n", config.sessions, config.threads, config.stepsPerSession);
+        std::print("[SIM] Tempo: {:.2f}s  Chamadas: {}  Throughput: {:.0f} chamadas/s  Jogos encerrados: {}\n",
+            report.wallSeconds, report.totalCalls, report.callsPerSecond, report.gamesFinished);
+
+        std::print("{:<16} {:>10} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+            "operacao", "chamadas", "falhas", "p50(us)", "p90(us)", "p99(us)", "p99.9(us)", "max(us)");
+        for (size_t op = 0; op < report.operations.size(); ++op) {
+            const auto& s = report.operations[op];
+            if (s.calls == 0) continue;
+            std::print("{:<16} {:>10} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                operationName(static_cast<Operation>(op)), s.calls, s.failures, s.p50Us, s.p90Us, s.p99Us, s.p999Us, s.maxUs);
+        }
+
+        if (report.rssAfterRunBytes > 0) {
+            std::print("[SIM] RSS: base {} KiB, apos setup {} KiB, apos execucao {} KiB, ~{:.0f} bytes/sessao\n",
+                report.rssBaselineBytes / 1024, report.rssAfterSetupBytes / 1024, report.rssAfterRunBytes / 1024,
+                report.bytesPerSession);
+        }
+        else {
+            std::print("[SIM] RSS indisponivel nesta plataforma.\n");
+        }
+    }
+
+    void printJson(const SimConfig& config, const SimReport& report) {
+        std::print("{{\"sessions\":{},\"threads\":{},\"steps\":{},\"wallSeconds\":{:.4f},\"totalCalls\":{},"
+            "\"callsPerSecond\":{:.1f},\"gamesFinished\":{},\"bytesPerSession\":{:.1f},\"operations\":{{",
+            config.sessions, config.threads, config.stepsPerSession, report.wallSeconds, report.totalCalls,
+            report.callsPerSecond, report.gamesFinished, report.bytesPerSession);
+
+        bool first = true;
+        for (size_t op = 0; op < report.operations.size(); ++op) {
+            const auto& s = report.operations[op];
+            if (!first) std::print(",");
+            std::print("\"{}\":{{\"calls\":{},\"failures\":{},\"p50Us\":{:.2f},\"p90Us\":{:.2f},\"p99Us\":{:.2f},\"p999Us\":{:.2f},\"maxUs\":{:.2f}}}",
+                operationName(static_cast<Operation>(op)), s.calls, s.failures, s.p50Us, s.p90Us, s.p99Us, s.p999Us, s.maxUs);
+            first = false;
+        }
+        std::print("}}}}\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SimConfig config;
+    std::string backend = "memory";
+    std::string mongoUri;
+    std::string dbName = "FindTheBugSim";
+    bool json = false;
+    std::string benchName;
+    BenchConfig benchConfig;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("valor ausente para " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--sessions") config.sessions = std::stoul(next());
+            else if (arg == "--players") config.playersPerSession = std::stoul(next());
+            else if (arg == "--threads") config.threads = std::stoul(next());
+            else if (arg == "--steps") config.stepsPerSession = std::stoul(next());
+            else if (arg == "--batch") config.batchSize = std::stoul(next());
+            else if (arg == "--notes") config.noteRatio = std::stod(next());
+            else if (arg == "--seed") config.seed = std::stoull(next());
+            else if (arg == "--mode") config.mode = (next() == "scripted") ? BotMode::Scripted : BotMode::Random;
+            else if (arg == "--backend") backend = next();
+            else if (arg == "--mongo-uri") mongoUri = next();
+            else if (arg == "--db") dbName = next();
+            else if (arg == "--case") config.caseId = next();
+            else if (arg == "--json") json = true;
+            else if (arg == "--bench") benchName = next();
+            else if (arg == "--iterations") benchConfig.iterations = std::stoul(next());
+            else {
+                printUsage();
+                return arg == "--help" ? 0 : -1;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::print(stderr, "[SIM] Argumento invalido: {}\n", e.what());
+        printUsage();
+        return -1;
+    }
+
+    if (config.threads == 0) config.threads = 1;
+
+    if (!benchName.empty()) {
+        benchConfig.seed = config.seed;
+        auto results = runBench(benchName, benchConfig);
+        if (results.empty()) {
+            std::print(stderr, "[SIM] Benchmark desconhecido: {}\n", benchName);
+            printUsage();
+            return -1;
+        }
+        printBench(results, json);
+        return 0;
+    }
+
+    try {
+        std::shared_ptr<GameStore> storage;
+        Simulator::SessionPreparer prepare;
+        BugCase bugCase;
+
+        if (backend == "memory") {
+            auto memory = std::make_shared<MemoryStore>();
+            bugCase = makeSyntheticCase(config.caseId, {});
+            memory->putCase(bugCase);
+            storage = memory;
+        }
+        else if (backend == "mongo") {
+            if (mongoUri.empty()) {
+                std::print(stderr, "[SIM] --mongo-uri e obrigatorio com --backend mongo.\n");
+                return -1;
+            }
+            auto mongo = std::make_shared<MongoStore>(mongoUri, dbName);
+            auto caseOpt = mongo->getCase(config.caseId);
+            if (!caseOpt) {
+                std::print(stderr, "[SIM] Caso {} nao encontrado no banco {}.\n", config.caseId, dbName);
+                return -1;
+            }
+            bugCase = std::move(*caseOpt);
+            prepare = [mongo](const std::string& sessionId, const std::string& hostName) {
+                mongo->deleteSession(sessionId);
+                PlayerInfo host;
+                host.name = hostName;
+                host.role = PlayerRole::Host;
+                host.joinedAt = std::chrono::system_clock::now();
+
+                LobbyInfo lobby;
+                lobby.sessionId = sessionId;
+                lobby.createdAt = host.joinedAt;
+                lobby.lastActivity = host.joinedAt;
+                lobby.players.push_back(host);
+                return mongo->createLobby(lobby);
+            };
+            storage = mongo;
+        }
+        else {
+            std::print(stderr, "[SIM] Backend desconhecido: {}\n", backend);
+            return -1;
+        }
+
+        Simulator simulator(config, storage, std::move(bugCase), std::move(prepare));
+        auto report = simulator.run();
+
+        if (json) printJson(config, report);
+        else printReport(config, report);
+    }
+    catch (const std::exception& e) {
+        std::print(stderr, "[CRASH] Simulador: {}\n", e.what());
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "ActionUpdate.hpp"
+
+#include <algorithm>
+#include <format>
+
+using namespace FindTheBug;
+
+int ActionUpdate::effectiveCost(const GameState& state) const {
+    switch (discountWhen) {
+    case CostDiscount::WhenInvestigated:
+        return state.investigatedTargets.contains(targetId) ? discountedCost : cost;
+    case CostDiscount::WhenBreakpointed:
+        return state.breakpointedTargets.contains(targetId) ? discountedCost : cost;
+    default:
+        return cost;
+    }
+}
+
+std::optional<std::string> ActionUpdate::rejectReason(const GameState& state) const {
+    bool isPlayerInGame = std::find(state.playerIds.begin(), state.playerIds.end(), playerId) != state.playerIds.end();
+    if (!isPlayerInGame && playerId != state.hostPlayerId) {
+        return "Erro: Jogador nao faz parte da sessao.";
+    }
+
+    if (playerId == state.masterPlayerId) {
+        return "O Mestre nao pode realizar acoes de investigacao.";
+    }
+
+    if (state.isSuddenDeath && actionType != ActionType::SubmitSolution) {
+        return "MODO MORTE SUBITA: Apenas submissao de solucao permitida!";
+    }
+
+    if (requiresTurn && !state.turnOrder.empty()) {
+        // Indice fora da faixa (estado antigo) conta como o ultimo jogador, igual ao pipeline do MongoStore.
+        size_t turn = std::min(static_cast<size_t>(std::max(0, state.currentTurnIndex)), state.turnOrder.size() - 1);
+        const std::string& currentPlayer = state.turnOrder[turn];
+        if (playerId != currentPlayer) {
+            return "Nao e seu turno. Vez de: " + currentPlayer;
+        }
+    }
+
+    int needed = effectiveCost(state);
+    if (state.remainingPoints < needed) {
+        return std::format("Pontos insuficientes. Necessario: {}, Disponivel: {}", needed, state.remainingPoints);
+    }
+
+    return std::nullopt;
+}
+
+void ActionUpdate::applyTo(GameState& state) const {
+    int spent = effectiveCost(state);
+    state.remainingPoints -= spent;
+
+    if (clue) {
+        bool alreadyExists = false;
+        bool targetSeen = false;
+        for (const auto& existing : state.discoveredClues) {
+            if (existing.id == clue->id) {
+                alreadyExists = true;
+                break;
+            }
+            if (existing.targetId == clue->targetId) targetSeen = true;
+        }
+
+        if (!alreadyExists) {
+            state.discoveredClues.push_back(*clue);
+
+            auto targetType = static_cast<size_t>(clue->targetType);
+            auto clueType = static_cast<size_t>(clue->type);
+            if (!targetSeen && targetType < kTargetTypeCount) state.coverage.targets[targetType]++;
+            if (clueType < kClueTypeCount) state.coverage.clues[clueType]++;
+        }
+    }
+
+    if (actionType == ActionType::InvestigateFunction) {
+        state.investigatedTargets.insert(targetId);
+    }
+    else if (actionType == ActionType::SetBreakpoint) {
+        state.breakpointedTargets.insert(targetId);
+    }
+
+    state.lastActivity = now;
+    state.revision++;
+    state.actionHistory.push_back({
+        .playerId = playerId,
+        .actionType = actionType,
+        .targetId = targetId,
+        .timestamp = now
+        });
+
+    if (spent > 0 && !state.turnOrder.empty()) {
+        state.currentTurnIndex = (state.currentTurnIndex + 1) % state.turnOrder.size();
+        state.turnStartTime = clue ? now + clueRevealBonus : now;
+    }
+
+    if (state.remainingPoints <= 0) {
+        if (state.currentDay >= dayLimit) {
+            state.isSuddenDeath = true;
+            state.remainingPoints = 0;
+        }
+        else {
+            state.currentDay++;
+            state.remainingPoints = pointsPerDay;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../shared/DTOs.hpp"
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace FindTheBug {
+
+	// Acao de jogo ja resolvida contra o caso compilado (custos, pista, regras do dia).
+	// O armazenamento verifica as pre-condicoes e aplica a mudanca atomicamente no documento da sessao;
+	// MongoStore traduz as mesmas regras para um pipeline de update e precisa ficar em sincronia com applyTo.
+	struct ActionUpdate {
+		std::string sessionId;
+		std::string playerId;
+		ActionType actionType{ ActionType::SkipTurn };
+		std::string targetId;
+
+		bool requiresTurn{ true };
+		int cost{ 0 };
+		int discountedCost{ 0 };
+		CostDiscount discountWhen{ CostDiscount::None };
+		std::optional<DiscoveredClue> clue;
+
+		std::chrono::system_clock::time_point now;
+		std::chrono::seconds clueRevealBonus{ 0 };
+		int pointsPerDay{ 12 };
+		int dayLimit{ 5 };
+
+		int effectiveCost(const GameState& state) const;
+
+		// Motivo da recusa com as mensagens mostradas ao jogador, ou nullopt se a acao pode ser aplicada.
+		std::optional<std::string> rejectReason(const GameState& state) const;
+
+		// Aplica sobre o estado em memoria. Assume rejectReason(state) == nullopt.
+		void applyTo(GameState& state) const;
+	};
+}
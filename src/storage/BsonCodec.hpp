@@ -0,0 +1,176 @@
+#pragma once
+
+#include "../shared/Reflect.hpp"
+
+#include <bsoncxx/builder/basic/array.hpp>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <bsoncxx/document/element.hpp>
+#include <bsoncxx/document/value.hpp>
+#include <bsoncxx/document/view.hpp>
+#include <bsoncxx/types.hpp>
+
+#include <string>
+#include <string_view>
+
+// Codec BSON gerado a partir dos descritores de Reflect.hpp.
+// Enums e inteiros vao como int32, datas como b_date e structs aninhadas como subdocumentos.
+namespace FindTheBug::Bson {
+
+    using bsoncxx::builder::basic::kvp;
+    using bsoncxx::builder::basic::sub_array;
+    using bsoncxx::builder::basic::sub_document;
+
+    // ---- Escrita ----
+
+    template <Reflect::Described T>
+    void appendFields(sub_document doc, const T& value);
+
+    // Converte um membro no valor aceito pelo builder basico: tipo BSON escalar
+    // ou uma funcao que preenche um subdocumento/subarray.
+    template <typename T>
+    auto bsonValue(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return bsoncxx::types::b_bool{ value };
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            return bsoncxx::types::b_int32{ static_cast<int32_t>(value) };
+        }
+        else if constexpr (Reflect::Integer<T> && sizeof(T) <= sizeof(int32_t)) {
+            return bsoncxx::types::b_int32{ static_cast<int32_t>(value) };
+        }
+        else if constexpr (Reflect::Integer<T>) {
+            return bsoncxx::types::b_int64{ static_cast<int64_t>(value) };
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            return bsoncxx::types::b_string{ std::string_view(value) };
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            return bsoncxx::types::b_date{ value };
+        }
+        else if constexpr (Reflect::Described<T>) {
+            return [&value](sub_document doc) { appendFields(doc, value); };
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            return [&value](sub_document doc) {
+                for (const auto& [key, item] : value) doc.append(kvp(std::string_view(key), bsonValue(item)));
+            };
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            return [&value](sub_array arr) {
+                for (const auto& item : value) arr.append(bsonValue(item));
+            };
+        }
+        else {
+            static_assert(sizeof(T) == 0, "Bson::bsonValue: tipo sem descritor");
+        }
+    }
+
+    template <typename T>
+    void appendMember(sub_document doc, std::string_view name, const T& value) {
+        if constexpr (Reflect::Optional<T>) {
+            if (value) doc.append(kvp(name, bsonValue(*value)));
+            else doc.append(kvp(name, bsoncxx::types::b_null{}));
+        }
+        else {
+            doc.append(kvp(name, bsonValue(value)));
+        }
+    }
+
+    template <Reflect::Described T>
+    void appendFields(sub_document doc, const T& value) {
+        Reflect::forEachField<T>([&](const auto& f) {
+            appendMember(doc, f.name, value.*(f.member));
+        });
+    }
+
+    template <Reflect::Described T>
+    bsoncxx::document::value toDocument(const T& value) {
+        bsoncxx::builder::basic::document doc;
+        appendFields(doc, value);
+        return doc.extract();
+    }
+
+    // ---- Leitura ----
+    // Campos ausentes ou com tipo incompativel mantem o valor padrao do DTO.
+    // Inteiros aceitam int32, int64 e double (documentos editados a mao no shell costumam vir como double).
+
+    template <Reflect::Described T>
+    bool readFields(bsoncxx::document::view view, T& out);
+
+    template <typename T, typename Element>
+    bool readValue(const Element& el, T& out) {
+        auto type = el.type();
+        if constexpr (std::is_same_v<T, bool>) {
+            if (type != bsoncxx::type::k_bool) return false;
+            out = el.get_bool().value;
+        }
+        else if constexpr (std::is_enum_v<T> || Reflect::Integer<T>) {
+            long long number = 0;
+            switch (type) {
+            case bsoncxx::type::k_int32:  number = el.get_int32().value; break;
+            case bsoncxx::type::k_int64:  number = el.get_int64().value; break;
+            case bsoncxx::type::k_double: number = static_cast<long long>(el.get_double().value); break;
+            case bsoncxx::type::k_string:
+                if constexpr (std::is_enum_v<T>) return Reflect::parseEnum(std::string_view(el.get_string().value), out);
+                else return false;
+            default: return false;
+            }
+            out = static_cast<T>(number);
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            if (type != bsoncxx::type::k_string) return false;
+            out = std::string(el.get_string().value);
+        }
+        else if constexpr (Reflect::TimePoint<T>) {
+            if (type != bsoncxx::type::k_date) return false;
+            out = T(el.get_date().value);
+        }
+        else if constexpr (Reflect::Optional<T>) {
+            if (type == bsoncxx::type::k_null) {
+                out.reset();
+                return true;
+            }
+            typename T::value_type inner{};
+            if (!readValue(el, inner)) return false;
+            out = std::move(inner);
+        }
+        else if constexpr (Reflect::Described<T>) {
+            if (type != bsoncxx::type::k_document) return false;
+            return readFields(el.get_document().view(), out);
+        }
+        else if constexpr (Reflect::StringMap<T>) {
+            if (type != bsoncxx::type::k_document) return false;
+            out.clear();
+            for (const auto& item : el.get_document().view()) {
+                typename T::mapped_type value{};
+                if (readValue(item, value)) out.emplace(std::string(item.key()), std::move(value));
+            }
+        }
+        else if constexpr (Reflect::Sequence<T>) {
+            if (type != bsoncxx::type::k_array) return false;
+            if constexpr (!Reflect::IsStdArray<T>::value) out.clear();
+            size_t i = 0;
+            for (const auto& item : el.get_array().value) {
+                Reflect::ElementType<T> value{};
+                if (readValue(item, value) && !Reflect::insertElement(out, i, std::move(value))) break;
+                ++i;
+            }
+        }
+        else {
+            static_assert(sizeof(T) == 0, "Bson::readValue: tipo sem descritor");
+        }
+        return true;
+    }
+
+    // Uma passada pelos elementos do documento; cada chave e despachada para o campo de mesmo nome.
+    template <Reflect::Described T>
+    bool readFields(bsoncxx::document::view view, T& out) {
+        for (const auto& el : view) {
+            Reflect::visitField<T>(std::string_view(el.key()), [&](const auto& f) {
+                readValue(el, out.*(f.member));
+            });
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../shared/DTOs.hpp"
+#include "ActionUpdate.hpp"
+#include "NoteUpdate.hpp"
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace FindTheBug {
+
+	// Persistencia usada pelo GameEngine. MongoStore em producao, MemoryStore no simulador.
+	class GameStore {
+	public:
+		virtual ~GameStore() = default;
+
+		virtual std::optional<BugCase> getCase(const std::string& caseId) const = 0;
+		virtual std::optional<GameState> getGameState(const std::string& sessionId) const = 0;
+		// Grava o estado inteiro. So no inicio da partida: com a sessao em andamento use as operacoes abaixo,
+		// que nao sobrescrevem escritas concorrentes.
+		virtual bool saveGameState(const GameState& state) = 0;
+
+		// Grava a sessao inteira se a revisao ainda for expectedRevision, incrementando-a. Toda escrita da sessao
+		// incrementa a revisao, entao nada gravado depois da leitura do chamador (acoes, notas) se perde.
+		// Retorna o estado gravado, ou nullopt se a sessao nao existe ou outra escrita veio antes.
+		virtual std::optional<GameState> updateSession(const GameState& state, int64_t expectedRevision) = 0;
+
+		// Passa a vez ao proximo jogador se o turno ainda for o lido pelo chamador (indice e inicio), com $inc na
+		// revisao. Retorna o estado gravado, ou nullopt se a vez ja mudou ou a sessao nao existe/terminou.
+		virtual std::optional<GameState> skipTurn(
+			const std::string& sessionId,
+			int expectedTurnIndex,
+			std::chrono::system_clock::time_point expectedTurnStart,
+			std::chrono::system_clock::time_point now) = 0;
+
+		// Verifica as pre-condicoes e aplica a acao numa unica operacao atomica.
+		// Retorna o estado ja atualizado, ou nullopt se a sessao nao existe ou a acao foi recusada.
+		virtual std::optional<GameState> applyAction(const ActionUpdate& update) = 0;
+
+		// Grava so a nota indicada, sem regravar o estado. false se a sessao/pista nao existe ou a edicao foi recusada.
+		virtual bool setPlayerNote(const NoteUpdate& note) = 0;
+
+		// Acrescenta operacoes ao log da nota compartilhada da pista, sem ler nem regravar o estado.
+		// false se a sessao/pista nao existe ou o log passaria de kMaxSharedNoteOps.
+		virtual bool appendSharedNoteOps(const std::string& sessionId, const std::string& clueId, const std::vector<NoteOp>& ops) = 0;
+	};
+}
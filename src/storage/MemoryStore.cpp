@@ -0,0 +1,148 @@
+#include "MemoryStore.hpp"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace FindTheBug;
+
+class MemoryStore::Impl {
+public:
+    static constexpr size_t kShards = 64;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, GameState> sessions;
+    };
+
+    std::array<Shard, kShards> shards;
+
+    mutable std::shared_mutex casesMutex;
+    std::unordered_map<std::string, BugCase> cases;
+
+    Shard& shardFor(const std::string& sessionId) {
+        return shards[std::hash<std::string>{}(sessionId) % kShards];
+    }
+
+    const Shard& shardFor(const std::string& sessionId) const {
+        return shards[std::hash<std::string>{}(sessionId) % kShards];
+    }
+};
+
+MemoryStore::MemoryStore()
+    : pImpl(std::make_unique<Impl>()) {
+}
+
+MemoryStore::~MemoryStore() = default;
+
+void MemoryStore::putCase(const BugCase& bugCase) {
+    std::unique_lock lock(pImpl->casesMutex);
+    pImpl->cases[bugCase.id] = bugCase;
+}
+
+std::optional<BugCase> MemoryStore::getCase(const std::string& caseId) const {
+    std::shared_lock lock(pImpl->casesMutex);
+    auto it = pImpl->cases.find(caseId);
+    if (it == pImpl->cases.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<GameState> MemoryStore::getGameState(const std::string& sessionId) const {
+    const auto& shard = pImpl->shardFor(sessionId);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.sessions.find(sessionId);
+    if (it == shard.sessions.end()) return std::nullopt;
+    return it->second;
+}
+
+bool MemoryStore::saveGameState(const GameState& state) {
+    auto& shard = pImpl->shardFor(state.sessionId);
+    std::unique_lock lock(shard.mutex);
+    shard.sessions[state.sessionId] = state;
+    return true;
+}
+
+std::optional<GameState> MemoryStore::updateSession(const GameState& state, int64_t expectedRevision) {
+    auto& shard = pImpl->shardFor(state.sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.sessions.find(state.sessionId);
+    if (it == shard.sessions.end() || it->second.revision != expectedRevision) return std::nullopt;
+
+    it->second = state;
+    it->second.revision = expectedRevision + 1;
+    return it->second;
+}
+
+std::optional<GameState> MemoryStore::skipTurn(const std::string& sessionId, int expectedTurnIndex,
+    std::chrono::system_clock::time_point expectedTurnStart, std::chrono::system_clock::time_point now) {
+    auto& shard = pImpl->shardFor(sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.sessions.find(sessionId);
+    if (it == shard.sessions.end()) return std::nullopt;
+
+    auto& state = it->second;
+    if (state.isCompleted || state.turnOrder.empty()) return std::nullopt;
+    if (state.currentTurnIndex != expectedTurnIndex || state.turnStartTime != expectedTurnStart) return std::nullopt;
+
+    state.currentTurnIndex = (state.currentTurnIndex + 1) % static_cast<int>(state.turnOrder.size());
+    state.turnStartTime = now;
+    state.revision++;
+    return state;
+}
+
+std::optional<GameState> MemoryStore::applyAction(const ActionUpdate& update) {
+    auto& shard = pImpl->shardFor(update.sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.sessions.find(update.sessionId);
+    if (it == shard.sessions.end()) return std::nullopt;
+    if (update.rejectReason(it->second)) return std::nullopt;
+
+    update.applyTo(it->second);
+    return it->second;
+}
+
+bool MemoryStore::setPlayerNote(const NoteUpdate& note) {
+    auto& shard = pImpl->shardFor(note.sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.sessions.find(note.sessionId);
+    if (it == shard.sessions.end()) return false;
+    if (note.rejectReason(it->second)) return false;
+
+    note.applyTo(it->second);
+    return true;
+}
+
+bool MemoryStore::appendSharedNoteOps(const std::string& sessionId, const std::string& clueId, const std::vector<NoteOp>& ops) {
+    auto& shard = pImpl->shardFor(sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.sessions.find(sessionId);
+    if (it == shard.sessions.end()) return false;
+
+    for (auto& dc : it->second.discoveredClues) {
+        if (dc.id != clueId) continue;
+        if (dc.sharedNoteOps.size() + ops.size() > kMaxSharedNoteOps) return false;
+
+        dc.sharedNoteOps.insert(dc.sharedNoteOps.end(), ops.begin(), ops.end());
+        it->second.lastActivity = std::chrono::system_clock::now();
+        it->second.revision++;
+        return true;
+    }
+    return false;
+}
+
+bool MemoryStore::deleteSession(const std::string& sessionId) {
+    auto& shard = pImpl->shardFor(sessionId);
+    std::unique_lock lock(shard.mutex);
+    return shard.sessions.erase(sessionId) > 0;
+}
+
+size_t MemoryStore::sessionCount() const {
+    size_t total = 0;
+    for (const auto& shard : pImpl->shards) {
+        std::shared_lock lock(shard.mutex);
+        total += shard.sessions.size();
+    }
+    return total;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GameStore.hpp"
+#include <memory>
+#include <string>
+
+namespace FindTheBug {
+
+	// Backend em memoria, particionado por sessao. Usado pelo findthebug-sim.
+	class MemoryStore : public GameStore {
+	public:
+		MemoryStore();
+		~MemoryStore() override;
+
+		void putCase(const BugCase& bugCase);
+
+		std::optional<BugCase> getCase(const std::string& caseId) const override;
+		std::optional<GameState> getGameState(const std::string& sessionId) const override;
+		bool saveGameState(const GameState& state) override;
+		std::optional<GameState> updateSession(const GameState& state, int64_t expectedRevision) override;
+		std::optional<GameState> skipTurn(const std::string& sessionId, int expectedTurnIndex,
+			std::chrono::system_clock::time_point expectedTurnStart, std::chrono::system_clock::time_point now) override;
+		std::optional<GameState> applyAction(const ActionUpdate& update) override;
+		bool setPlayerNote(const NoteUpdate& note) override;
+		bool appendSharedNoteOps(const std::string& sessionId, const std::string& clueId, const std::vector<NoteOp>& ops) override;
+
+		bool deleteSession(const std::string& sessionId);
+		size_t sessionCount() const;
+
+	private:
+		class Impl;
+		std::unique_ptr<Impl> pImpl;
+	};
+}
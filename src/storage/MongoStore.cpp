@@ -1,4 +1,6 @@
 #include "MongoStore.hpp"
+#include "BsonCodec.hpp"
+#include "../shared/DTOFields.hpp"
 
 #include <bsoncxx/json.hpp>
 #include <mongocxx/client.hpp>
@@ -8,21 +10,57 @@
 #include <bsoncxx/builder/stream/document.hpp>
 #include <bsoncxx/builder/stream/helpers.hpp>
 #include <bsoncxx/builder/stream/array.hpp>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/array.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <mongocxx/pipeline.hpp>
+#include <mongocxx/options/find_one_and_update.hpp>
+#include <mongocxx/options/change_stream.hpp>
+#include <mongocxx/change_stream.hpp>
 
 #include <iostream>
 #include <chrono>
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <print>
+#include <thread>
 
 using namespace FindTheBug;
 using namespace bsoncxx::builder::stream;
+using bsoncxx::builder::basic::kvp;
+using bsoncxx::builder::basic::make_array;
+using bsoncxx::builder::basic::make_document;
 
 static mongocxx::instance instance{};
 
+// Sessoes gravadas antes dos contadores de cobertura: reconstroi uma vez a partir das pistas.
+static void rebuildCoverage(GameState& gs) {
+    gs.coverage = {};
+    std::unordered_set<std::string> seenTargets;
+    for (const auto& clue : gs.discoveredClues) {
+        auto targetType = static_cast<size_t>(clue.targetType);
+        auto clueType = static_cast<size_t>(clue.type);
+        if (targetType < kTargetTypeCount && seenTargets.insert(clue.targetId).second) gs.coverage.targets[targetType]++;
+        if (clueType < kClueTypeCount) gs.coverage.clues[clueType]++;
+    }
+}
+
+static GameState readGameState(bsoncxx::document::view view) {
+    GameState gs;
+    gs.lastActivity = std::chrono::system_clock::now();
+    gs.turnStartTime = gs.lastActivity;
+    Bson::readFields(view, gs);
+
+    if (!view["coverage"]) rebuildCoverage(gs);
+    return gs;
+}
+
 class MongoStore::Impl {
 public:
     std::shared_ptr<mongocxx::pool> pool;
     std::string dbName;
+    std::jthread caseWatcher;  // ultimo membro: para antes do pool ser destruido
 
     Impl(const std::string& uriString, const std::string& name)
         : dbName(name) {
@@ -44,27 +82,13 @@ MongoStore::~MongoStore() = default;
 
 // Operaes de Lobby
 
-bool MongoStore::createLobby(const std::string& sessionId, const PlayerInfo& host) {
+bool MongoStore::createLobby(const LobbyInfo& lobby) {
     try {
         auto conn = pImpl->acquire();
         auto db = (*conn)[pImpl->dbName];
         auto collection = db["sessions"];
 
-        auto doc = document{}
-            << "sessionId" << sessionId
-            << "phase" << static_cast<int>(GamePhase::Lobby)
-            << "createdAt" << bsoncxx::types::b_date(std::chrono::system_clock::now())
-            << "lastActivity" << bsoncxx::types::b_date(std::chrono::system_clock::now())
-            << "players" << open_array
-            << open_document
-            << "name" << host.name
-            << "role" << static_cast<int>(host.role)
-            << "joinedAt" << bsoncxx::types::b_date(host.joinedAt)
-            << close_document
-            << close_array
-            << finalize;
-
-        collection.insert_one(doc.view());
+        collection.insert_one(Bson::toDocument(lobby).view());
         return true;
     }
     catch (const std::exception& e) {
@@ -73,34 +97,22 @@ bool MongoStore::createLobby(const std::string& sessionId, const PlayerInfo& hos
     }
 }
 
-bool MongoStore::addPlayerToLobby(const std::string& sessionId, const PlayerInfo& player) {
+bool MongoStore::saveLobby(const LobbyInfo& lobby) {
     try {
         auto conn = pImpl->acquire();
         auto db = (*conn)[pImpl->dbName];
         auto collection = db["sessions"];
 
-        auto update = document{}
-            << "$push" << open_document
-            << "players" << open_document
-            << "name" << player.name
-            << "role" << static_cast<int>(player.role)
-            << "joinedAt" << bsoncxx::types::b_date(player.joinedAt)
-            << close_document
-            << close_document
-            << "$set" << open_document
-            << "lastActivity" << bsoncxx::types::b_date(std::chrono::system_clock::now())
-            << close_document
-            << finalize;
-
+        auto lobbyDoc = Bson::toDocument(lobby);
         auto result = collection.update_one(
-            document{} << "sessionId" << sessionId << finalize,
-            update.view()
+            document{} << "sessionId" << lobby.sessionId << finalize,
+            document{} << "$set" << bsoncxx::types::b_document{ lobbyDoc.view() } << finalize
         );
 
-        return result && result->modified_count() > 0;
+        return result && result->matched_count() > 0;
     }
     catch (const std::exception& e) {
-        std::print("[MONGO] Error in addPlayerToLobby: {}\n", e.what());
+        std::print("[MONGO] Error in saveLobby: {}\n", e.what());
         return false;
     }
 }
@@ -135,27 +147,6 @@ bool MongoStore::removePlayerFromLobby(const std::string& sessionId, const std::
     }
 }
 
-bool MongoStore::updatePhase(const std::string& sessionId, GamePhase newPhase) {
-    try {
-        auto conn = pImpl->acquire();
-        auto db = (*conn)[pImpl->dbName];
-        auto collection = db["sessions"];
-
-        auto result = collection.update_one(
-            document{} << "sessionId" << sessionId << finalize,
-            document{} << "$set" << open_document
-            << "phase" << static_cast<int>(newPhase)
-            << "lastActivity" << bsoncxx::types::b_date(std::chrono::system_clock::now())
-            << close_document << finalize
-        );
-        return result && result->modified_count() > 0;
-    }
-    catch (const std::exception& e) {
-        std::print("[MONGO] Error in updatePhase: {}\n", e.what());
-        return false;
-    }
-}
-
 std::optional<LobbyInfo> MongoStore::getLobby(const std::string& sessionId) const {
     try {
         auto conn = pImpl->acquire();
@@ -168,25 +159,8 @@ std::optional<LobbyInfo> MongoStore::getLobby(const std::string& sessionId) cons
 
         if (!result) return std::nullopt;
 
-        auto view = result->view();
         LobbyInfo lobby;
-
-        if (view["sessionId"])
-            lobby.sessionId = std::string(view["sessionId"].get_string().value);
-
-        if (view["phase"])
-            lobby.phase = static_cast<GamePhase>(view["phase"].get_int32().value);
-
-        if (view["players"] && view["players"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["players"].get_array().value) {
-                auto doc = elem.get_document().view();
-                PlayerInfo p;
-                if (doc["name"]) p.name = std::string(doc["name"].get_string().value);
-                if (doc["role"]) p.role = static_cast<PlayerRole>(doc["role"].get_int32().value);
-
-                lobby.players.push_back(p);
-            }
-        }
+        Bson::readFields(result->view(), lobby);
 
         return lobby;
     }
@@ -219,71 +193,35 @@ std::optional<BugCase> MongoStore::getCase(const std::string& caseId) const {
 
         auto view = result->view();
         BugCase bc;
-
-        if (view["id"]) bc.id = std::string(view["id"].get_string().value);
-        if (view["title"]) bc.title = std::string(view["title"].get_string().value);
-        if (view["description"]) bc.description = std::string(view["description"].get_string().value);
-
-        if (view["systemTopology"] && view["systemTopology"].type() == bsoncxx::type::k_document) {
-            auto topoView = view["systemTopology"].get_document().view();
-
-            if (topoView["modules"] && topoView["modules"].type() == bsoncxx::type::k_array) {
-                for (const auto& el : topoView["modules"].get_array().value) {
-                    auto doc = el.get_document().view();
-                    ModuleNode m;
-                    if (doc["name"]) m.name = std::string(doc["name"].get_string().value);
-                    bc.systemTopology.modules.push_back(m);
-                }
-            }
-
-            if (topoView["functions"] && topoView["functions"].type() == bsoncxx::type::k_array) {
-                for (const auto& el : topoView["functions"].get_array().value) {
-                    auto doc = el.get_document().view();
-                    FunctionNode f;
-                    if (doc["name"]) f.name = std::string(doc["name"].get_string().value);
-                    if (doc["parentId"]) f.parentId = std::string(doc["parentId"].get_string().value);
-                    bc.systemTopology.functions.push_back(f);
-                }
-            }
-
-            if (topoView["connections"] && topoView["connections"].type() == bsoncxx::type::k_array) {
-                for (const auto& el : topoView["connections"].get_array().value) {
-                    auto doc = el.get_document().view();
-                    ConnectionNode c;
-                    if (doc["id"]) c.id = std::string(doc["id"].get_string().value);
-                    if (doc["from"]) c.from = std::string(doc["from"].get_string().value);
-                    if (doc["to"]) c.to = std::string(doc["to"].get_string().value);
-                    bc.systemTopology.connections.push_back(c);
+        Bson::readFields(view, bc);
+
+        // answerConcepts: [[{label, terms: [..]} | "termo", ...], ...], um array por resposta.
+        if (view["answerConcepts"] && view["answerConcepts"].type() == bsoncxx::type::k_array) {
+            for (const auto& answerElem : view["answerConcepts"].get_array().value) {
+                auto& concepts = bc.answerConcepts.emplace_back();
+                if (answerElem.type() != bsoncxx::type::k_array) continue;
+
+                for (const auto& conceptElem : answerElem.get_array().value) {
+                    AnswerConcept ac;
+                    if (conceptElem.type() == bsoncxx::type::k_string) {
+                        ac.label = std::string(conceptElem.get_string().value);
+                        ac.terms.push_back(ac.label);
+                    }
+                    else if (conceptElem.type() == bsoncxx::type::k_document) {
+                        auto doc = conceptElem.get_document().view();
+                        if (doc["label"]) ac.label = std::string(doc["label"].get_string().value);
+                        if (doc["terms"] && doc["terms"].type() == bsoncxx::type::k_array) {
+                            for (const auto& term : doc["terms"].get_array().value) {
+                                ac.terms.push_back(std::string(term.get_string().value));
+                            }
+                        }
+                        if (ac.terms.empty() && !ac.label.empty()) ac.terms.push_back(ac.label);
+                    }
+                    if (!ac.terms.empty()) concepts.push_back(std::move(ac));
                 }
             }
         }
 
-        if (view["availableClues"] && view["availableClues"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["availableClues"].get_array().value) {
-                Clue c;
-                auto doc = elem.get_document().view();
-                if (doc["id"]) c.id = std::string(doc["id"].get_string().value);
-                if (doc["targetId"]) c.targetId = std::string(doc["targetId"].get_string().value);
-                if (doc["targetType"]) c.targetType = static_cast<TargetType>(doc["targetType"].get_int32().value);
-                if (doc["content"]) c.content = std::string(doc["content"].get_string().value);
-                if (doc["cost"]) c.cost = doc["cost"].get_int32().value;
-                if (doc["type"]) c.type = static_cast<ClueType>(doc["type"].get_int32().value);
-                bc.availableClues.push_back(c);
-            }
-        }
-
-        if (view["solutionQuestions"] && view["solutionQuestions"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["solutionQuestions"].get_array().value) {
-                bc.solutionQuestions.push_back(std::string(elem.get_string().value));
-            }
-        }
-
-        if (view["correctAnswers"] && view["correctAnswers"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["correctAnswers"].get_array().value) {
-                bc.correctAnswers.push_back(std::string(elem.get_string().value));
-            }
-        }
-
         return bc;
     }
     catch (...) {
@@ -300,84 +238,7 @@ std::optional<GameState> MongoStore::getGameState(const std::string& sessionId)
         auto result = collection.find_one(document{} << "sessionId" << sessionId << finalize);
         if (!result) return std::nullopt;
 
-        auto view = result->view();
-        GameState gs;
-
-        if (view["sessionId"]) gs.sessionId = std::string(view["sessionId"].get_string().value);
-        if (view["currentCaseId"]) gs.currentCaseId = std::string(view["currentCaseId"].get_string().value);
-        if (view["currentDay"]) gs.currentDay = view["currentDay"].get_int32().value;
-        if (view["remainingPoints"]) gs.remainingPoints = view["remainingPoints"].get_int32().value;
-        if (view["isCompleted"]) gs.isCompleted = view["isCompleted"].get_bool().value;
-        if (view["isSuddenDeath"]) gs.isSuddenDeath = view["isSuddenDeath"].get_bool().value;
-        if (view["hostPlayerId"]) gs.hostPlayerId = std::string(view["hostPlayerId"].get_string().value);
-        if (view["masterPlayerId"]) gs.masterPlayerId = std::string(view["masterPlayerId"].get_string().value);
-
-        if (view["currentTurnIndex"]) gs.currentTurnIndex = view["currentTurnIndex"].get_int32().value;
-
-        if (view["turnStartTime"]) {
-            gs.turnStartTime = view["turnStartTime"].get_date();
-        }
-        else {
-            gs.turnStartTime = std::chrono::system_clock::now();
-        }
-
-        if (view["lastActivity"]) {
-            gs.lastActivity = view["lastActivity"].get_date();
-        }
-        else {
-            gs.lastActivity = std::chrono::system_clock::now();
-        }
-
-        if (view["turnOrder"] && view["turnOrder"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["turnOrder"].get_array().value) {
-                gs.turnOrder.push_back(std::string(elem.get_string().value));
-            }
-        }
-
-        if (view["playerIds"] && view["playerIds"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["playerIds"].get_array().value) {
-                gs.playerIds.push_back(std::string(elem.get_string().value));
-            }
-        }
-
-        if (view["investigatedTargets"] && view["investigatedTargets"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["investigatedTargets"].get_array().value) {
-                gs.investigatedTargets.insert(std::string(elem.get_string().value));
-            }
-        }
-
-        if (view["breakpointedTargets"] && view["breakpointedTargets"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["breakpointedTargets"].get_array().value) {
-                gs.breakpointedTargets.insert(std::string(elem.get_string().value));
-            }
-        }
-
-        if (view["discoveredClues"] && view["discoveredClues"].type() == bsoncxx::type::k_array) {
-            for (const auto& elem : view["discoveredClues"].get_array().value) {
-                DiscoveredClue c;
-                auto doc = elem.get_document().view();
-
-                if (doc["id"]) c.id = std::string(doc["id"].get_string().value);
-                if (doc["targetId"]) c.targetId = std::string(doc["targetId"].get_string().value);
-                if (doc["targetType"]) c.targetType = static_cast<TargetType>(doc["targetType"].get_int32().value);
-                if (doc["type"]) c.type = static_cast<ClueType>(doc["type"].get_int32().value);
-                if (doc["content"]) c.content = std::string(doc["content"].get_string().value);
-                if (doc["discoveredBy"]) c.discoveredBy = std::string(doc["discoveredBy"].get_string().value);
-
-                if (doc["playerNotes"] && doc["playerNotes"].type() == bsoncxx::type::k_document) {
-                    auto notesView = doc["playerNotes"].get_document().view();
-                    for (auto note : notesView) {
-                        std::string pId(note.key());
-                        std::string txt(note.get_string().value);
-                        c.playerNotes[pId] = txt;
-                    }
-                }
-
-                gs.discoveredClues.push_back(c);
-            }
-        }
-
-        return gs;
+        return readGameState(result->view());
     }
     catch (const std::exception& e) {
         std::print("[MONGO] Error in getGameState: {}\n", e.what());
@@ -407,14 +268,10 @@ std::vector<CaseSummary> FindTheBug::MongoStore::listAvailableCases() const
 
         for (auto&& doc : cursor) {
             CaseSummary s;
-            if (doc["id"]) s.id = std::string(doc["id"].get_string().value);
-            if (doc["title"]) s.id = std::string(doc["title"].get_string().value);
-            if (doc["shortDescription"])
-                s.shortDescription = std::string(doc["shortDescription"].get_string().value);
-            else
-                s.shortDescription = "Sem descricao disponivel.";
-
-            summaries.push_back(s);
+            Bson::readFields(doc, s);
+            if (s.shortDescription.empty()) s.shortDescription = "Sem descricao disponivel.";
+
+            summaries.push_back(std::move(s));
         }
     }
     catch (const std::exception& e) {
@@ -429,63 +286,324 @@ bool MongoStore::saveGameState(const GameState& state) {
         auto db = (*conn)[pImpl->dbName];
         auto collection = db["sessions"];
 
-        bsoncxx::builder::stream::array inv_array;
-        for (const auto& t : state.investigatedTargets) inv_array << t;
+        auto stateDoc = Bson::toDocument(state);
+        auto update_doc = document{}
+            << "$set" << bsoncxx::types::b_document{ stateDoc.view() }
+            << finalize;
+
+        auto result = collection.update_one(
+            document{} << "sessionId" << state.sessionId << finalize,
+            update_doc.view()
+        );
+
+        return result && result->modified_count() > 0;
+    }
+    catch (const std::exception& e) {
+        std::print("[MONGO] Error in saveGameState: {}\n", e.what());
+        return false;
+    }
+}
+
+// Compare-and-set na revisao: o filtro so casa se nada foi gravado desde a leitura do chamador.
+std::optional<GameState> MongoStore::updateSession(const GameState& state, int64_t expectedRevision) {
+    try {
+        auto conn = pImpl->acquire();
+        auto db = (*conn)[pImpl->dbName];
+        auto collection = db["sessions"];
+
+        bsoncxx::builder::basic::document fields;
+        Reflect::forEachField<GameState>([&](const auto& f) {
+            if (f.name == "sessionId" || f.name == "revision") return;
+            Bson::appendMember(fields, f.name, state.*(f.member));
+        });
+
+        // Sessoes gravadas antes do campo revision contam como revisao 0 (null casa campo ausente).
+        bsoncxx::builder::basic::document filter;
+        filter.append(kvp("sessionId", state.sessionId));
+        if (expectedRevision == 0) filter.append(kvp("revision", make_document(kvp("$in", make_array(int64_t{ 0 }, bsoncxx::types::b_null{})))));
+        else filter.append(kvp("revision", expectedRevision));
+        auto update = make_document(
+            kvp("$set", fields.extract()),
+            kvp("$inc", make_document(kvp("revision", int64_t{ 1 }))));
+
+        mongocxx::options::find_one_and_update opts;
+        opts.return_document(mongocxx::options::return_document::k_after);
+
+        auto result = collection.find_one_and_update(filter.view(), update.view(), opts);
+        if (!result) return std::nullopt;
+
+        return readGameState(result->view());
+    }
+    catch (const std::exception& e) {
+        std::print("[MONGO] Error in updateSession: {}\n", e.what());
+        return std::nullopt;
+    }
+}
 
-        bsoncxx::builder::stream::array bp_array;
-        for (const auto& t : state.breakpointedTargets) bp_array << t;
+// O filtro repete o turno lido: se uma acao, uma saida ou outro no mudou a vez, nada e gravado.
+std::optional<GameState> MongoStore::skipTurn(const std::string& sessionId, int expectedTurnIndex,
+    std::chrono::system_clock::time_point expectedTurnStart, std::chrono::system_clock::time_point now) {
+    try {
+        auto conn = pImpl->acquire();
+        auto db = (*conn)[pImpl->dbName];
+        auto collection = db["sessions"];
 
-        bsoncxx::builder::stream::array player_ids_array;
-        for (const auto& playerId : state.playerIds) player_ids_array << playerId;
+        auto filter = make_document(
+            kvp("sessionId", sessionId),
+            kvp("isCompleted", make_document(kvp("$ne", true))),
+            kvp("turnOrder.0", make_document(kvp("$exists", true))),
+            kvp("currentTurnIndex", expectedTurnIndex),
+            kvp("turnStartTime", bsoncxx::types::b_date{ expectedTurnStart }));
+
+        // O proximo indice sai do turnOrder gravado, nao do lido.
+        mongocxx::pipeline stages;
+        stages.append_stage(make_document(kvp("$set", make_document(
+            kvp("currentTurnIndex", make_document(kvp("$mod", make_array(
+                make_document(kvp("$add", make_array("$currentTurnIndex", 1))),
+                make_document(kvp("$size", "$turnOrder")))))),
+            kvp("turnStartTime", bsoncxx::types::b_date{ now }),
+            kvp("revision", make_document(kvp("$add", make_array(
+                make_document(kvp("$ifNull", make_array("$revision", int64_t{ 0 }))), int64_t{ 1 }))))))));
+
+        mongocxx::options::find_one_and_update opts;
+        opts.return_document(mongocxx::options::return_document::k_after);
+
+        auto result = collection.find_one_and_update(filter.view(), stages, opts);
+        if (!result) return std::nullopt;
 
-        bsoncxx::builder::stream::array turn_order_array;
-        for (const auto& pid : state.turnOrder) turn_order_array << pid;
+        return readGameState(result->view());
+    }
+    catch (const std::exception& e) {
+        std::print("[MONGO] Error in skipTurn: {}\n", e.what());
+        return std::nullopt;
+    }
+}
 
-        bsoncxx::builder::stream::array clues_array;
-        for (const auto& clue : state.discoveredClues) {
+// Traducao de ActionUpdate::rejectReason (filtro) e ActionUpdate::applyTo (pipeline) avaliada no servidor:
+// uma unica ida ao banco por acao, devolvendo o documento ja atualizado. Mudou uma regra la, mude aqui.
+std::optional<GameState> MongoStore::applyAction(const ActionUpdate& update) {
+    try {
+        auto conn = pImpl->acquire();
+        auto db = (*conn)[pImpl->dbName];
+        auto collection = db["sessions"];
 
-            bsoncxx::builder::stream::document notes_doc;
-            for (const auto& pair : clue.playerNotes) {
-                notes_doc << pair.first << pair.second;
+        // Valores vindos do jogador entram como $literal para nunca serem lidos como caminho ($campo).
+        auto literal = [](const std::string& value) { return make_document(kvp("$literal", value)); };
+        auto orEmpty = [](const std::string& path) { return make_document(kvp("$ifNull", make_array(path, make_array()))); };
+        auto turnCount = [&] { return make_document(kvp("$size", orEmpty("$turnOrder"))); };
+
+        auto spent = [&] {
+            std::string discountSet;
+            if (update.discountWhen == CostDiscount::WhenInvestigated) discountSet = "$investigatedTargets";
+            if (update.discountWhen == CostDiscount::WhenBreakpointed) discountSet = "$breakpointedTargets";
+            if (discountSet.empty() || update.discountedCost == update.cost) {
+                return make_document(kvp("$literal", update.cost));
             }
+            return make_document(kvp("$cond", make_array(
+                make_document(kvp("$in", make_array(literal(update.targetId), orEmpty(discountSet)))),
+                update.discountedCost,
+                update.cost)));
+        };
+
+        // Pre-condicoes
+        bsoncxx::builder::basic::document filter;
+        filter.append(kvp("sessionId", update.sessionId));
+        filter.append(kvp("masterPlayerId", make_document(kvp("$ne", update.playerId))));
+        filter.append(kvp("$or", make_array(
+            make_document(kvp("playerIds", update.playerId)),
+            make_document(kvp("hostPlayerId", update.playerId)))));
+        if (update.actionType != ActionType::SubmitSolution) {
+            filter.append(kvp("isSuddenDeath", make_document(kvp("$ne", true))));
+        }
 
-            clues_array << bsoncxx::builder::stream::open_document
-                << "id" << clue.id
-                << "targetId" << clue.targetId
-                << "targetType" << static_cast<int>(clue.targetType)
-                << "type" << static_cast<int>(clue.type)
-                << "content" << clue.content
-                << "discoveredBy" << clue.discoveredBy
-                << "playerNotes" << notes_doc
-                << bsoncxx::builder::stream::close_document;
+        bsoncxx::builder::basic::array conditions;
+        conditions.append(make_document(kvp("$gte", make_array("$remainingPoints", spent()))));
+        if (update.requiresTurn) {
+            auto turn = make_document(kvp("$min", make_array(
+                make_document(kvp("$max", make_array(0, "$currentTurnIndex"))),
+                make_document(kvp("$subtract", make_array(turnCount(), 1))))));
+            conditions.append(make_document(kvp("$or", make_array(
+                make_document(kvp("$eq", make_array(turnCount(), 0))),
+                make_document(kvp("$eq", make_array(
+                    make_document(kvp("$arrayElemAt", make_array("$turnOrder", turn.view()))),
+                    literal(update.playerId))))))));
+        }
+        filter.append(kvp("$expr", make_document(kvp("$and", conditions.extract()))));
+
+        // Estagio 1: custo efetivo e situacao da pista, sobre o documento original.
+        bsoncxx::builder::basic::document prepare;
+        prepare.append(kvp("_spent", spent()));
+        if (update.clue) {
+            prepare.append(kvp("_newClue", make_document(kvp("$not", make_array(
+                make_document(kvp("$in", make_array(literal(update.clue->id), orEmpty("$discoveredClues.id")))))))));
+            prepare.append(kvp("_targetSeen", make_document(kvp("$in", make_array(
+                literal(update.clue->targetId), orEmpty("$discoveredClues.targetId"))))));
         }
 
-        auto update_doc = document{} << "$set" << open_document
-            << "currentCaseId" << state.currentCaseId
-            << "currentDay" << state.currentDay
-            << "remainingPoints" << state.remainingPoints
-            << "isCompleted" << state.isCompleted
-            << "isSuddenDeath" << state.isSuddenDeath
-            << "playerIds" << player_ids_array
-            << "hostPlayerId" << state.hostPlayerId
-            << "currentTurnIndex" << state.currentTurnIndex
-            << "turnOrder" << turn_order_array
-            << "turnStartTime" << bsoncxx::types::b_date(state.turnStartTime)
-            << "discoveredClues" << clues_array
-            << "investigatedTargets" << inv_array
-            << "breakpointedTargets" << bp_array
-            << "lastActivity" << bsoncxx::types::b_date(state.lastActivity)
-            << close_document << finalize;
+        // Estagio 2: pontos, pista, cobertura e alvos investigados.
+        bsoncxx::builder::basic::document apply;
+        apply.append(kvp("remainingPoints", make_document(kvp("$subtract", make_array("$remainingPoints", "$_spent")))));
+        apply.append(kvp("lastActivity", bsoncxx::types::b_date{ update.now }));
+        apply.append(kvp("revision", make_document(kvp("$add", make_array(
+            make_document(kvp("$ifNull", make_array("$revision", int64_t{ 0 }))), int64_t{ 1 })))));
+
+        if (update.clue) {
+            auto clueDoc = Bson::toDocument(*update.clue);
+            apply.append(kvp("discoveredClues", make_document(kvp("$cond", make_array(
+                "$_newClue",
+                make_document(kvp("$concatArrays", make_array(
+                    orEmpty("$discoveredClues"),
+                    make_array(make_document(kvp("$literal", clueDoc.view())))))),
+                "$discoveredClues")))));
+
+            // Contador indice a indice: soma 1 na posicao do tipo quando 'when' e verdadeiro.
+            auto bump = [](const std::string& path, size_t count, size_t index, bsoncxx::document::view when) {
+                auto hit = make_document(kvp("$and", make_array(when, make_document(kvp("$eq", make_array("$$i", static_cast<int32_t>(index)))))));
+                return make_document(kvp("$map", make_document(
+                    kvp("input", make_document(kvp("$range", make_array(0, static_cast<int32_t>(count))))),
+                    kvp("as", "i"),
+                    kvp("in", make_document(kvp("$add", make_array(
+                        make_document(kvp("$ifNull", make_array(make_document(kvp("$arrayElemAt", make_array(path, "$$i"))), 0))),
+                        make_document(kvp("$cond", make_array(hit.view(), 1, 0))))))))));
+            };
+
+            auto newTarget = make_document(kvp("$and", make_array("$_newClue", make_document(kvp("$not", make_array("$_targetSeen"))))));
+            auto newClue = make_document(kvp("$and", make_array("$_newClue")));
+
+            // Sessoes sem contadores ficam sem eles: getGameState reconstroi a partir das pistas.
+            apply.append(kvp("coverage", make_document(kvp("$cond", make_array(
+                make_document(kvp("$eq", make_array(make_document(kvp("$type", "$coverage")), "object"))),
+                make_document(
+                    kvp("targets", bump("$coverage.targets", kTargetTypeCount, static_cast<size_t>(update.clue->targetType), newTarget.view())),
+                    kvp("clues", bump("$coverage.clues", kClueTypeCount, static_cast<size_t>(update.clue->type), newClue.view()))),
+                "$$REMOVE")))));
+        }
 
-        auto result = collection.update_one(
-            document{} << "sessionId" << state.sessionId << finalize,
-            update_doc.view()
-        );
+        std::string touchedSet;
+        if (update.actionType == ActionType::InvestigateFunction) touchedSet = "investigatedTargets";
+        if (update.actionType == ActionType::SetBreakpoint) touchedSet = "breakpointedTargets";
+        if (!touchedSet.empty()) {
+            apply.append(kvp(touchedSet, make_document(kvp("$setUnion", make_array(
+                orEmpty("$" + touchedSet),
+                make_array(literal(update.targetId)))))));
+        }
 
-        return result && result->modified_count() > 0;
+        // Estagio 3: turno e virada de dia, sobre os pontos ja descontados.
+        auto advanced = make_document(kvp("$and", make_array(
+            make_document(kvp("$gt", make_array("$_spent", 0))),
+            make_document(kvp("$gt", make_array(turnCount(), 0))))));
+        auto rollover = make_document(kvp("$lte", make_array("$remainingPoints", 0)));
+        auto lastDay = make_document(kvp("$gte", make_array("$currentDay", update.dayLimit)));
+        auto turnStart = update.clue ? update.now + update.clueRevealBonus : update.now;
+
+        auto advance = make_document(
+            kvp("currentTurnIndex", make_document(kvp("$cond", make_array(
+                advanced.view(),
+                make_document(kvp("$mod", make_array(make_document(kvp("$add", make_array("$currentTurnIndex", 1))), turnCount()))),
+                "$currentTurnIndex")))),
+            kvp("turnStartTime", make_document(kvp("$cond", make_array(
+                advanced.view(), bsoncxx::types::b_date{ turnStart }, "$turnStartTime")))),
+            kvp("isSuddenDeath", make_document(kvp("$cond", make_array(
+                make_document(kvp("$and", make_array(rollover.view(), lastDay.view()))), true, "$isSuddenDeath")))),
+            kvp("remainingPoints", make_document(kvp("$cond", make_array(
+                rollover.view(),
+                make_document(kvp("$cond", make_array(lastDay.view(), 0, update.pointsPerDay))),
+                "$remainingPoints")))),
+            kvp("currentDay", make_document(kvp("$cond", make_array(
+                make_document(kvp("$and", make_array(rollover.view(), make_document(kvp("$not", make_array(lastDay.view())))))),
+                make_document(kvp("$add", make_array("$currentDay", 1))),
+                "$currentDay")))));
+
+        mongocxx::pipeline stages;
+        stages.append_stage(make_document(kvp("$set", prepare.extract())));
+        stages.append_stage(make_document(kvp("$set", apply.extract())));
+        stages.append_stage(make_document(kvp("$set", advance.view())));
+        stages.append_stage(make_document(kvp("$unset", make_array("_spent", "_newClue", "_targetSeen"))));
+
+        mongocxx::options::find_one_and_update opts;
+        opts.return_document(mongocxx::options::return_document::k_after);
+
+        auto result = collection.find_one_and_update(filter.view(), stages, opts);
+        if (!result) return std::nullopt;
+
+        return readGameState(result->view());
     }
     catch (const std::exception& e) {
-        std::print("[MONGO] Error in saveGameState: {}\n", e.what());
+        std::print("[MONGO] Error in applyAction: {}\n", e.what());
+        return std::nullopt;
+    }
+}
+
+// Mesmas regras de NoteUpdate::rejectReason: a pista precisa existir e o autor nao apaga a propria nota.
+// O operador posicional ($) atinge so o elemento casado pelo $elemMatch; o resto do documento nao trafega.
+bool MongoStore::setPlayerNote(const NoteUpdate& note) {
+    if (!isValidPlayerName(note.playerId)) return false;
+
+    try {
+        auto conn = pImpl->acquire();
+        auto db = (*conn)[pImpl->dbName];
+        auto collection = db["sessions"];
+
+        bsoncxx::builder::basic::document clueMatch;
+        clueMatch.append(kvp("id", note.clueId));
+        if (note.erases()) clueMatch.append(kvp("discoveredBy", make_document(kvp("$ne", note.playerId))));
+
+        auto filter = make_document(
+            kvp("sessionId", note.sessionId),
+            kvp("discoveredClues", make_document(kvp("$elemMatch", clueMatch.extract()))));
+
+        std::string path = "discoveredClues.$.playerNotes." + note.playerId;
+        bsoncxx::types::b_date touched{ note.now };
+
+        auto bump = make_document(kvp("revision", int64_t{ 1 }));
+        auto update = note.erases()
+            ? make_document(
+                kvp("$unset", make_document(kvp(path, ""))),
+                kvp("$set", make_document(kvp("lastActivity", touched))),
+                kvp("$inc", bump.view()))
+            : make_document(
+                kvp("$set", make_document(kvp(path, note.content), kvp("lastActivity", touched))),
+                kvp("$inc", bump.view()));
+
+        auto result = collection.update_one(filter.view(), update.view());
+        return result && result->matched_count() > 0;
+    }
+    catch (const std::exception& e) {
+        std::print("[MONGO] Error in setPlayerNote: {}\n", e.what());
+        return false;
+    }
+}
+
+bool MongoStore::appendSharedNoteOps(const std::string& sessionId, const std::string& clueId, const std::vector<NoteOp>& ops) {
+    if (ops.empty()) return true;
+
+    try {
+        auto conn = pImpl->acquire();
+        auto db = (*conn)[pImpl->dbName];
+        auto collection = db["sessions"];
+
+        // O limite do log entra no filtro: uma nota cheia simplesmente nao casa.
+        std::string capField = "sharedNoteOps." + std::to_string(kMaxSharedNoteOps - ops.size());
+        auto filter = make_document(
+            kvp("sessionId", sessionId),
+            kvp("discoveredClues", make_document(kvp("$elemMatch", make_document(
+                kvp("id", clueId),
+                kvp(capField, make_document(kvp("$exists", false))))))));
+
+        bsoncxx::builder::basic::array each;
+        for (const auto& op : ops) each.append(Bson::toDocument(op));
+
+        bsoncxx::types::b_date touched{ std::chrono::system_clock::now() };
+        auto update = make_document(
+            kvp("$push", make_document(kvp("discoveredClues.$.sharedNoteOps", make_document(kvp("$each", each.extract()))))),
+            kvp("$set", make_document(kvp("lastActivity", touched))),
+            kvp("$inc", make_document(kvp("revision", int64_t{ 1 }))));
+
+        auto result = collection.update_one(filter.view(), update.view());
+        return result && result->matched_count() > 0;
+    }
+    catch (const std::exception& e) {
+        std::print("[MONGO] Error in appendSharedNoteOps: {}\n", e.what());
         return false;
     }
 }
@@ -529,24 +647,39 @@ bool MongoStore::deleteSession(const std::string& sessionId) {
     }
 }
 
-long MongoStore::removeStaleSessions(int minutes) {
+std::vector<std::string> MongoStore::removeStaleSessions(int minutes) {
+    std::vector<std::string> removed;
     try {
         auto conn = pImpl->acquire();
         auto db = (*conn)[pImpl->dbName];
         auto collection = db["sessions"];
 
         auto cutoff = std::chrono::system_clock::now() - std::chrono::minutes(minutes);
+        auto stale = [&] {
+            return document{} << "lastActivity" << open_document
+                << "$lt" << bsoncxx::types::b_date(cutoff)
+                << close_document << finalize;
+        };
 
-        auto result = collection.delete_many(
-            document{} << "lastActivity" << open_document
-            << "$lt" << bsoncxx::types::b_date(cutoff)
-            << close_document << finalize
-        );
+        mongocxx::options::find opts;
+        opts.projection(document{} << "sessionId" << 1 << "_id" << 0 << finalize);
+
+        std::vector<std::string> candidates;
+        for (auto&& doc : collection.find(stale(), opts)) {
+            if (doc["sessionId"]) candidates.emplace_back(doc["sessionId"].get_string().value);
+        }
 
-        if (result) return result->deleted_count();
-        return 0;
+        // Uma a uma e com o prazo no filtro: sessao que voltou a ter atividade depois da busca fica.
+        for (auto& sessionId : candidates) {
+            auto result = collection.delete_one(document{}
+                << "sessionId" << sessionId
+                << "lastActivity" << open_document << "$lt" << bsoncxx::types::b_date(cutoff) << close_document
+                << finalize);
+            if (result && result->deleted_count() > 0) removed.push_back(std::move(sessionId));
+        }
     }
-    catch (...) { return 0; }
+    catch (...) {}
+    return removed;
 }
 
 std::vector<std::string> MongoStore::getFrozenSessions(int maxTurnSeconds) {
@@ -568,4 +701,59 @@ std::vector<std::string> MongoStore::getFrozenSessions(int maxTurnSeconds) {
     }
     catch (...) {}
     return activeSessions;
-}
\ No newline at end of file
+}
+
+// Cada tentativa segura um cliente do pool enquanto o stream estiver aberto.
+void MongoStore::watchCases(std::function<void(const std::string& caseId)> onChange, std::function<void(bool active)> onStatus) {
+    pImpl->caseWatcher = std::jthread([this, onChange = std::move(onChange), onStatus = std::move(onStatus)](std::stop_token stop) {
+        constexpr auto kRetryInterval = std::chrono::seconds(30);
+
+        while (!stop.stop_requested()) {
+            try {
+                auto conn = pImpl->acquire();
+                auto collection = (*conn)[pImpl->dbName]["cases"];
+
+                mongocxx::options::change_stream opts;
+                opts.full_document(bsoncxx::string::view_or_value("updateLookup"));
+                opts.max_await_time(std::chrono::milliseconds(1000));
+                auto stream = collection.watch(opts);
+                onStatus(true);
+
+                bool open = true;
+                while (open && !stop.stop_requested()) {
+                    // Sem eventos a iteracao volta vazia a cada max_await_time, o que permite checar stop.
+                    for (const auto& event : stream) {
+                        std::string caseId;
+                        auto full = event["fullDocument"];
+                        if (full && full.type() == bsoncxx::type::k_document) {
+                            auto id = full.get_document().view()["id"];
+                            if (id && id.type() == bsoncxx::type::k_string) caseId = std::string(id.get_string().value);
+                        }
+                        onChange(caseId);
+
+                        // Colecao removida ou renomeada: o stream termina e precisa ser reaberto.
+                        auto operation = event["operationType"];
+                        if (operation && operation.type() == bsoncxx::type::k_string && operation.get_string().value == "invalidate") {
+                            open = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                std::print("[MONGO] Change stream de casos indisponivel: {}\n", e.what());
+            }
+            if (stop.stop_requested()) return;
+            onStatus(false);
+
+            std::mutex mutex;
+            std::condition_variable_any wake;
+            std::unique_lock lock(mutex);
+            wake.wait_for(lock, stop, kRetryInterval, [] { return false; });
+        }
+        });
+}
+
+void MongoStore::stopWatchingCases() {
+    pImpl->caseWatcher = std::jthread();
+}
@@ -1,32 +1,47 @@
 #pragma once
 
-#include "../shared/DTOs.hpp"
+#include "GameStore.hpp"
+#include <functional>
 #include <optional>
 #include <memory>
 #include <string>
 
 namespace FindTheBug {
-	class MongoStore {
+	class MongoStore : public GameStore {
 	public:
 		explicit MongoStore(const std::string& connectionUri, const std::string& dbName);
-		~MongoStore();
+		~MongoStore() override;
 		
-		bool createLobby(const std::string& sessionId, const PlayerInfo& host);
-		bool addPlayerToLobby(const std::string& sessionId, const PlayerInfo& player);
+		bool createLobby(const LobbyInfo& lobby);
+		// Regrava roster, fase e atividade de um lobby existente (nao toca nos campos do GameState).
+		bool saveLobby(const LobbyInfo& lobby);
 		bool removePlayerFromLobby(const std::string& sessionId, const std::string& playerId);
-		bool updatePhase(const std::string& sessionId, GamePhase newPhase);
 		std::optional<LobbyInfo> getLobby(const std::string& sessionId) const;
 		bool sessionExists(const std::string& sessionId) const;
 
-		std::optional<BugCase> getCase(const std::string& caseId) const;
-		std::optional<GameState> getGameState(const std::string& sessionId) const;
+		std::optional<BugCase> getCase(const std::string& caseId) const override;
+		std::optional<GameState> getGameState(const std::string& sessionId) const override;
 		std::vector<CaseSummary> listAvailableCases() const;
 
-		bool saveGameState(const GameState& state);
+		bool saveGameState(const GameState& state) override;
+		std::optional<GameState> updateSession(const GameState& state, int64_t expectedRevision) override;
+		std::optional<GameState> skipTurn(const std::string& sessionId, int expectedTurnIndex,
+			std::chrono::system_clock::time_point expectedTurnStart, std::chrono::system_clock::time_point now) override;
+		std::optional<GameState> applyAction(const ActionUpdate& update) override;
+		bool setPlayerNote(const NoteUpdate& note) override;
+		bool appendSharedNoteOps(const std::string& sessionId, const std::string& clueId, const std::vector<NoteOp>& ops) override;
 		bool deleteSession(const std::string& sessionId);
-		long removeStaleSessions(int minutes);
+		// Remove as sessoes sem atividade ha mais de minutes e retorna os ids removidos.
+		std::vector<std::string> removeStaleSessions(int minutes);
 		std::vector<std::string> getFrozenSessions(int maxTurnSeconds);
 
+		// Change stream da colecao cases (exige replica set), numa thread propria. onChange recebe o id do caso
+		// alterado, ou vazio quando o evento nao o traz (remocao, drop). onStatus(true) quando o stream abre,
+		// onStatus(false) quando cai ou nao abre; nova tentativa a cada 30 s.
+		void watchCases(std::function<void(const std::string& caseId)> onChange, std::function<void(bool active)> onStatus);
+		// Para e espera a thread do change stream; nenhum callback roda depois disto.
+		void stopWatchingCases();
+
 	private:
 		class Impl;
 		std::unique_ptr<Impl> pImpl;
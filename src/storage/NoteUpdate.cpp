@@ -0,0 +1,32 @@
+#include "NoteUpdate.hpp"
+
+using namespace FindTheBug;
+
+std::optional<std::string> NoteUpdate::rejectReason(const GameState& state) const {
+    if (!isValidPlayerName(playerId)) {
+        return "Nome de jogador invalido.";
+    }
+
+    for (const auto& dc : state.discoveredClues) {
+        if (dc.id != clueId) continue;
+
+        if (erases() && dc.discoveredBy == playerId) {
+            return "O autor da pista nao pode apagar a propria nota.";
+        }
+        return std::nullopt;
+    }
+
+    return "Pista nao encontrada.";
+}
+
+void NoteUpdate::applyTo(GameState& state) const {
+    for (auto& dc : state.discoveredClues) {
+        if (dc.id != clueId) continue;
+
+        if (erases()) dc.playerNotes.erase(playerId);
+        else dc.playerNotes[playerId] = content;
+        break;
+    }
+    state.lastActivity = now;
+    state.revision++;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../shared/DTOs.hpp"
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace FindTheBug {
+
+	// Limite do log da nota compartilhada por pista (DiscoveredClue::sharedNoteOps).
+	inline constexpr size_t kMaxSharedNoteOps = 4096;
+
+	// Edicao de uma nota (conteudo vazio apaga). O autor da pista nao pode apagar a propria nota.
+	// MongoStore aplica com $set/$unset posicional em discoveredClues.$.playerNotes.<jogador>.
+	struct NoteUpdate {
+		std::string sessionId;
+		std::string playerId;
+		std::string clueId;
+		std::string content;
+		std::chrono::system_clock::time_point now;
+
+		bool erases() const { return content.empty(); }
+
+		std::optional<std::string> rejectReason(const GameState& state) const;
+		void applyTo(GameState& state) const;
+	};
+}
@@ -0,0 +1,63 @@
+#include "Check.hpp"
+
+#include "../src/engine/ActionSystem.hpp"
+#include "../src/shared/DTOFields.hpp"
+#include "../src/shared/JsonScanner.hpp"
+
+using namespace FindTheBug;
+
+namespace {
+
+    CaseRules parseRules(std::string_view json) {
+        CaseRules rules;
+        auto object = Json::Object::parse(json);
+        CHECK(object.has_value());
+        if (object) CHECK(Json::readFields(*object, rules));
+        return rules;
+    }
+
+    size_t index(ActionType action) {
+        return static_cast<size_t>(action);
+    }
+
+    // Regras sem action ou sem cost sao descartadas; antes viravam "ReadDocumentation custa 0".
+    void malformedRulesKeepDefaults() {
+        BugCase bugCase;
+        bugCase.id = "malformed";
+        bugCase.rules = parseRules(R"({"actionCosts":[{"cost":5},{"action":3},{}]})");
+        CHECK(bugCase.rules.actionCosts.size() == 3);
+
+        auto rules = ActionSystem::compileRules(bugCase);
+        CHECK(rules.baseCost[index(ActionType::ReadDocumentation)] == 1);
+        CHECK(rules.baseCost[index(ActionType::SetBreakpoint)] == 2);
+        CHECK(rules.discountedCost[index(ActionType::SetBreakpoint)] == 1);
+    }
+
+    void completeRuleOverridesDefault() {
+        BugCase bugCase;
+        bugCase.id = "complete";
+        bugCase.rules = parseRules(R"({"actionCosts":[{"action":0,"cost":4,"discountedCost":2,"discountWhen":"investigated"}]})");
+
+        auto rules = ActionSystem::compileRules(bugCase);
+        CHECK(rules.baseCost[index(ActionType::ReadDocumentation)] == 4);
+        CHECK(rules.discountedCost[index(ActionType::ReadDocumentation)] == 2);
+        CHECK(rules.discountWhen[index(ActionType::ReadDocumentation)] == CostDiscount::WhenInvestigated);
+    }
+
+    // Custo zero explicito e valido e nao pode ser confundido com campo ausente.
+    void explicitZeroCostIsKept() {
+        BugCase bugCase;
+        bugCase.id = "free";
+        bugCase.rules = parseRules(R"({"actionCosts":[{"action":1,"cost":0}]})");
+
+        auto rules = ActionSystem::compileRules(bugCase);
+        CHECK(rules.baseCost[index(ActionType::InsertLog)] == 0);
+    }
+}
+
+int main() {
+    malformedRulesKeepDefaults();
+    completeRuleOverridesDefault();
+    explicitZeroCostIsKept();
+    return Test::failures() == 0 ? 0 : 1;
+}
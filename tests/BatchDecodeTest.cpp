@@ -0,0 +1,62 @@
+#include "Check.hpp"
+
+#include "../src/protocol/Commands.hpp"
+#include "../src/shared/JsonScanner.hpp"
+
+using namespace FindTheBug;
+using namespace FindTheBug::Protocol;
+
+namespace {
+
+    DecodeStatus decodeBatch(std::string_view json, GameBatchCommand& out) {
+        auto frame = Json::Object::parse(json);
+        CHECK(frame.has_value());
+        return frame ? decode(*frame, out) : DecodeStatus::Ignored;
+    }
+
+    void wellFormedBatchDecodes() {
+        GameBatchCommand batch;
+        auto status = decodeBatch(R"({"type":"GAME_BATCH","sessionId":"S","commands":[
+            {"kind":"GAME_ACTION","playerId":"ana","actionType":0,"targetId":"mod"},
+            {"kind":"SAVE_NOTE","playerId":"ana","clueId":"c1","content":"x"}]})", batch);
+        CHECK(status == DecodeStatus::Ok);
+        CHECK(batch.commands.size() == 2);
+        CHECK(batch.commands[0].kind == CommandKind::GameAction && batch.commands[0].targetId == "mod");
+        CHECK(batch.commands[1].kind == CommandKind::SaveNote && batch.commands[1].clueId == "c1");
+    }
+
+    // Um elemento descartado deslocaria os resultados seguintes para o comando errado.
+    void malformedElementInvalidatesBatch() {
+        const char* cases[] = {
+            R"({"sessionId":"S","commands":[{"kind":"GAME_ACTION","playerId":"ana","actionType":0,"targetId":"m"},{"kind":"DANCE","playerId":"ana"}]})",
+            R"({"sessionId":"S","commands":[{"kind":"GAME_ACTION","playerId":"ana","actionType":0}]})",
+            R"({"sessionId":"S","commands":[{"kind":"SAVE_NOTE","playerId":"ana","clueId":7,"content":"x"}]})",
+            R"({"sessionId":"S","commands":[{"kind":"SAVE_NOTE","clueId":"c","content":"x"}]})",
+            R"({"sessionId":"S","commands":[3]})",
+            R"({"sessionId":"S","commands":[]})",
+        };
+        for (auto json : cases) {
+            GameBatchCommand batch;
+            CHECK(decodeBatch(json, batch) == DecodeStatus::Invalid);
+        }
+    }
+
+    void oversizedBatchIsInvalid() {
+        std::string json = R"({"sessionId":"S","commands":[)";
+        for (size_t i = 0; i <= GameBatchCommand::kMaxCommands; ++i) {
+            if (i) json += ',';
+            json += R"({"kind":"GAME_ACTION","playerId":"ana","actionType":0,"targetId":"m"})";
+        }
+        json += "]}";
+
+        GameBatchCommand batch;
+        CHECK(decodeBatch(json, batch) == DecodeStatus::Invalid);
+    }
+}
+
+int main() {
+    wellFormedBatchDecodes();
+    malformedElementInvalidatesBatch();
+    oversizedBatchIsInvalid();
+    return Test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <print>
+#include <source_location>
+#include <string_view>
+
+// Verificacao minima para os testes: registra a falha e segue, o main devolve o total.
+namespace FindTheBug::Test {
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(bool ok, std::string_view what, std::source_location where = std::source_location::current()) {
+        if (ok) return;
+        ++failures();
+        std::println(stderr, "{}:{}: falhou: {}", where.file_name(), where.line(), what);
+    }
+}
+
+#define CHECK(expr) ::FindTheBug::Test::check(static_cast<bool>(expr), #expr)
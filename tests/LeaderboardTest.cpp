@@ -0,0 +1,110 @@
+#include "Check.hpp"
+
+#include "../src/engine/Leaderboard.hpp"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace FindTheBug;
+
+namespace {
+
+    // rankOf (Fenwick) e top (std::set) precisam concordar em cada time.
+    void checkConsistent(const Leaderboard& board) {
+        auto standings = board.top(board.size());
+        CHECK(standings.size() == board.size());
+        for (const auto& s : standings) {
+            CHECK(board.rankOf(s.sessionId) == s.rank);
+            CHECK(board.scoreOf(s.sessionId) == s.score);
+        }
+    }
+
+    void tiesShareRank() {
+        Leaderboard board;
+        board.update("a", 500);
+        board.update("b", 300);
+        board.update("c", 300);
+        board.update("d", 100);
+
+        auto top = board.top(10);
+        CHECK(top.size() == 4);
+        CHECK(top[0].sessionId == "a" && top[0].rank == 1);
+        CHECK(top[1].rank == 2 && top[2].rank == 2);
+        CHECK(top[3].sessionId == "d" && top[3].rank == 4);
+        CHECK(board.rankOf("b") == 2 && board.rankOf("c") == 2 && board.rankOf("d") == 4);
+        CHECK(board.rankOf("ausente") == 0);
+
+        // O corte do top pode cair no meio de um empate: a posicao continua a do grupo.
+        auto cut = board.top(2);
+        CHECK(cut.size() == 2 && cut[1].rank == 2);
+        checkConsistent(board);
+    }
+
+    void updatesMoveTeams() {
+        Leaderboard board;
+        board.update("a", 500);
+        board.update("b", 300);
+        board.update("c", 300);
+
+        CHECK(!board.update("b", 300));
+        CHECK(board.update("c", 600));
+        CHECK(board.rankOf("c") == 1 && board.rankOf("a") == 2 && board.rankOf("b") == 3);
+
+        CHECK(board.update("a", 300));
+        CHECK(board.rankOf("a") == 2 && board.rankOf("b") == 2);
+        CHECK(board.size() == 3);
+        checkConsistent(board);
+
+        // Fora da faixa vai para as pontas.
+        board.update("d", -5);
+        board.update("e", Leaderboard::kScoreRange + 10);
+        CHECK(board.scoreOf("d") == 0 && board.rankOf("d") == 5);
+        CHECK(board.scoreOf("e") == Leaderboard::kScoreRange - 1 && board.rankOf("e") == 1);
+        checkConsistent(board);
+    }
+
+    // Vitoria acima de partida em andamento acima de derrota, qualquer que seja o progresso.
+    void scoreTiersOrderOutcomes() {
+        GameState slow;
+        slow.currentDay = 5;
+        GameState fast;
+        fast.currentDay = 1;
+        fast.discoveredClues.resize(40);
+
+        CHECK(Leaderboard::scoreFor(slow, GameResult::Victory) > Leaderboard::scoreFor(fast, GameResult::Running));
+        CHECK(Leaderboard::scoreFor(slow, GameResult::Running) > Leaderboard::scoreFor(fast, GameResult::Defeat));
+        CHECK(Leaderboard::scoreFor(fast, GameResult::Victory) > Leaderboard::scoreFor(slow, GameResult::Victory));
+        CHECK(Leaderboard::scoreFor(fast, GameResult::Running) > Leaderboard::scoreFor(slow, GameResult::Running));
+    }
+
+    // Atualizacoes aleatorias com poucos scores distintos (muitos empates), comparadas com contagem direta.
+    void randomUpdatesMatchBruteForce() {
+        std::mt19937 rng(7);
+        Leaderboard board;
+        std::unordered_map<std::string, int> expected;
+
+        for (int i = 0; i < 2000; ++i) {
+            std::string team = "t" + std::to_string(rng() % 60);
+            int score = static_cast<int>(rng() % 12) * 1000;
+            board.update(team, score);
+            expected[team] = score;
+
+            if (i % 100 != 0) continue;
+            for (const auto& [name, own] : expected) {
+                int above = 0;
+                for (const auto& [other, s] : expected) above += s > own ? 1 : 0;
+                CHECK(board.rankOf(name) == above + 1);
+            }
+            checkConsistent(board);
+        }
+    }
+}
+
+int main() {
+    tiesShareRank();
+    updatesMoveTeams();
+    scoreTiersOrderOutcomes();
+    randomUpdatesMatchBruteForce();
+    return Test::failures() == 0 ? 0 : 1;
+}
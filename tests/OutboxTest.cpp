@@ -0,0 +1,108 @@
+#include "Check.hpp"
+
+#include "../src/server/Outbox.hpp"
+
+#include <format>
+#include <string>
+#include <vector>
+
+using namespace FindTheBug;
+
+namespace {
+
+    bool isPing(const std::string& frame) {
+        return frame.find("\"PING\"") != std::string::npos;
+    }
+
+    bool isResync(const std::string& frame) {
+        return frame == "{\"type\":\"RESYNC_REQUIRED\"}";
+    }
+
+    OutboundMessage payload(size_t i, size_t size) {
+        auto text = std::format("{{\"type\":\"DATA\",\"i\":{},\"pad\":\"", i);
+        text.append(size - text.size() - 2, 'x');
+        text += "\"}";
+        return std::make_shared<const std::string>(std::move(text));
+    }
+
+    // Cliente que recebe os frames mas so responde os PING quando mandado.
+    struct Consumer {
+        std::vector<std::string> frames;
+        size_t answered{ 0 };
+        Outbox outbox{ [this](const std::string& frame, WireFormat) { frames.push_back(frame); } };
+
+        void answerPings() {
+            size_t pings = 0;
+            for (const auto& f : frames) pings += isPing(f) ? 1 : 0;
+            for (; answered < pings; ++answered) outbox.acknowledge();
+        }
+    };
+
+    // Consumidor parado: o que passa do limite em voo fica na fila, a fila estoura e, quando ele volta,
+    // a primeira coisa depois do que ja estava em voo e o RESYNC_REQUIRED.
+    void stalledConsumerGetsResync() {
+        constexpr size_t kSize = 8 << 10;
+        Consumer c;
+
+        size_t i = 0;
+        while (c.outbox.inFlightBytes() < Outbox::kMaxInFlightBytes) c.outbox.enqueue(payload(i++, kSize), WireFormat::Json, {});
+        size_t sentWhileStalled = c.frames.size();
+        CHECK(c.outbox.inFlightBytes() < Outbox::kMaxInFlightBytes + 2 * kSize);
+
+        for (size_t n = 0; n < 2 * Outbox::kMaxQueuedBytes / kSize; ++n) c.outbox.enqueue(payload(i++, kSize), WireFormat::Json, {});
+        CHECK(c.frames.size() == sentWhileStalled);
+        CHECK(c.outbox.queuedBytes() <= Outbox::kMaxQueuedBytes + kSize);
+
+        bool resynced = false;
+        for (int round = 0; round < 64 && !resynced; ++round) {
+            c.answerPings();
+            for (size_t f = sentWhileStalled; f < c.frames.size(); ++f) resynced = resynced || isResync(c.frames[f]);
+        }
+        CHECK(resynced);
+
+        // O atraso descartado nao chega: depois do RESYNC so vem o que entrou depois dele.
+        CHECK(c.frames.size() - sentWhileStalled < Outbox::kMaxQueuedBytes / kSize + 16);
+    }
+
+    // Com a fila parada o coalescing vale: estados sucessivos da mesma chave ocupam uma entrada so.
+    void stalledQueueCoalesces() {
+        constexpr size_t kSize = 8 << 10;
+        Consumer c;
+
+        size_t i = 0;
+        while (c.outbox.inFlightBytes() < Outbox::kMaxInFlightBytes) c.outbox.enqueue(payload(i++, kSize), WireFormat::Json, {});
+        size_t queuedBefore = c.outbox.queuedBytes();
+
+        for (int n = 0; n < 100; ++n) c.outbox.enqueue(payload(i++, 512), WireFormat::Json, "STATE");
+        CHECK(c.outbox.queuedBytes() == queuedBefore + 512);
+    }
+
+    // Consumidor em dia (responde cada PING ao recebe-lo): tudo sai, nada e descartado.
+    void responsiveConsumerNeverResyncs() {
+        std::vector<std::string> frames;
+        Outbox* self = nullptr;
+        Outbox outbox([&](const std::string& frame, WireFormat) {
+            frames.push_back(frame);
+            if (isPing(frame)) self->acknowledge();
+        });
+        self = &outbox;
+
+        constexpr size_t kCount = 4 * Outbox::kMaxQueuedBytes / (8 << 10);
+        for (size_t i = 0; i < kCount; ++i) outbox.enqueue(payload(i, 8 << 10), WireFormat::Json, {});
+
+        size_t data = 0;
+        for (const auto& f : frames) {
+            CHECK(!isResync(f));
+            data += isPing(f) ? 0 : 1;
+        }
+        CHECK(data == kCount);
+        CHECK(outbox.queuedBytes() == 0);
+    }
+}
+
+int main() {
+    stalledConsumerGetsResync();
+    stalledQueueCoalesces();
+    responsiveConsumerNeverResyncs();
+    return Test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "Check.hpp"
+
+#include "../src/engine/SharedNote.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace FindTheBug;
+
+namespace {
+
+    NoteOp insert(std::string replica, int64_t counter, std::string text, int64_t refCounter = 0, std::string refReplica = {}) {
+        return { .replica = std::move(replica), .counter = counter, .text = std::move(text),
+            .refCounter = refCounter, .refReplica = std::move(refReplica) };
+    }
+
+    NoteOp remove(int64_t refCounter, std::string refReplica, int32_t count) {
+        return { .refCounter = refCounter, .refReplica = std::move(refReplica), .removeCount = count };
+    }
+
+    std::string replayText(std::vector<NoteOp> ops) {
+        return SharedNote::replay(ops).text();
+    }
+
+    // Dois autores inserindo na mesma referencia: o id maior fica a esquerda, nas duas ordens de chegada.
+    void concurrentInsertsAtSameReference() {
+        auto a = insert("ana", 1, "he");
+        auto tail = insert("ana", 3, "llo", 2, "ana");
+        auto x = insert("bia", 3, "X", 2, "ana");
+
+        CHECK(replayText({ a, tail, x }) == "heXllo");
+        CHECK(replayText({ a, x, tail }) == "heXllo");
+
+        auto first = insert("ana", 1, "A");
+        auto second = insert("bia", 1, "B");
+        CHECK(replayText({ first, second }) == "BA");
+        CHECK(replayText({ second, first }) == "BA");
+    }
+
+    // Remocao vira lapide: o texto some, mas o id continua servindo de referencia para insercoes.
+    void tombstonesKeepReferences() {
+        auto base = insert("ana", 1, "abcd");
+        auto cut = remove(2, "ana", 2);
+        auto after = insert("bia", 5, "X", 3, "ana");
+
+        auto note = SharedNote::replay(std::vector<NoteOp>{ base, cut, after });
+        CHECK(note.text() == "aXd");
+        CHECK(note.length() == 3);
+
+        CHECK(replayText({ base, after, cut }) == "aXd");
+        // Remocao repetida e idempotente.
+        CHECK(replayText({ base, cut, cut, after }) == "aXd");
+    }
+
+    // Operacao que chega antes da dependencia espera; a que nunca tem a dependencia fica pendente.
+    void pendingDependencies() {
+        auto base = insert("ana", 1, "ab");
+        auto child = insert("bia", 3, "c", 2, "ana");
+        auto cut = remove(3, "bia", 1);
+
+        auto note = SharedNote::replay(std::vector<NoteOp>{ cut, child, base });
+        CHECK(note.text() == "ab");
+        CHECK(note.pendingCount() == 0);
+
+        auto orphan = insert("bia", 10, "z", 9, "caio");
+        note = SharedNote::replay(std::vector<NoteOp>{ base, orphan });
+        CHECK(note.text() == "ab");
+        CHECK(note.pendingCount() == 1);
+
+        // O log compactado carrega a pendente: quando a dependencia chegar ela ainda se aplica.
+        auto compacted = note.compact();
+        compacted.push_back(insert("caio", 9, "y", 2, "ana"));
+        CHECK(replayText(compacted) == "abyz");
+    }
+
+    // Digitacao letra a letra vira uma insercao so; remocoes consecutivas, uma remocao so.
+    void compactionMergesRuns() {
+        std::vector<NoteOp> typed;
+        const std::string word = "debug";
+        for (size_t i = 0; i < word.size(); ++i) {
+            auto id = static_cast<int64_t>(i + 1);
+            typed.push_back(insert("ana", id, word.substr(i, 1), i == 0 ? 0 : id - 1, i == 0 ? "" : "ana"));
+        }
+        typed.push_back(remove(2, "ana", 1));
+        typed.push_back(remove(3, "ana", 1));
+
+        auto note = SharedNote::replay(typed);
+        CHECK(note.text() == "dug");
+
+        auto compacted = note.compact();
+        CHECK(compacted.size() == 2);
+        CHECK(compacted[0].text == "debug");
+        CHECK(compacted[1].removeCount == 2);
+        CHECK(replayText(compacted) == "dug");
+    }
+
+    // Log aleatorio de tres autores: qualquer ordem de chegada converge, e o log compactado reproduz o texto.
+    void shuffledLogsConvergeAndCompact() {
+        std::mt19937 rng(2024);
+        const std::vector<std::string> authors = { "ana", "bia", "caio" };
+        const std::string alphabet = "abcdefghij";
+
+        std::vector<NoteOp> log;
+        std::vector<std::pair<int64_t, std::string>> ids;
+        int64_t counter = 0;
+        for (int i = 0; i < 300; ++i) {
+            const auto& author = authors[rng() % authors.size()];
+            if (!ids.empty() && rng() % 4 == 0) {
+                auto [id, replica] = ids[rng() % ids.size()];
+                log.push_back(remove(id, replica, 1));
+                continue;
+            }
+
+            int64_t refCounter = 0;
+            std::string refReplica;
+            if (!ids.empty() && rng() % 8 != 0) std::tie(refCounter, refReplica) = ids[rng() % ids.size()];
+
+            std::string text(1 + rng() % 3, alphabet[rng() % alphabet.size()]);
+            counter = std::max(counter, refCounter) + 1;
+            log.push_back(insert(author, counter, text, refCounter, refReplica));
+            for (size_t k = 0; k < text.size(); ++k) ids.emplace_back(counter + static_cast<int64_t>(k), author);
+            counter += static_cast<int64_t>(text.size()) - 1;
+        }
+
+        auto reference = SharedNote::replay(log);
+        CHECK(reference.pendingCount() == 0);
+        CHECK(!reference.text().empty());
+
+        for (int round = 0; round < 50; ++round) {
+            auto shuffled = log;
+            std::shuffle(shuffled.begin(), shuffled.end(), rng);
+            auto note = SharedNote::replay(shuffled);
+            CHECK(note.pendingCount() == 0);
+            CHECK(note.text() == reference.text());
+        }
+
+        auto compacted = reference.compact();
+        auto rebuilt = SharedNote::replay(compacted);
+        CHECK(rebuilt.text() == reference.text());
+        CHECK(rebuilt.length() == reference.length());
+
+        // Edicoes posteriores a compactacao se aplicam igual sobre o log original e o compactado.
+        auto later = insert("bia", counter + 1, "Z", ids.back().first, ids.back().second);
+        log.push_back(later);
+        compacted.push_back(later);
+        CHECK(replayText(compacted) == replayText(log));
+    }
+}
+
+int main() {
+    concurrentInsertsAtSameReference();
+    tombstonesKeepReferences();
+    pendingDependencies();
+    compactionMergesRuns();
+    shuffledLogsConvergeAndCompact();
+    return Test::failures() == 0 ? 0 : 1;
+}
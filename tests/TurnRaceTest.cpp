@@ -0,0 +1,162 @@
+#include "Check.hpp"
+
+#include "../src/engine/GameEngine.hpp"
+#include "../src/storage/MemoryStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace FindTheBug;
+
+namespace {
+
+    const std::string kSession = "race";
+
+    struct Fixture {
+        std::shared_ptr<MemoryStore> store = std::make_shared<MemoryStore>();
+        GameEngine engine{ store };
+
+        Fixture() {
+            BugCase bc;
+            bc.id = "case";
+            bc.systemTopology.modules.push_back({ .name = "mod" });
+            bc.availableClues.push_back({
+                .id = "mod_doc", .targetId = "mod", .targetType = TargetType::Module,
+                .type = ClueType::Documentation, .content = "doc", .cost = 1 });
+            store->putCase(bc);
+            CHECK(engine.initializeGameFromLobby(kSession, "case", { "host", "ana", "bia", "mestre" }, "host", "mestre"));
+        }
+
+        std::string currentPlayer() const {
+            auto state = store->getGameState(kSession);
+            return state->turnOrder[state->currentTurnIndex];
+        }
+    };
+
+    // O prazo leu o turno, uma acao passou a vez antes da escrita: o skip nao pode pular o jogador seguinte
+    // nem gerar um segundo estado com a mesma revisao.
+    void skipAfterActionIsRejected() {
+        Fixture f;
+        auto deadlineRead = f.store->getGameState(kSession);
+
+        auto action = f.engine.processAction(f.currentPlayer(), ActionType::InsertLog, "mod", kSession);
+        CHECK(action.success);
+        CHECK(action.newState.currentTurnIndex == 1);
+
+        auto skipped = f.store->skipTurn(kSession, deadlineRead->currentTurnIndex, deadlineRead->turnStartTime,
+            std::chrono::system_clock::now());
+        CHECK(!skipped.has_value());
+
+        auto state = f.store->getGameState(kSession);
+        CHECK(state->currentTurnIndex == 1);
+        CHECK(state->revision == action.newState.revision);
+    }
+
+    // Prazo e acoes disputando a vez em threads: cada estado gravado tem revisao propria e crescente.
+    void concurrentSkipsAndActionsGetDistinctRevisions() {
+        Fixture f;
+        std::mutex mutex;
+        std::vector<int64_t> revisions;
+        auto record = [&](int64_t revision) {
+            std::lock_guard lock(mutex);
+            revisions.push_back(revision);
+        };
+
+        std::thread actions([&] {
+            for (int i = 0; i < 2000; ++i) {
+                auto result = f.engine.processAction(f.currentPlayer(), ActionType::SkipTurn, "", kSession);
+                if (result.success) record(result.newState.revision);
+            }
+        });
+        std::thread deadlines([&] {
+            for (int i = 0; i < 2000; ++i) {
+                auto read = f.store->getGameState(kSession);
+                auto skipped = f.store->skipTurn(kSession, read->currentTurnIndex, read->turnStartTime, std::chrono::system_clock::now());
+                if (skipped) record(skipped->revision);
+            }
+        });
+        actions.join();
+        deadlines.join();
+
+        std::sort(revisions.begin(), revisions.end());
+        CHECK(!revisions.empty());
+        CHECK(std::adjacent_find(revisions.begin(), revisions.end()) == revisions.end());
+        CHECK(f.store->getGameState(kSession)->revision == revisions.back());
+    }
+
+    // Gravacao de fim de jogo com uma nota entrando entre a leitura e a escrita: a nota fica.
+    void sessionUpdateKeepsConcurrentNote() {
+        Fixture f;
+        auto action = f.engine.processAction(f.currentPlayer(), ActionType::ReadDocumentation, "mod", kSession);
+        CHECK(action.success && action.revealedClue);
+
+        auto read = f.store->getGameState(kSession);
+        CHECK(f.engine.savePlayerNote(kSession, "bia", "mod_doc", "suspeito").success);
+
+        read->currentDay = 3;
+        CHECK(!f.store->updateSession(*read, read->revision).has_value());
+        CHECK(f.engine.finalizeSession(kSession, false).outcome == GameResult::Running);
+
+        auto state = f.store->getGameState(kSession);
+        CHECK(state->currentDay == 3);
+        CHECK(state->discoveredClues.size() == 1);
+        CHECK(state->discoveredClues[0].playerNotes.contains("bia"));
+    }
+
+    // Lote com acao, nota sobre a pista recem-revelada e acao fora da vez: uma gravacao so, resultados na ordem.
+    void batchWritesOnce() {
+        Fixture f;
+        int64_t before = f.store->getGameState(kSession)->revision;
+        std::string first = f.currentPlayer();
+
+        std::vector<Command> commands = {
+            { .playerId = first, .actionType = ActionType::ReadDocumentation, .targetId = "mod" },
+            { .kind = CommandKind::SaveNote, .playerId = "bia", .clueId = "mod_doc", .content = "suspeito" },
+            { .playerId = first, .actionType = ActionType::InsertLog, .targetId = "mod" },
+        };
+        auto batch = f.engine.processActions(kSession, commands);
+
+        CHECK(batch.success);
+        CHECK(batch.results.size() == 3);
+        CHECK(batch.results[0].success && batch.results[0].revealedClue);
+        CHECK(batch.results[1].success);
+        CHECK(!batch.results[2].success);
+        CHECK(batch.newState.revision == before + 1);
+
+        auto state = f.store->getGameState(kSession);
+        CHECK(state->revision == before + 1);
+        CHECK(state->discoveredClues.size() == 1);
+        CHECK(state->discoveredClues[0].playerNotes.contains("bia"));
+    }
+
+    // Recusas seguidas passam do limite de dias: a morte subita e gravada e a recusa seguinte encerra a partida.
+    void rejectionsEndInSuddenDeath() {
+        Fixture f;
+        FinalizeResult result;
+        int rejections = 0;
+        do {
+            result = f.engine.finalizeSession(kSession, false);
+            CHECK(result.newState.has_value());
+            ++rejections;
+        } while (result.outcome == GameResult::Running && !result.newState->isSuddenDeath && rejections < 32);
+
+        CHECK(result.outcome == GameResult::Running);
+        CHECK(f.store->getGameState(kSession)->isSuddenDeath);
+
+        result = f.engine.finalizeSession(kSession, false);
+        CHECK(result.outcome == GameResult::Defeat);
+        CHECK(result.newState && result.newState->isCompleted);
+    }
+}
+
+int main() {
+    skipAfterActionIsRejected();
+    concurrentSkipsAndActionsGetDistinctRevisions();
+    sessionUpdateKeepsConcurrentNote();
+    batchWritesOnce();
+    rejectionsEndInSuddenDeath();
+    return Test::failures() == 0 ? 0 : 1;
+}